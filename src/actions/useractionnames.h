@@ -60,6 +60,7 @@
 #define ACT_AUTOMATIC_DURATIONS "automatic_durations"
 #define ACT_MAXIMIZE_DURATIONS "maximize_durations"
 #define ACT_FIX_OVERLAPPING_LINES "fix_overlapping_lines"
+#define ACT_SNAP_TO_SPEECH "snap_to_speech"
 #define ACT_SYNC_WITH_SUBTITLE "sync_with_subtitle"
 #define ACT_ADJUST_TEXTS "adjust_texts"
 #define ACT_UNBREAK_TEXTS "unbreak_texts"
@@ -28,6 +28,7 @@
 #include "dialogs/fixoverlappingtimesdialog.h"
 #include "dialogs/fixpunctuationdialog.h"
 #include "dialogs/smarttextsadjustdialog.h"
+#include "dialogs/snaptospeechdialog.h"
 #include "dialogs/changeframeratedialog.h"
 #include "dialogs/insertlinedialog.h"
 #include "dialogs/removelinesdialog.h"
@@ -49,6 +50,7 @@
 #include "utils/speller.h"
 #include "videoplayer/videoplayer.h"
 #include "gui/waveform/waveformwidget.h"
+#include "gui/waveform/wavespeechboundaries.h"
 
 #include <limits>
 
@@ -681,6 +683,24 @@ Application::fixOverlappingLines()
 		appSubtitle()->fixOverlappingLines(m_mainWindow->m_linesWidget->targetRanges(dlg->selectedLinesTarget()), dlg->minimumInterval());
 }
 
+void
+Application::snapToSpeech()
+{
+	static SnapToSpeechDialog *dlg = new SnapToSpeechDialog(m_mainWindow);
+
+	if(dlg->exec() != QDialog::Accepted)
+		return;
+
+	WaveSpeechBoundaries boundaries;
+	if(!m_mainWindow->m_waveformWidget->analyzeSpeech(&boundaries)) {
+		KMessageBox::error(m_mainWindow, i18n("Audio waveform is not available."));
+		return;
+	}
+
+	appSubtitle()->snapTimes(m_mainWindow->m_linesWidget->targetRanges(dlg->selectedLinesTarget()),
+		boundaries.onsets(), boundaries.offsets(), dlg->maximumDistance());
+}
+
 void
 Application::breakLines()
 {
@@ -153,6 +153,7 @@ public slots:
 	void setAutoDurations();
 	void maximizeDurations();
 	void fixOverlappingLines();
+	void snapToSpeech();
 	void syncWithSubtitle();
 
 	void breakLines();
@@ -453,6 +453,13 @@ Application::setupActions()
 	actionCollection->addAction(ACT_FIX_OVERLAPPING_LINES, fixOverlappingLinesAction);
 	actionManager->addAction(fixOverlappingLinesAction, UserAction::SubHasLine | UserAction::FullScreenOff);
 
+	QAction *snapToSpeechAction = new QAction(actionCollection);
+	snapToSpeechAction->setText(i18n("Snap Times to Speech..."));
+	snapToSpeechAction->setStatusTip(i18n("Move lines show and hide times to nearest start and end of speech in the audio waveform"));
+	connect(snapToSpeechAction, &QAction::triggered, this, &Application::snapToSpeech);
+	actionCollection->addAction(ACT_SNAP_TO_SPEECH, snapToSpeechAction);
+	actionManager->addAction(snapToSpeechAction, UserAction::SubHasLine | UserAction::VideoOpened | UserAction::FullScreenOff);
+
 	QAction *syncWithSubtitleAction = new QAction(actionCollection);
 	syncWithSubtitleAction->setText(i18n("Synchronize with Subtitle..."));
 	syncWithSubtitleAction->setStatusTip(i18n("Copy timing information from another subtitle"));
@@ -16,6 +16,7 @@
 #include <QStringList>
 #include <QVector>
 
+#include <algorithm>
 #include <type_traits>
 
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
@@ -61,6 +62,12 @@ public:
 			&& (klass() == other.klass());
 	}
 	inline bool operator!=(const RichStyle &other) { return !operator==(other); }
+	/**
+	 * @brief Compares all members, even the ones that operator==() ignores
+	 */
+	inline bool isSame(const RichStyle &other) const {
+		return m_flags == other.m_flags && m_color == other.m_color && m_class == other.m_class && m_voice == other.m_voice;
+	}
 
 private:
 	RichString::StyleFlags m_flags;
@@ -76,16 +83,21 @@ class RichStringStyle {
 	friend QDataStream & ::operator>>(QDataStream &stream, SubtitleComposer::RichString &string);
 
 public:
+	/**
+	 * @brief Characters [offset, offset + length) that share the same style
+	 */
+	struct StyleRun {
+		int offset;
+		int length;
+		RichStyle style;
+	};
+
 	RichStringStyle(int len);
 	RichStringStyle(int len, quint8 styleFlags, QRgb styleColor, const QString &klass, const QString &voice);
 	RichStringStyle(int len, quint8 styleFlags, QRgb styleColor, const QSet<QString> &classList, const QString &voice);
-	RichStringStyle(const RichStringStyle &other);
-	~RichStringStyle();
 
 	void clear();
 
-	RichStringStyle & operator=(const RichStringStyle &other);
-
 	qint32 voiceIndex(const QString &name);
 	qint32 classIndex(const QString &name);
 
@@ -94,8 +106,17 @@ public:
 	inline QString className(int index) const { return m_classList.at(index); }
 	inline int classCount() const { return m_classList.size(); }
 
-	inline RichStyle * operator[](int index) { Q_ASSERT(index >= 0 && index < m_length); return &m_style[index]; }
-	inline const RichStyle & at(int index) const { return index >= 0 && index < m_length ? m_style[index] : RichStyle::s_null; }
+	inline const RichStyle & at(int index) const { return index >= 0 && index < m_length ? m_runs.at(runIndex(index)).style : RichStyle::s_null; }
+	/**
+	 * @brief Sorted runs that cover all characters, neighbouring runs have different styles
+	 */
+	inline const QVector<StyleRun> & runs() const { return m_runs; }
+
+	/**
+	 * @brief Call fn(RichStyle &) to modify style of len characters at index
+	 */
+	template<class Fn>
+	void update(int index, int len, Fn fn);
 
 	/**
 	 * @brief Insert invalid style for len characters at index
@@ -104,6 +125,10 @@ public:
 	 * @param len
 	 */
 	inline void insert(int index, int len) { replace(index, 0, len); }
+	/**
+	 * @brief Append len characters with style
+	 */
+	void append(int len, const RichStyle &style);
 	/**
 	 * @brief Remove style for len characters at index and insert invalid style for newLen characters
 	 *        Use fill() or copy() to update invalid characters.
@@ -112,7 +137,7 @@ public:
 	 */
 	void replace(int index, int len, int newLen);
 
-	inline void fill(int index, int len, const RichStyle &style);
+	void fill(int index, int len, const RichStyle &style);
 	void copy(int index, int len, const RichStringStyle &src, int srcOffset=0);
 
 	void swap(RichStringStyle &other, bool swapLists);
@@ -122,17 +147,17 @@ public:
 	inline void richText(QString &out, int prevIndex, int curIndex, bool opening);
 
 private:
-	void detach();
-	void updateCapacity();
+	int runIndex(int index) const;
+	int splitAt(int index);
+	void setRuns(int first, int last, const StyleRun *runs, int count);
+	void mergeRuns(int first, int last);
 
 private:
 	QVector<QString> m_classList;
 	QVector<QString> m_voiceList;
-	RichStyle *m_style;
+	QVector<StyleRun> m_runs;
 	int m_length;
-	int m_capacity;
 };
-
 struct ReplaceHelper {
 	struct BackRef {
 		int start;
@@ -155,44 +180,150 @@ struct ReplaceHelper {
 	template<class T>
 	static void replace(const MatchRefList &matchList, RichString &str, const T &replacement);
 };
+
+/**
+ * @brief Finds tags, entities and newlines of rich text in a single pass
+ *        Matches are the same as the ones of regular expression
+ *        (<(/?(v |c\.?|\w+))([^>]*\bcolor="?([\w#]+)"?|[^>]+)?[^>]*?>|&([^;]+);|\n)
+ */
+class RichTagTokenizer {
+public:
+	struct Token {
+		int start;
+		int end;
+		bool closing;
+		QStringView_ tag;
+		QStringView_ attributes;
+		QStringView_ color;
+		QStringView_ entity;
+	};
+
+	explicit RichTagTokenizer(const QStringView_ &string) : m_string(string), m_pos(0) {}
+
+	bool next(Token *token);
+
+	/**
+	 * @brief Color of the style="color:..." tag attribute
+	 */
+	static QStringView_ styleColor(const QStringView_ &attributes);
+
+private:
+	bool tagAt(int pos, Token *token) const;
+
+private:
+	const QStringView_ m_string;
+	int m_pos;
+};
 }
 
-void
-RichStringStyle::replace(int index, int lenRemove, int lenAdd)
+int
+RichStringStyle::runIndex(int index) const
 {
-	Q_ASSERT(index + lenRemove <= m_length);
-	const int tailLength = m_length - index - lenRemove;
+	Q_ASSERT(index >= 0 && index < m_length);
+	const auto it = std::upper_bound(m_runs.cbegin(), m_runs.cend(), index, [](int i, const StyleRun &run){ return i < run.offset; });
+	return int(it - m_runs.cbegin()) - 1;
+}
 
-	RichStyle *oldStyle = m_style;
+int
+RichStringStyle::splitAt(int index)
+{
+	if(index >= m_length)
+		return m_runs.size();
+	const int i = runIndex(index);
+	StyleRun &run = m_runs[i];
+	if(run.offset == index)
+		return i;
+	const StyleRun tail{index, run.offset + run.length - index, run.style};
+	run.length = index - run.offset;
+	m_runs.insert(i + 1, tail);
+	return i + 1;
+}
 
-	detach();
-	m_length += lenAdd - lenRemove;
-	updateCapacity();
+void
+RichStringStyle::setRuns(int first, int last, const StyleRun *runs, int count)
+{
+	const int diff = count - (last - first);
+	if(diff > 0)
+		m_runs.insert(last, diff, StyleRun());
+	else if(diff < 0)
+		m_runs.erase(m_runs.begin() + first + count, m_runs.begin() + last);
+	std::copy(runs, runs + count, m_runs.begin() + first);
+}
 
-	if(index) {
-		// restore data before inserted part
-		memcpy(m_style, oldStyle, index * sizeof(*m_style));
-	}
-	if(tailLength) {
-		// restore data after inserted part
-		const int tailStart = index + lenAdd;
-		const int tailStartOld = index + lenRemove;
-		memcpy(m_style + tailStart, oldStyle + tailStartOld, tailLength * sizeof(*m_style));
+void
+RichStringStyle::mergeRuns(int first, int last)
+{
+	first = qMax(0, first);
+	last = qMin(last, m_runs.size() - 1);
+	if(first >= last)
+		return;
+	int w = first;
+	for(int r = first + 1; r <= last; r++) {
+		if(m_runs.at(w).style.isSame(m_runs.at(r).style))
+			m_runs[w].length += m_runs.at(r).length;
+		else if(++w != r)
+			m_runs[w] = m_runs.at(r);
 	}
+	if(++w <= last)
+		m_runs.erase(m_runs.begin() + w, m_runs.begin() + last + 1);
+}
 
-	delete[] oldStyle;
+template<class Fn>
+void
+RichStringStyle::update(int index, int len, Fn fn)
+{
+	Q_ASSERT(index >= 0 && index + len <= m_length);
+	if(len <= 0)
+		return;
+	const int first = splitAt(index);
+	const int last = splitAt(index + len);
+	for(int i = first; i < last; i++)
+		fn(m_runs[i].style);
+	mergeRuns(first - 1, last);
 }
 
-inline void
+void
+RichStringStyle::replace(int index, int lenRemove, int lenAdd)
+{
+	Q_ASSERT(index >= 0 && index + lenRemove <= m_length);
+	const int first = splitAt(index);
+	const int last = splitAt(index + lenRemove);
+	const StyleRun added{index, lenAdd, RichStyle::s_null};
+	setRuns(first, last, &added, lenAdd ? 1 : 0);
+
+	const int diff = lenAdd - lenRemove;
+	m_length += diff;
+	if(diff) {
+		for(auto it = m_runs.begin() + first + (lenAdd ? 1 : 0); it != m_runs.end(); ++it)
+			it->offset += diff;
+	}
+	// inserted run has plain style until fill() or copy() - it can equal its neighbours too
+	mergeRuns(first - 1, lenAdd ? first + 1 : first);
+}
+
+void
 RichStringStyle::fill(int index, int len, const RichStyle &style)
 {
 	Q_ASSERT(index + len <= m_length);
-	if(len) {
-		RichStyle *s = m_style + index;
-		const RichStyle *e = s + len;
-		while(s != e)
-			*s++ = style;
-	}
+	if(len <= 0)
+		return;
+	const int first = splitAt(index);
+	const int last = splitAt(index + len);
+	const StyleRun run{index, len, style};
+	setRuns(first, last, &run, 1);
+	mergeRuns(first - 1, first + 1);
+}
+
+void
+RichStringStyle::append(int len, const RichStyle &style)
+{
+	if(len <= 0)
+		return;
+	if(!m_runs.isEmpty() && m_runs.last().style.isSame(style))
+		m_runs.last().length += len;
+	else
+		m_runs.push_back(StyleRun{m_length, len, style});
+	m_length += len;
 }
 
 void
@@ -202,38 +333,55 @@ RichStringStyle::copy(int index, int len, const RichStringStyle &src, int srcOff
 	if(len <= 0)
 		return;
 
+	QVector<StyleRun> runs;
+	const int srcEnd = srcOffset + len;
+	for(int i = src.runIndex(srcOffset); i < src.m_runs.size(); i++) {
+		const StyleRun &run = src.m_runs.at(i);
+		if(run.offset >= srcEnd)
+			break;
+		const int start = qMax(run.offset, srcOffset);
+		runs.push_back(StyleRun{index + start - srcOffset, qMin(run.offset + run.length, srcEnd) - start, run.style});
+	}
+
 	if(index == 0 && len == m_length) {
 		// overwrite everything
 		m_voiceList = src.m_voiceList;
 		m_classList = src.m_classList;
-		memcpy(m_style, src.m_style + srcOffset, len * sizeof(*m_style));
+		m_runs = runs;
 		return;
 	}
 
-	// merge styles
-	const int nc = src.m_classList.size();
-	int *classMap = new int[nc];
-	for(int i = 0; i < nc; i++)
-		classMap[i] = classIndex(src.m_classList[i]);
-	const int nv = src.m_voiceList.size();
-	int *voiceMap = new int[nv];
-	for(int i = 0; i < nv; i++)
-		voiceMap[i] = voiceIndex(src.m_voiceList[i]);
-	for(int i = 0; i < len; i++) {
-		const RichStyle &ss = src.m_style[srcOffset + i];
-		quint64 klass = 0;
-		for(int ci = 0; ci < nc; ci++) {
-			if(classMap[ci] < 0)
-				continue;
-			if(ss.klass() & (1ULL << ci))
-				klass |= 1ULL << quint32(classMap[ci]);
+	if(&src != this) {
+		// merge styles
+		const int nc = src.m_classList.size();
+		int *classMap = new int[nc];
+		for(int i = 0; i < nc; i++)
+			classMap[i] = classIndex(src.m_classList[i]);
+		const int nv = src.m_voiceList.size();
+		int *voiceMap = new int[nv];
+		for(int i = 0; i < nv; i++)
+			voiceMap[i] = voiceIndex(src.m_voiceList[i]);
+		for(StyleRun &run: runs) {
+			const RichStyle &ss = run.style;
+			quint64 klass = 0;
+			for(int ci = 0; ci < nc; ci++) {
+				if(classMap[ci] < 0)
+					continue;
+				if(ss.klass() & (1ULL << ci))
+					klass |= 1ULL << quint32(classMap[ci]);
+			}
+			Q_ASSERT(ss.voice() < nv);
+			qint32 voice = ss.voice() < 0 ? -1 : voiceMap[ss.voice()];
+			run.style = RichStyle(ss.flags(), ss.color(), klass, voice);
 		}
-		Q_ASSERT(ss.voice() < nv);
-		qint32 voice = ss.voice() < 0 ? -1 : voiceMap[ss.voice()];
-		m_style[index + i] = RichStyle(ss.flags(), ss.color(), klass, voice);
+		delete[] voiceMap;
+		delete[] classMap;
 	}
-	delete[] voiceMap;
-	delete[] classMap;
+
+	const int first = splitAt(index);
+	const int last = splitAt(index + len);
+	setRuns(first, last, runs.constData(), runs.size());
+	mergeRuns(first - 1, first + runs.size());
 }
 
 void
@@ -242,8 +390,8 @@ RichStringStyle::removeUnused()
 	const int nv = m_voiceList.size();
 	int *voiceMap = new int[nv]();
 	int voiceUsed = 0;
-	for(int i = 0; i < m_length; i++) {
-		const qint32 v = m_style[i].voice();
+	for(StyleRun &run: m_runs) {
+		const qint32 v = run.style.voice();
 		if(v >= 0) {
 			if(!voiceMap[v]) {
 #if QT_VERSION < QT_VERSION_CHECK(5, 14, 0)
@@ -254,7 +402,7 @@ RichStringStyle::removeUnused()
 #endif
 				voiceMap[v] = ++voiceUsed;
 			}
-			m_style[i].voice() = voiceMap[v] - 1;
+			run.style.voice() = voiceMap[v] - 1;
 		}
 	}
 	m_voiceList.resize(voiceUsed);
@@ -263,16 +411,17 @@ RichStringStyle::removeUnused()
 	int *classMap = new int[nc]();
 	int classUsed = 0;
 	quint64 prevClass = 0;
-	for(int i = 0; i < m_length; i++) {
-		quint64 c = m_style[i].klass();
+	quint64 prevMapped = 0;
+	for(StyleRun &run: m_runs) {
+		quint64 c = run.style.klass();
 		if(!c)
 			continue;
-		if(i && c == prevClass) {
-			m_style[i].klass() = m_style[i - 1].klass();
+		if(c == prevClass) {
+			run.style.klass() = prevMapped;
 			continue;
 		}
 		prevClass = c;
-		m_style[i].klass() = 0;
+		run.style.klass() = 0;
 		for(int k = 0; c; k++, c >>= 1) {
 			if(!(c & 1))
 				continue;
@@ -285,8 +434,9 @@ RichStringStyle::removeUnused()
 #endif
 				classMap[k] = ++classUsed;
 			}
-			m_style[i].klass() |= 1ULL << (classMap[k] - 1);
+			run.style.klass() |= 1ULL << (classMap[k] - 1);
 		}
+		prevMapped = run.style.klass();
 	}
 	m_classList.resize(classUsed);
 
@@ -295,33 +445,25 @@ RichStringStyle::removeUnused()
 }
 
 RichStringStyle::RichStringStyle(int len)
-	: m_style(nullptr),
-	  m_length(len),
-	  m_capacity(0)
+	: m_length(len)
 {
 	if(m_length)
-		updateCapacity();
+		m_runs.push_back(StyleRun{0, m_length, RichStyle::s_null});
 }
 
 RichStringStyle::RichStringStyle(int len, quint8 styleFlags, QRgb styleColor, const QString &klass, const QString &voice)
-	: m_style(nullptr),
-	  m_length(len),
-	  m_capacity(0)
+	: m_length(len)
 {
 	if(!klass.isEmpty())
 		m_classList.append(klass);
 	if(!voice.isEmpty())
 		m_voiceList.append(voice);
-	if(m_length) {
-		updateCapacity();
-		fill(0, m_length, RichStyle(quint8(styleFlags & RichString::AllStyles), styleColor, m_classList.size(), m_voiceList.size() - 1));
-	}
+	if(m_length)
+		m_runs.push_back(StyleRun{0, m_length, RichStyle(quint8(styleFlags & RichString::AllStyles), styleColor, m_classList.size(), m_voiceList.size() - 1)});
 }
 
 RichStringStyle::RichStringStyle(int len, quint8 styleFlags, QRgb styleColor, const QSet<QString> &classList, const QString &voice)
-	: m_style(nullptr),
-	  m_length(len),
-	  m_capacity(0)
+	: m_length(len)
 {
 	quint64 classMap = 0;
 	for(const QString &klass: classList) {
@@ -331,28 +473,8 @@ RichStringStyle::RichStringStyle(int len, quint8 styleFlags, QRgb styleColor, co
 	}
 	if(!voice.isEmpty())
 		m_voiceList.append(voice);
-	if(m_length) {
-		updateCapacity();
-		fill(0, m_length, RichStyle(quint8(styleFlags & RichString::AllStyles), styleColor, classMap, m_voiceList.size() - 1));
-	}
-}
-
-RichStringStyle::RichStringStyle(const RichStringStyle &other)
-	: m_classList(other.m_classList),
-	  m_voiceList(other.m_voiceList),
-	  m_style(nullptr),
-	  m_length(other.m_length),
-	  m_capacity(0)
-{
-	if(m_length) {
-		updateCapacity();
-		memcpy(m_style, other.m_style, m_length * sizeof(*m_style));
-	}
-}
-
-RichStringStyle::~RichStringStyle()
-{
-	delete[] m_style;
+	if(m_length)
+		m_runs.push_back(StyleRun{0, m_length, RichStyle(quint8(styleFlags & RichString::AllStyles), styleColor, classMap, m_voiceList.size() - 1)});
 }
 
 void
@@ -360,20 +482,8 @@ RichStringStyle::clear()
 {
 	m_classList.clear();
 	m_voiceList.clear();
+	m_runs.clear();
 	m_length = 0;
-	updateCapacity();
-}
-
-RichStringStyle &
-RichStringStyle::operator=(const RichStringStyle &other)
-{
-	m_classList = other.m_classList;
-	m_voiceList = other.m_voiceList;
-	m_length = other.m_length;
-	updateCapacity();
-	if(m_length)
-		memcpy(m_style, other.m_style, m_length * sizeof(*m_style));
-	return *this;
 }
 
 qint32
@@ -409,32 +519,8 @@ RichStringStyle::swap(RichStringStyle &other, bool swapLists)
 		qSwap(m_classList, other.m_classList);
 		qSwap(m_voiceList, other.m_voiceList);
 	}
-	qSwap(m_style, other.m_style);
+	qSwap(m_runs, other.m_runs);
 	qSwap(m_length, other.m_length);
-	qSwap(m_capacity, other.m_capacity);
-}
-
-void
-RichStringStyle::detach()
-{
-	m_style = nullptr;
-	m_capacity = 0;
-}
-
-void
-RichStringStyle::updateCapacity()
-{
-	if(m_length > m_capacity)
-		m_capacity = m_length * 2;
-	else if(m_length == 0)
-		m_capacity = 0;
-	else if(m_capacity > 100 && m_length < m_capacity / 2)
-		m_capacity = m_capacity / 2;
-	else if(m_style)
-		return;
-
-	delete[] m_style;
-	m_style = m_capacity ? new RichStyle[m_capacity] : nullptr;
 }
 
 
@@ -493,7 +579,7 @@ RichString::setStyleFlagsAt(int index, StyleFlags styleFlags) const
 {
 	if(index < 0 || index >= length())
 		return;
-	(*m_style)[index]->flags() = styleFlags;
+	m_style->update(index, 1, [styleFlags](RichStyle &s){ s.flags() = styleFlags; });
 }
 
 QRgb
@@ -507,12 +593,13 @@ RichString::setStyleColorAt(int index, QRgb rgbColor) const
 {
 	if(index < 0 || index >= length())
 		return;
-	RichStyle *it = (*m_style)[index];
-	if(rgbColor == 0)
-		it->flags() &= ~RichString::Color;
-	else
-		it->flags() |= RichString::Color;
-	it->color() = rgbColor;
+	m_style->update(index, 1, [rgbColor](RichStyle &s){
+		if(rgbColor == 0)
+			s.flags() &= ~RichString::Color;
+		else
+			s.flags() |= RichString::Color;
+		s.color() = rgbColor;
+	});
 }
 
 QSet<QString>
@@ -536,7 +623,7 @@ RichString::setStyleClassesAt(int index, const QSet<QString> &classes) const
 		if(i >= 0)
 			k |= 1ULL << i;
 	}
-	(*m_style)[index]->klass() = k;
+	m_style->update(index, 1, [k](RichStyle &s){ s.klass() = k; });
 }
 
 QString
@@ -550,14 +637,18 @@ void
 RichString::setStyleVoiceAt(int index, const QString &voice) const
 {
 	const qint32 v = m_style->voiceIndex(voice);
-	(*m_style)[index]->voice() = v;
+	m_style->update(index, 1, [v](RichStyle &s){ s.voice() = v; });
 }
 
 QDataStream &
 operator<<(QDataStream &stream, const RichString &string)
 {
 	stream << static_cast<const QString &>(string);
-	stream.writeRawData(reinterpret_cast<const char *>(string.m_style->m_style), string.length() * sizeof(*string.m_style->m_style));
+	// styles are written per character
+	for(const RichStringStyle::StyleRun &run: qAsConst(string.m_style->m_runs)) {
+		for(int i = 0; i < run.length; i++)
+			stream.writeRawData(reinterpret_cast<const char *>(&run.style), sizeof(run.style));
+	}
 	stream << string.m_style->m_classList;
 	stream << string.m_style->m_voiceList;
 	return stream;
@@ -567,9 +658,17 @@ QDataStream &
 operator>>(QDataStream &stream, RichString &string)
 {
 	stream >> static_cast<QString &>(string);
+	QVector<RichStringStyle::StyleRun> &runs = string.m_style->m_runs;
+	runs.clear();
+	RichStyle style;
+	for(int i = 0, n = string.length(); i < n; i++) {
+		stream.readRawData(reinterpret_cast<char *>(&style), sizeof(style));
+		if(!runs.isEmpty() && runs.last().style.isSame(style))
+			runs.last().length++;
+		else
+			runs.push_back(RichStringStyle::StyleRun{i, 1, style});
+	}
 	string.m_style->m_length = string.length();
-	string.m_style->updateCapacity();
-	stream.readRawData(reinterpret_cast<char *>(string.m_style->m_style), string.length() * sizeof(*string.m_style->m_style));
 	stream >> string.m_style->m_classList;
 	stream >> string.m_style->m_voiceList;
 	return stream;
@@ -691,20 +790,148 @@ RichString::richString() const
 	return ret;
 }
 
+static inline bool
+isWordChar(QChar ch)
+{
+	return ch.isLetterOrNumber() || ch == QLatin1Char('_');
+}
+
+static inline bool
+isColorChar(QChar ch)
+{
+	return isWordChar(ch) || ch == QLatin1Char('#');
+}
+
+/**
+ * @brief Find value of the last "<name><separator>" attribute in [start, end) of str
+ * @return value length, 0 if there's no such attribute
+ */
+static int
+lastAttributeValue(const QStringView_ &str, int start, int end, QLatin1String name, bool quoted, int *valueStart)
+{
+	const int nameLen = name.size();
+	for(int i = end - nameLen - 1; i >= start; i--) {
+		if(str.at(i).toLower() != name.at(0))
+			continue;
+		if(i && isWordChar(str.at(i - 1)))
+			continue;
+		if(str.mid(i, nameLen).compare(name, Qt::CaseInsensitive) != 0)
+			continue;
+		int vs = i + nameLen;
+		if(quoted && vs < end && str.at(vs) == QLatin1Char('"'))
+			vs++;
+		int ve = vs;
+		while(ve < end && isColorChar(str.at(ve)))
+			ve++;
+		if(ve != vs) {
+			*valueStart = vs;
+			return ve - vs;
+		}
+	}
+	return 0;
+}
+
+bool
+RichTagTokenizer::tagAt(int pos, Token *token) const
+{
+	const int len = m_string.size();
+	int p = pos + 1;
+	token->closing = p < len && m_string.at(p) == QLatin1Char('/');
+	if(token->closing)
+		p++;
+
+	int tagEnd = p;
+	if(p + 1 < len && m_string.at(p).toLower() == QLatin1Char('v') && m_string.at(p + 1) == QLatin1Char(' ')) {
+		tagEnd += 2;
+	} else if(p < len && m_string.at(p).toLower() == QLatin1Char('c')) {
+		tagEnd += p + 1 < len && m_string.at(p + 1) == QLatin1Char('.') ? 2 : 1;
+	} else {
+		while(tagEnd < len && isWordChar(m_string.at(tagEnd)))
+			tagEnd++;
+		if(tagEnd == p)
+			return false;
+	}
+
+	const int end = m_string.indexOf(QLatin1Char('>'), tagEnd);
+	if(end == -1)
+		return false;
+
+	token->start = pos;
+	token->end = end + 1;
+	token->tag = m_string.mid(p, tagEnd - p);
+	token->entity = QStringView_();
+
+	int colorStart;
+	if(const int colorLen = lastAttributeValue(m_string, tagEnd, end, QLatin1String("color="), true, &colorStart)) {
+		int attrEnd = colorStart + colorLen;
+		if(attrEnd < end && m_string.at(attrEnd) == QLatin1Char('"'))
+			attrEnd++;
+		token->attributes = m_string.mid(tagEnd, attrEnd - tagEnd);
+		token->color = m_string.mid(colorStart, colorLen);
+	} else {
+		token->attributes = tagEnd < end ? m_string.mid(tagEnd, end - tagEnd) : QStringView_();
+		token->color = QStringView_();
+	}
+	return true;
+}
+
+bool
+RichTagTokenizer::next(Token *token)
+{
+	for(const int len = m_string.size(); m_pos < len; m_pos++) {
+		const QChar ch = m_string.at(m_pos);
+		if(ch == QChar::LineFeed) {
+			*token = Token{m_pos, m_pos + 1, false, QStringView_(), QStringView_(), QStringView_(), QStringView_()};
+		} else if(ch == QLatin1Char('&')) {
+			const int end = m_string.indexOf(QLatin1Char(';'), m_pos + 1);
+			if(end <= m_pos + 1)
+				continue;
+			*token = Token{m_pos, end + 1, false, QStringView_(), QStringView_(), QStringView_(), m_string.mid(m_pos + 1, end - m_pos - 1)};
+		} else if(ch != QLatin1Char('<') || !tagAt(m_pos, token)) {
+			continue;
+		}
+		m_pos = token->end;
+		return true;
+	}
+	return false;
+}
+
+QStringView_
+RichTagTokenizer::styleColor(const QStringView_ &attributes)
+{
+	const QLatin1String style("style=\"");
+	for(int i = attributes.indexOf(style, 0, Qt::CaseInsensitive); i != -1; i = attributes.indexOf(style, i + 1, Qt::CaseInsensitive)) {
+		const int start = i + style.size();
+		int end = start;
+		while(end < attributes.size() && attributes.at(end) != QLatin1Char('"') && attributes.at(end) != QLatin1Char('>'))
+			end++;
+		int colorStart;
+		if(const int colorLen = lastAttributeValue(attributes, start, end, QLatin1String("color:"), false, &colorStart))
+			return attributes.mid(colorStart, colorLen);
+	}
+	return QStringView_();
+}
+
+static inline bool
+tagIs(const QStringView_ &tag, QLatin1String name)
+{
+	return tag.compare(name, Qt::CaseInsensitive) == 0;
+}
+
 RichString &
 RichString::setRichString(const QStringView_ &string)
 {
-	staticRE$(tagRegExp, "(<"
-			"(/?(v |c\\.?|\\w+))"
-			"([^>]*\\bcolor=\"?([\\w#]+)\"?|[^>]+)?"
-			"[^>]*?>|&([^;]+);|\\n)", REu | REi);
-	staticRE$(colorRegExp, "style=\"[^\">]*\\bcolor:([\\w#]+)", REu | REi);
+	struct ColorTag {
+		QRgb color;
+		QString tag;
+	};
 
-	QRegularExpressionMatchIterator it = tagRegExp.globalMatch(string);
+	RichTagTokenizer tokenizer(string);
+	RichTagTokenizer::Token token;
 
 	clear();
 
-	QStringList colorTags;
+	QVector<ColorTag> colorTags;
 	bool softBreak = false;
 	quint8 currentStyle = 0;
 	QColor currentColor;
@@ -718,57 +945,59 @@ RichString::setRichString(const QStringView_ &string)
 		quint32 newClass = currentClass;
 		qint32 newVoice = currentVoice;
 
-		const bool validIter = it.hasNext();
-		QRegularExpressionMatch m;
-
-		QString mTag;
-		QStringView ent;
+		const bool validIter = tokenizer.next(&token);
+		const QStringView_ &tag = token.tag;
 
 		if(validIter) {
-			m = it.next();
-
-			matchedPos = m.capturedStart();
-			ent = m.capturedView(6);
-			if(ent.isNull()) {
-				mTag = m.captured(2).toLower();
-				if(mTag == QLatin1String("b") || mTag == QLatin1String("strong")) {
+			matchedPos = token.start;
+			if(!tag.isNull() && !token.closing) {
+				if(tagIs(tag, QLatin1String("b")) || tagIs(tag, QLatin1String("strong"))) {
 					newStyle |= RichString::Bold;
-				} else if(mTag == QLatin1String("i") || mTag == QLatin1String("em")) {
+				} else if(tagIs(tag, QLatin1String("i")) || tagIs(tag, QLatin1String("em"))) {
 					newStyle |= RichString::Italic;
-				} else if(mTag == QLatin1String("u")) {
+				} else if(tagIs(tag, QLatin1String("u"))) {
 					newStyle |= RichString::Underline;
-				} else if(mTag == QLatin1String("s")) {
+				} else if(tagIs(tag, QLatin1String("s"))) {
 					newStyle |= RichString::StrikeThrough;
-				} else if(mTag == QLatin1String("font")) {
-					const QString &color = m.captured(5);
-					if(!color.isEmpty()) {
+				} else if(tagIs(tag, QLatin1String("font"))) {
+					if(!token.color.isEmpty()) {
 						newStyle |= RichString::Color;
-						newColor.setNamedColor(color.toLower());
-						colorTags.push_back(currentColor.name());
-						colorTags.push_back(mTag);
+						newColor.setNamedColor(token.color.toString().toLower());
+						colorTags.push_back(ColorTag{currentColor.rgb(), tag.toString().toLower()});
 					}
-				} else if(mTag == QLatin1String("v ")) {
-					newVoice = m_style->voiceIndex(m.captured(4));
-				} else if(mTag == QLatin1String("c.") || mTag == QLatin1String("c")) {
-					const int i = m_style->classIndex(m.captured(4));
+				} else if(tagIs(tag, QLatin1String("v "))) {
+					newVoice = m_style->voiceIndex(token.attributes.toString());
+				} else if(tagIs(tag, QLatin1String("c.")) || tagIs(tag, QLatin1String("c"))) {
+					const int i = m_style->classIndex(token.attributes.toString());
 					if(i >= 0)
 						newClass |= 1UL << i;
 					openClass.push_back(i);
-				} else if(mTag == QLatin1String("/b") || mTag == QLatin1String("/strong")) {
+				}
+
+				const QStringView_ color = RichTagTokenizer::styleColor(token.attributes);
+				if(!color.isNull()) {
+					newStyle |= RichString::Color;
+					newColor.setNamedColor(color.toString().toLower());
+					colorTags.push_back(ColorTag{currentColor.rgb(), tag.toString().toLower()});
+				}
+			} else if(!tag.isNull()) {
+				if(tagIs(tag, QLatin1String("b")) || tagIs(tag, QLatin1String("strong"))) {
 					newStyle &= ~RichString::Bold;
-				} else if(mTag == QLatin1String("/i") || mTag == QLatin1String("/em")) {
+				} else if(tagIs(tag, QLatin1String("i")) || tagIs(tag, QLatin1String("em"))) {
 					newStyle &= ~RichString::Italic;
-				} else if(mTag == QLatin1String("/u")) {
+				} else if(tagIs(tag, QLatin1String("u"))) {
 					newStyle &= ~RichString::Underline;
-				} else if(mTag == QLatin1String("/s")) {
+				} else if(tagIs(tag, QLatin1String("s"))) {
 					newStyle &= ~RichString::StrikeThrough;
-				} else if(mTag == QLatin1String("/c")) {
-					const int i = openClass.back();
-					openClass.pop_back();
-					if(i >= 0)
-						newClass &= ~(1UL << i);
-				} else if(mTag == QLatin1String("/c.")) {
-					const int i = m_style->classIndex(m.captured(4));
+				} else if(tagIs(tag, QLatin1String("c"))) {
+					if(!openClass.isEmpty()) {
+						const int i = openClass.back();
+						openClass.pop_back();
+						if(i >= 0)
+							newClass &= ~(1UL << i);
+					}
+				} else if(tagIs(tag, QLatin1String("c."))) {
+					const int i = m_style->classIndex(token.attributes.toString());
 					if(i >= 0)
 						newClass &= ~(1UL << i);
 					for(auto it = openClass.rbegin(); it != openClass.rend(); ++it) {
@@ -779,26 +1008,15 @@ RichString::setRichString(const QStringView_ &string)
 					}
 				}
 
-				if(!mTag.isEmpty()) {
-					if(mTag.front() != QLatin1Char('/')) {
-						QRegularExpressionMatch mc = colorRegExp.match(m.capturedView(4));
-						if(mc.hasMatch()) {
-							newStyle |= RichString::Color;
-							newColor.setNamedColor(mc.captured(1).toLower());
-							colorTags.push_back(currentColor.name());
-							colorTags.push_back(mTag);
-						}
-					} else if(!colorTags.empty() && QStringView(mTag).mid(1) == colorTags.back()) {
-						colorTags.pop_back();
-						if(colorTags.size() == 1) {
-							newStyle &= ~RichString::Color;
-							newColor.setNamedColor("-invalid-");
-						} else {
-							newStyle |= RichString::Color;
-							newColor.setNamedColor(colorTags.back());
-						}
-						colorTags.pop_back();
+				if(!colorTags.empty() && tag.compare(colorTags.back().tag, Qt::CaseInsensitive) == 0) {
+					if(colorTags.size() == 1) {
+						newStyle &= ~RichString::Color;
+						newColor = QColor();
+					} else {
+						newStyle |= RichString::Color;
+						newColor = QColor(colorTags.back().color);
 					}
+					colorTags.pop_back();
 				}
 			}
 		} else {
@@ -811,10 +1029,8 @@ RichString::setRichString(const QStringView_ &string)
 					append(QChar::LineFeed);
 				softBreak = false;
 			}
-			const int index = length();
 			QString::append(string.mid(offsetPos, len));
-			m_style->insert(index, len);
-			m_style->fill(index, len, RichStyle(currentStyle, currentColor.isValid() ? currentColor.rgb() : 0, currentClass, currentVoice));
+			m_style->append(len, RichStyle(currentStyle, currentColor.isValid() ? currentColor.rgb() : 0, currentClass, currentVoice));
 		}
 
 		currentStyle = newStyle;
@@ -823,6 +1039,7 @@ RichString::setRichString(const QStringView_ &string)
 		currentVoice = newVoice;
 
 		if(validIter) {
+			const QStringView_ &ent = token.entity;
 			if(!ent.isNull()) {
 				if(ent == QLatin1String("nbsp")) {
 					append(QChar::Nbsp);
@@ -839,25 +1056,26 @@ RichString::setRichString(const QStringView_ &string)
 					append(ent.toString());
 				}
 			} else {
-				if(m.capturedView(1).front() == QChar::LineFeed) {
+				if(tag.isNull()) {
 					softBreak = true;
-				} else if(mTag == QLatin1String("br")) {
+				} else if(token.closing) {
+					if(tagIs(tag, QLatin1String("p")))
+						softBreak = true;
+				} else if(tagIs(tag, QLatin1String("br"))) {
 					append(QChar::LineFeed);
 					softBreak = false;
-				} else if(mTag == QLatin1String("p")) {
+				} else if(tagIs(tag, QLatin1String("p"))) {
 					if(!isEmpty() && QString::back() != QChar::LineFeed) {
 						append(QChar::LineFeed);
 						softBreak = false;
 					}
-				} else if(mTag == QLatin1String("/p")) {
-					softBreak = true;
 				}
 			}
 		} else {
 			break;
 		}
 
-		offsetPos = m.capturedEnd();
+		offsetPos = token.end;
 	}
 
 	return *this;
@@ -867,8 +1085,8 @@ RichString::StyleFlags
 RichString::cummulativeStyleFlags() const
 {
 	quint8 cummulativeStyleFlags = 0;
-	for(int i = 0, size = length(); i < size; i++) {
-		cummulativeStyleFlags |= m_style->at(i).flags();
+	for(const RichStringStyle::StyleRun &run: m_style->runs()) {
+		cummulativeStyleFlags |= run.style.flags();
 		if(cummulativeStyleFlags == AllStyles)
 			break;
 	}
@@ -879,8 +1097,8 @@ bool
 RichString::hasStyleFlags(StyleFlags styleFlags) const
 {
 	StyleFlags cummulativeStyleFlags = 0;
-	for(int i = 0, size = length(); i < size; i++) {
-		cummulativeStyleFlags |= m_style->at(i).flags();
+	for(const RichStringStyle::StyleRun &run: m_style->runs()) {
+		cummulativeStyleFlags |= run.style.flags();
 		if((cummulativeStyleFlags & styleFlags) == styleFlags)
 			return true;
 	}
@@ -893,8 +1111,7 @@ RichString::setStyleFlags(int index, int len, StyleFlags styleFlags)
 	if(index < 0 || index >= length())
 		return *this;
 
-	for(int end = index + length(index, len); index < end; index++)
-		(*m_style)[index]->flags() = styleFlags;
+	m_style->update(index, length(index, len), [styleFlags](RichStyle &s){ s.flags() = styleFlags; });
 
 	return *this;
 }
@@ -905,14 +1122,12 @@ RichString::setStyleFlags(int index, int len, StyleFlags styleFlags, bool on)
 	if(index < 0 || index >= length())
 		return *this;
 
-	const int end = index + length(index, len);
+	len = length(index, len);
 	if(on) {
-		for(; index < end; index++)
-			(*m_style)[index]->flags() |= styleFlags;
+		m_style->update(index, len, [styleFlags](RichStyle &s){ s.flags() |= styleFlags; });
 	} else {
 		styleFlags = ~styleFlags;
-		for(; index < end; index++)
-			(*m_style)[index]->flags() &= styleFlags;
+		m_style->update(index, len, [styleFlags](RichStyle &s){ s.flags() &= styleFlags; });
 	}
 
 	return *this;
@@ -922,8 +1137,8 @@ QSet<QRgb>
 RichString::cummulativeColors() const
 {
 	QSet<QRgb> res;
-	for(int i = 0, n = length(); i < n; i++)
-		res.insert(m_style->at(i).color());
+	for(const RichStringStyle::StyleRun &run: m_style->runs())
+		res.insert(run.style.color());
 	return res;
 }
 
@@ -952,13 +1167,13 @@ RichString::setStyleColor(int index, int len, QRgb color)
 	if(index < 0 || index >= length())
 		return *this;
 
-	for(int end = index + length(index, len); index < end; index++) {
-		(*m_style)[index]->color() = color;
+	m_style->update(index, length(index, len), [color](RichStyle &s){
+		s.color() = color;
 		if(color)
-			(*m_style)[index]->flags() |= Color;
+			s.flags() |= Color;
 		else
-			(*m_style)[index]->flags() &= ~Color;
-	}
+			s.flags() &= ~Color;
+	});
 
 	return *this;
 }
@@ -1018,6 +1233,22 @@ RichString::insert(int index, const RichString &str)
 	return *this;
 }
 
+bool
+RichString::hasValidStyleRuns() const
+{
+	const QVector<RichStringStyle::StyleRun> &runs = m_style->runs();
+	int offset = 0;
+	for(int i = 0; i < runs.size(); i++) {
+		const RichStringStyle::StyleRun &run = runs.at(i);
+		if(run.offset != offset || run.length <= 0)
+			return false;
+		if(i && runs.at(i - 1).style.isSame(run.style))
+			return false;
+		offset += run.length;
+	}
+	return offset == length();
+}
+
 RichString &
 RichString::replace(int index, int len, const QString &replacement)
 {
@@ -1417,6 +1648,7 @@ RichString::simplifyWhiteSpace()
 	}
 	if(lastWasLineFeed)
 		di--;
+	m_style->replace(di, size() - di, 0);
 	truncate(di);
 }
 
@@ -29,6 +29,9 @@ Q_DECLARE_OPERATORS_FOR_FLAGS(SplitBehavior)
 }
 #endif
 
+// Forward declaration, needed for friend declaration
+class RichStringTest;
+
 namespace SubtitleComposer {
 class RichString;
 class RichStringStyle;
@@ -174,10 +177,16 @@ public:
 private:
 	inline int length(int index, int len) const { return len < 0 || (index + len) > length() ? length() - index : len; }
 
+	/**
+	 * @brief Check that style runs are sorted, cover the whole string and neighbouring runs differ
+	 */
+	bool hasValidStyleRuns() const;
+
 private:
 	friend QDataStream & ::operator<<(QDataStream &stream, const RichString &string);
 	friend QDataStream & ::operator>>(QDataStream &stream, RichString &string);
 	friend struct ReplaceHelper;
+	friend class ::RichStringTest;
 	RichStringStyle *m_style;
 };
 
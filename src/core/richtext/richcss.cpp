@@ -6,9 +6,15 @@
 
 #include "richcss.h"
 
+#include <QAtomicInteger>
 #include <QDebug>
 #include <QStringBuilder>
 
+#include <algorithm>
+
+// distinct selector sets whose match results are kept
+#define MATCH_CACHE_SIZE 1024
+
 using namespace SubtitleComposer;
 
 
@@ -22,14 +28,19 @@ public:
 typedef bool (*charCompare)(QChar ch);
 
 RichCSS::RichCSS(QObject *parent)
-	: QObject(parent)
+	: QObject(parent),
+	  m_cacheKey(nextCacheKey()),
+	  m_matchCacheKey(0)
 {
 }
 
 RichCSS::RichCSS(RichCSS &other)
 	: QObject(),
 	  m_unformatted(other.m_unformatted),
-	  m_stylesheet(other.m_stylesheet)
+	  m_stylesheet(other.m_stylesheet),
+	  m_cacheKey(nextCacheKey()),
+	  m_selectorIndex(other.m_selectorIndex),
+	  m_matchCacheKey(0)
 {
 }
 
@@ -38,9 +49,18 @@ RichCSS::operator=(const RichCSS &rhs)
 {
 	m_unformatted = rhs.m_unformatted;
 	m_stylesheet = rhs.m_stylesheet;
+	m_cacheKey = nextCacheKey();
+	m_selectorIndex = rhs.m_selectorIndex;
 	return *this;
 }
 
+quint64
+RichCSS::nextCacheKey()
+{
+	static QAtomicInteger<quint64> key;
+	return key.fetchAndAddOrdered(1) + 1;
+}
+
 static bool
 skipComment(const QChar **c)
 {
@@ -75,6 +95,8 @@ RichCSS::clear()
 {
 	m_stylesheet.clear();
 	m_unformatted.clear();
+	m_cacheKey = nextCacheKey();
+	compile();
 	emit changed();
 }
 
@@ -116,6 +138,8 @@ RichCSS::parse(const QChar *css)
 	}
 
 	m_unformatted.append(cssStart, css - cssStart);
+	m_cacheKey = nextCacheKey();
+	compile();
 
 	emit changed();
 }
@@ -384,44 +408,132 @@ RichCSS::mergeCssRules(RuleList &base, const RuleList &override) const
 	base.append(override);
 }
 
-QMap<QByteArray, QString>
-RichCSS::match(QSet<QString> selectors) const
+static inline bool
+isSelectorSeparator(const QChar *s, const QChar *e)
 {
-	QMap<QByteArray, QString> styles;
-	for(const Block &b: qAsConst(m_stylesheet)) {
-		const QChar *s = b.selector.constData();
-		const QChar *ss = s;
-		const QChar *e = s + b.selector.size();
-		bool matched = true;
+	return *s == QChar::Space || *s == QChar('>') || *s == QChar(',') || s == e;
+}
+
+static const QChar *
+selectorPartEnd(const QChar *s, const QChar *e)
+{
+	for(;;) {
+		if(*s == QChar('[')) {
+			while(*s != QChar(']') && s != e)
+				s++;
+		}
+		if(isSelectorSeparator(s, e))
+			return s;
+		s++;
+	}
+}
+
+/**
+ * @brief Match block selector @p sel against @p selectors
+ *
+ * Parts after the first keep their leading separator character, so only the first of comma separated
+ * selectors and only when it's a single simple selector can match real element selectors.
+ */
+static bool
+matchSelector(const QString &sel, const QSet<QString> &selectors)
+{
+	const QChar *s = sel.constData();
+	const QChar *e = s + sel.size();
+	const QChar *ss = s;
+	for(;;) {
+		s = selectorPartEnd(s, e);
+		if(selectors.contains(QString(ss, s - ss))) {
+			if(*s == QChar(',') || s == e)
+				return true; // matched full selector, we're done
+		} else {
+			while(*s != QChar(',') && s != e)
+				s++;
+			if(s == e)
+				return false; // not matched and no more selectors
+			// not matched but have more selectors after ','
+		}
+		ss = s;
+		s++;
+	}
+}
+
+void
+RichCSS::compile()
+{
+	m_selectorIndex.clear();
+
+	// index every block by all the parts matchSelector() can ever look up
+	QVector<const QChar *> pending;
+	QSet<const QChar *> visited;
+	for(int bi = 0; bi < m_stylesheet.size(); bi++) {
+		const Selector &sel = m_stylesheet.at(bi).selector;
+		const QChar *e = sel.constData() + sel.size();
+		const QChar *ss = sel.constData();
+		// first part is scanned from its first character, others right after their separator
+		const QChar *s = ss;
+		QSet<QString> parts;
+		pending.clear();
+		visited.clear();
 		for(;;) {
-			if(*s == QChar('[')) {
-				while(*s != QChar(']') && s != e)
+			s = selectorPartEnd(s, e);
+			parts.insert(QString(ss, s - ss));
+			if(s != e) {
+				// part was matched
+				if(*s != QChar(','))
+					pending.push_back(s);
+				// part was not matched
+				while(*s != QChar(',') && s != e)
 					s++;
+				if(s != e)
+					pending.push_back(s);
 			}
-			if(*s == QChar::Space || *s == QChar('>') || *s == QChar(',') || s == e) {
-				if(selectors.contains(QString(ss, s - ss))) {
-					if(*s == QChar(',') || s == e)
-						break; // matched full selector, we're done
-				} else {
-					while(*s != QChar(',') && s != e)
-						s++;
-					if(s == e) {
-						// not matched and no more selectors  - bail
-						matched = false;
-						break;
-					}
-					// not matched but have more selectors after ','
-				}
-				ss = s;
-			}
-			s++;
+			while(!pending.isEmpty() && visited.contains(pending.last()))
+				pending.removeLast();
+			if(pending.isEmpty())
+				break;
+			ss = pending.takeLast();
+			visited.insert(ss);
+			s = ss + 1;
 		}
-		if(!matched)
-			continue;
-		// merge styles
-		for(const Rule &r: qAsConst(b.rules))
+		for(const QString &part: qAsConst(parts))
+			m_selectorIndex[part].push_back(bi);
+	}
+}
+
+QMap<QByteArray, QString>
+RichCSS::match(const QSet<QString> &selectors) const
+{
+	if(m_matchCacheKey != m_cacheKey) {
+		m_matchCache.clear();
+		m_matchCacheKey = m_cacheKey;
+	}
+	auto cached = m_matchCache.constFind(selectors);
+	if(cached != m_matchCache.cend())
+		return cached.value();
+
+	// blocks that have none of their parts in selectors can't match
+	QVector<int> blocks;
+	for(const QString &sel: selectors) {
+		auto it = m_selectorIndex.constFind(sel);
+		if(it != m_selectorIndex.cend())
+			blocks.append(it.value());
+	}
+	std::sort(blocks.begin(), blocks.end());
+	blocks.erase(std::unique(blocks.begin(), blocks.end()), blocks.end());
+	blocks.erase(std::remove_if(blocks.begin(), blocks.end(), [&](int bi){
+		return !matchSelector(m_stylesheet.at(bi).selector, selectors);
+	}), blocks.end());
+
+	// merge styles in stylesheet order
+	QMap<QByteArray, QString> styles;
+	for(const int bi: qAsConst(blocks)) {
+		for(const Rule &r: m_stylesheet.at(bi).rules)
 			styles[r.name] = r.value;
 	}
+
+	if(m_matchCache.size() >= MATCH_CACHE_SIZE)
+		m_matchCache.clear();
+	m_matchCache.insert(selectors, styles);
 	return styles;
 }
 
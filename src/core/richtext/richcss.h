@@ -8,6 +8,7 @@
 #define RICHCSS_H
 
 #include <QByteArray>
+#include <QHash>
 #include <QMap>
 #include <QObject>
 #include <QSet>
@@ -50,13 +51,22 @@ public:
 
 	void clear();
 
-	QMap<QByteArray, QString> match(QSet<QString> selectors) const;
+	/**
+	 * @brief Merged rules of all blocks that have a selector made only of @p selectors
+	 *        Results are cached until the stylesheet changes.
+	 */
+	QMap<QByteArray, QString> match(const QSet<QString> &selectors) const;
 
 	/**
 	 * @return list of all defined classes
 	 */
 	QSet<QString> classes() const;
 
+	/**
+	 * @brief Unique value that changes whenever the stylesheet is modified
+	 */
+	inline quint64 cacheKey() const { return m_cacheKey; }
+
 signals:
 	void changed();
 
@@ -68,9 +78,20 @@ private:
 
 	void mergeCssRules(RuleList &base, const RuleList &override) const;
 
+	void compile();
+
+	static quint64 nextCacheKey();
+
 private:
 	QString m_unformatted;
 	Stylesheet m_stylesheet;
+	quint64 m_cacheKey;
+
+	// selector part -> indexes of blocks that look it up
+	QHash<QString, QVector<int>> m_selectorIndex;
+
+	mutable QHash<QSet<QString>, QMap<QByteArray, QString>> m_matchCache;
+	mutable quint64 m_matchCacheKey;
 
 	friend class ::RichCssTest;
 };
@@ -11,6 +11,7 @@
 #include "helpers/common.h"
 
 #include <QApplication>
+#include <QAtomicInteger>
 #include <QPainter>
 #include <QSharedPointer>
 #include <QSet>
@@ -35,6 +36,13 @@
 
 using namespace SubtitleComposer;
 
+static quint64
+nextCacheKey()
+{
+	static QAtomicInteger<quint64> key;
+	return key.fetchAndAddOrdered(1) + 1;
+}
+
 struct REStringCapture { int pos; int len; int no; };
 Q_DECLARE_TYPEINFO(REStringCapture, Q_PRIMITIVE_TYPE);
 
@@ -67,7 +75,8 @@ RichDocument::RichDocument(QObject *parent)
 	  m_undoableCursor(this),
 	  m_stylesheet(nullptr),
 	  m_domDirty(true),
-	  m_dom(new RichDOM)
+	  m_dom(new RichDOM),
+	  m_cacheKey(nextCacheKey())
 {
 	setUndoRedoEnabled(true);
 
@@ -81,6 +90,7 @@ RichDocument::RichDocument(QObject *parent)
 	setDocumentLayout(new RichDocumentLayout(this));
 
 	connect(this, &RichDocument::contentsChanged, this, [&](){
+		m_cacheKey = nextCacheKey();
 		m_domDirty = true;
 		emit domChanged();
 	});
@@ -79,6 +79,26 @@ public:
 	void setStylesheet(const RichCSS *css);
 	inline const RichCSS *stylesheet() const { return m_stylesheet; }
 
+	/**
+	 * @brief Unique value that changes whenever contents of the document change
+	 *
+	 * Unlike revision() it is never reused, not even by other documents or after undo.
+	 */
+	inline quint64 cacheKey() const { return m_cacheKey; }
+	/**
+	 * @brief Restore cacheKey() of a document that was recreated from the same contents
+	 */
+	inline void restoreCacheKey(quint64 key) { m_cacheKey = key; }
+
+	/**
+	 * @brief Treat current receivers of contentsChanged() as owned by the document holder
+	 *
+	 * After this call isObserved() reports whether anything else (editor, overlay) is
+	 * connected to the document.
+	 */
+	inline void markOwnObservers() { m_ownObservers = receivers(SIGNAL(contentsChanged())); }
+	inline bool isObserved() const { return receivers(SIGNAL(contentsChanged())) > m_ownObservers; }
+
 	RichDOM *dom();
 	QString crumbAt(RichDOM::Node *n);
 	RichDOM::Node *nodeAt(quint32 pos, RichDOM::Node *root=nullptr);
@@ -103,6 +123,8 @@ private:
 	const RichCSS *m_stylesheet;
 	bool m_domDirty;
 	RichDOM *m_dom;
+	quint64 m_cacheKey;
+	int m_ownObservers = 0;
 
 	void applyChanges(const void *changeList);
 
@@ -18,11 +18,17 @@
 #include "helpers/objectref.h"
 #include "gui/treeview/lineswidget.h"
 
+#include <QPair>
 #include <QTextDocumentFragment>
 #include <QTextEdit>
+#include <QThread>
 
 #include <KLocalizedString>
 
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
 using namespace SubtitleComposer;
 
 double Subtitle::s_defaultFramesPerSecond(23.976);
@@ -47,7 +53,31 @@ Subtitle::Subtitle(double framesPerSecond)
 	  m_framesPerSecond(framesPerSecond),
 	  m_stylesheet(new RichCSS(this)),
 	  m_formatData(nullptr)
-{}
+{
+	m_docsReleaseTimer.setSingleShot(true);
+	m_docsReleaseTimer.setInterval(30000);
+	connect(&m_docsReleaseTimer, &QTimer::timeout, this, &Subtitle::releaseDocs);
+
+	connect(this, &Subtitle::linesInserted, this, [this](int firstIndex, int lastIndex){
+		invalidateTimeIndex(firstIndex);
+		shiftShowTimeOrder(firstIndex, lastIndex - firstIndex + 1);
+		updateShowTimeOrder(firstIndex - 1, lastIndex);
+	});
+	connect(this, &Subtitle::linesRemoved, this, [this](int firstIndex, int lastIndex){
+		invalidateTimeIndex(firstIndex);
+		shiftShowTimeOrder(firstIndex, firstIndex - lastIndex - 1);
+		updateShowTimeOrder(firstIndex - 1, firstIndex - 1);
+	});
+	connect(this, &Subtitle::linesTimesChanged, this, [this](int firstIndex, int lastIndex){
+		invalidateTimeIndex(firstIndex);
+		updateShowTimeOrder(firstIndex - 1, lastIndex);
+	});
+	connect(this, &Subtitle::lineShowTimeChanged, this, [this](SubtitleLine *line){
+		const int index = line->index();
+		updateShowTimeOrder(index - 1, index);
+	});
+	connect(this, &Subtitle::lineHideTimeChanged, this, [this](SubtitleLine *line){ invalidateTimeIndex(line->index()); });
+}
 
 Subtitle::~Subtitle()
 {
@@ -79,7 +109,7 @@ Subtitle::setPrimaryData(const Subtitle &from, bool usePrimaryData)
 	const int thisErrors = SubtitleLine::SecondaryOnlyErrors;
 
 	for(SubtitleLine *fromLine = fromIt.current(), *thisLine = thisIt.current(); fromLine && thisLine; ++fromIt, ++thisIt, fromLine = fromIt.current(), thisLine = thisIt.current()) {
-		thisLine->setPrimaryDoc(usePrimaryData ? fromLine->primaryDoc() : fromLine->secondaryDoc());
+		thisLine->takeText(true, fromLine, usePrimaryData);
 		thisLine->setTimes(fromLine->showTime(), fromLine->hideTime());
 		thisLine->setErrorFlags((fromLine->errorFlags() & fromErrors) | (thisLine->errorFlags() & thisErrors));
 		thisLine->setFormatData(fromLine->formatData());
@@ -92,7 +122,7 @@ Subtitle::setPrimaryData(const Subtitle &from, bool usePrimaryData)
 		for(; fromIt.current(); ++fromIt) {
 			const SubtitleLine *cur = fromIt.current();
 			SubtitleLine *thisLine = new SubtitleLine(cur->showTime(), cur->hideTime());
-			thisLine->setPrimaryDoc(usePrimaryData ? cur->primaryDoc() : cur->secondaryDoc());
+			thisLine->takeText(true, cur, usePrimaryData);
 			thisLine->setErrorFlags(SubtitleLine::SecondaryOnlyErrors, false);
 			thisLine->setFormatData(cur->formatData());
 			thisLine->m_metaData = cur->m_metaData;
@@ -137,7 +167,7 @@ Subtitle::setSecondaryData(const Subtitle &from, bool usePrimaryData)
 	for(int i = 0, n = qMin(m_lines.size(), from.m_lines.size()); i < n; i++) {
 		const SubtitleLine *srcLine = from.m_lines.at(i).obj();
 		SubtitleLine *dstLine = m_lines.at(i).obj();
-		dstLine->setSecondaryDoc(usePrimaryData ? srcLine->primaryDoc() : srcLine->secondaryDoc());
+		dstLine->takeText(false, srcLine, usePrimaryData);
 		dstLine->setErrorFlags((dstLine->errorFlags() & dstErrors) | (srcLine->errorFlags() & srcErrors));
 	}
 
@@ -153,7 +183,7 @@ Subtitle::setSecondaryData(const Subtitle &from, bool usePrimaryData)
 	for(int i = m_lines.size(), n = from.m_lines.size(); i < n; i++) {
 		const SubtitleLine *srcLine = from.m_lines.at(i).obj();
 		SubtitleLine *dstLine = new SubtitleLine(srcLine->showTime(), srcLine->hideTime());
-		dstLine->setSecondaryDoc(usePrimaryData ? srcLine->primaryDoc() : srcLine->secondaryDoc());
+		dstLine->takeText(false, srcLine, usePrimaryData);
 		dstLine->setErrorFlags(SubtitleLine::PrimaryOnlyErrors, false);
 		newLines.append(dstLine);
 	}
@@ -240,17 +270,8 @@ Subtitle::changeFramesPerSecond(double toFramesPerSecond, double fromFramesPerSe
 
 	double scaleFactor = fromFramesPerSecond / toFramesPerSecond;
 
-	if(scaleFactor != 1.0) {
-		for(SubtitleIterator it(*this, Range::full()); it.current(); ++it) {
-			Time showTime = it.current()->showTime();
-			showTime *= scaleFactor;
-
-			Time hideTime = it.current()->hideTime();
-			hideTime *= scaleFactor;
-
-			processAction(new SetLineTimesAction(it, showTime, hideTime));
-		}
-	}
+	if(scaleFactor != 1.0 && !m_lines.empty())
+		processAction(new AdjustLinesTimesAction(this, RangeList(Range::full()), 0., scaleFactor, i18n("Change Frame Rate")));
 
 	endCompositeAction();
 }
@@ -266,6 +287,124 @@ Subtitle::line(int index) const
 {
 	return index < 0 || size_t(index) >= m_lines.size() ? nullptr : m_lines.at(index).obj();
 }
+
+void
+Subtitle::updateTimeIndex(int count) const
+{
+	if(m_maxHideTimeValid >= count)
+		return;
+
+	m_maxHideTime.resize(m_lines.size());
+	double maxHideTime = m_maxHideTimeValid ? m_maxHideTime[m_maxHideTimeValid - 1] : -std::numeric_limits<double>::infinity();
+	for(int i = m_maxHideTimeValid; i < count; i++) {
+		maxHideTime = qMax(maxHideTime, m_lines[i]->hideTime().toMillis());
+		m_maxHideTime[i] = maxHideTime;
+	}
+	m_maxHideTimeValid = count;
+}
+
+int
+Subtitle::showingBeforeCount(const Time &time) const
+{
+	// number of leading lines with show time <= time
+	const auto it = std::upper_bound(m_lines.cbegin(), m_lines.cend(), time,
+		[](const Time &t, const ObjectRef<SubtitleLine> &line){ return t < line->showTime(); });
+	return it - m_lines.cbegin();
+}
+
+void
+Subtitle::updateShowTimeOrder(int firstIndex, int lastIndex) const
+{
+	// recheck order of lines i and i + 1 for i in [firstIndex, lastIndex]
+	if(!m_showTimeOrderValid)
+		return;
+	firstIndex = qMax(0, firstIndex);
+	lastIndex = qMin(lastIndex, int(m_lines.size()) - 2);
+	for(int i = firstIndex; i <= lastIndex; i++) {
+		if(m_lines[i + 1]->showTime() < m_lines[i]->showTime())
+			m_showTimeUnsorted.insert(i);
+		else
+			m_showTimeUnsorted.remove(i);
+	}
+}
+
+void
+Subtitle::shiftShowTimeOrder(int index, int count) const
+{
+	// count lines were inserted (or -count removed) at index, pairs that changed
+	// neighbours are dropped and have to be rechecked by updateShowTimeOrder()
+	if(!m_showTimeOrderValid || m_showTimeUnsorted.isEmpty())
+		return;
+	const int droppedEnd = count < 0 ? index - count : index;
+	QSet<int> shifted;
+	for(const int i: qAsConst(m_showTimeUnsorted)) {
+		if(i < index - 1)
+			shifted.insert(i);
+		else if(i >= droppedEnd)
+			shifted.insert(i + count);
+	}
+	m_showTimeUnsorted = shifted;
+}
+
+bool
+Subtitle::isShowTimeSorted() const
+{
+	if(!m_showTimeOrderValid) {
+		m_showTimeUnsorted.clear();
+		m_showTimeOrderValid = true;
+		updateShowTimeOrder(0, int(m_lines.size()) - 2);
+	}
+	return m_showTimeUnsorted.isEmpty();
+}
+
+int
+Subtitle::firstIndexEndingAfter(const Time &time, int count) const
+{
+	// all lines before returned index are hidden before time
+	updateTimeIndex(count);
+	const auto it = std::lower_bound(m_maxHideTime.cbegin(), m_maxHideTime.cbegin() + count, time.toMillis());
+	return it - m_maxHideTime.cbegin();
+}
+
+QList<SubtitleLine *>
+Subtitle::linesInTimespan(const Time &start, const Time &end) const
+{
+	QList<SubtitleLine *> lines;
+	if(!isShowTimeSorted()) {
+		for(const ObjectRef<SubtitleLine> &line: qAsConst(m_lines)) {
+			if(line->intersectsTimespan(start, end))
+				lines.append(line.obj());
+		}
+		return lines;
+	}
+	const int count = showingBeforeCount(end);
+	for(int i = firstIndexEndingAfter(start, count); i < count; i++) {
+		SubtitleLine *line = m_lines[i].obj();
+		if(line->m_hideTime >= start)
+			lines.append(line);
+	}
+	return lines;
+}
+
+SubtitleLine *
+Subtitle::lineAt(const Time &time) const
+{
+	if(!isShowTimeSorted()) {
+		for(const ObjectRef<SubtitleLine> &line: qAsConst(m_lines)) {
+			if(line->containsTime(time))
+				return line.obj();
+		}
+		return nullptr;
+	}
+	const int count = showingBeforeCount(time);
+	for(int i = firstIndexEndingAfter(time, count); i < count; i++) {
+		SubtitleLine *line = m_lines[i].obj();
+		if(line->m_hideTime >= time)
+			return line;
+	}
+	return nullptr;
+}
+
 bool
 Subtitle::hasAnchors() const
 {
@@ -352,6 +491,72 @@ Subtitle::insertLine(SubtitleLine *line)
 	processAction(new InsertLinesAction(this, lines, insertIndex(line->showTime())));
 }
 
+/**
+ * @brief Insert a batch of new lines keeping the subtitle sorted by show time
+ *
+ * Lines are sorted (stable) by show time and then inserted with as few InsertLinesAction as possible,
+ * one for every run of lines that ends up between the same two existing lines. Loading into an empty
+ * subtitle results in a single action and a single linesInserted() signal.
+ */
+void
+Subtitle::insertLines(const QList<SubtitleLine *> &lines)
+{
+	if(lines.isEmpty())
+		return;
+
+	const auto showTimeLess = [](const SubtitleLine *l1, const SubtitleLine *l2) -> bool {
+		return l1->showTime() < l2->showTime();
+	};
+	QList<SubtitleLine *> sorted = lines;
+	if(!std::is_sorted(sorted.cbegin(), sorted.cend(), showTimeLess))
+		std::stable_sort(sorted.begin(), sorted.end(), showTimeLess);
+
+	if(m_lines.empty() || !(sorted.first()->showTime() < m_lines.back()->showTime())) {
+		processAction(new InsertLinesAction(this, sorted));
+		return;
+	}
+
+	beginCompositeAction(i18n("Insert Lines"));
+
+	// split the batch into runs that go between the same two existing lines
+	QList<QPair<int, QList<SubtitleLine *>>> runs;
+	for(SubtitleLine *line : qAsConst(sorted)) {
+		const int index = insertIndex(line->showTime());
+		if(runs.isEmpty() || runs.last().first != index)
+			runs.append(qMakePair(index, QList<SubtitleLine *>()));
+		runs.last().second.append(line);
+	}
+	// every inserted run shifts the insert index of the following ones
+	int insertedCount = 0;
+	for(const QPair<int, QList<SubtitleLine *>> &run : qAsConst(runs)) {
+		processAction(new InsertLinesAction(this, run.second, run.first + insertedCount));
+		insertedCount += run.second.size();
+	}
+
+	endCompositeAction();
+}
+
+QList<SubtitleLine *>
+Subtitle::takeRange(int firstIndex, int lastIndex)
+{
+	Q_ASSERT(firstIndex >= 0 && firstIndex <= lastIndex && size_t(lastIndex) < m_lines.size());
+	QList<SubtitleLine *> lines;
+	lines.reserve(lastIndex - firstIndex + 1);
+	for(int i = firstIndex; i <= lastIndex; i++)
+		lines.append(m_lines.at(i).obj());
+	m_lines.erase(m_lines.cbegin() + firstIndex, m_lines.cbegin() + lastIndex + 1);
+	return lines;
+}
+
+void
+Subtitle::insertAt(int index, const QList<SubtitleLine *> &lines)
+{
+	Q_ASSERT(index >= 0 && size_t(index) <= m_lines.size());
+	// reserve first, so the ObjectRef back-pointers are moved at most once
+	m_lines.reserve(m_lines.size() + lines.size());
+	m_lines.insert(m_lines.cbegin() + index, lines.cbegin(), lines.cend());
+}
+
 void
 Subtitle::insertLine(SubtitleLine *line, int index)
 {
@@ -406,7 +611,7 @@ Subtitle::insertNewLine(int index, bool insertAfter, SubtitleTarget target)
 		SubtitleLine *line = newLine;
 		SubtitleIterator it(*this, Range::full(), false);
 		for(it.toIndex(newLineIndex + 1); it.current(); ++it) {
-			line->secondaryDoc()->setRichText(it.current()->secondaryDoc()->toRichText());
+			line->secondaryDoc()->setRichText(it.current()->secondaryText());
 			line = it.current();
 		}
 		line->secondaryDoc()->clear();
@@ -420,7 +625,7 @@ Subtitle::insertNewLine(int index, bool insertAfter, SubtitleTarget target)
 		SubtitleIterator it(*this, Range::full(), true);
 		SubtitleLine *line = it.current();
 		for(--it; it.index() >= index; --it) {
-			line->secondaryDoc()->setRichText(it.current()->secondaryDoc()->toRichText());
+			line->secondaryDoc()->setRichText(it.current()->secondaryText());
 			line = it.current();
 		}
 		line->secondaryDoc()->clear();
@@ -465,7 +670,7 @@ Subtitle::removeLines(const RangeList &r, SubtitleTarget target)
 		SubtitleIterator srcIt(*this, rangesComplement);
 		SubtitleIterator dstIt(*this, Range::upper(ranges.firstIndex()));
 		for(; srcIt.current() && dstIt.current(); ++srcIt, ++dstIt)
-			dstIt.current()->secondaryDoc()->setRichText(srcIt.current()->secondaryDoc()->toRichText());
+			dstIt.current()->secondaryDoc()->setRichText(srcIt.current()->secondaryText());
 
 		// the remaining lines secondary text must be cleared
 		for(; dstIt.current(); ++dstIt)
@@ -504,7 +709,7 @@ Subtitle::removeLines(const RangeList &r, SubtitleTarget target)
 		SubtitleIterator srcIt(*this, Range(ranges.firstIndex(), m_lines.size() - lines.count() - 1), true);
 		SubtitleIterator dstIt(*this, rangesComplement, true);
 		for(; srcIt.current() && dstIt.current(); --srcIt, --dstIt)
-			dstIt.current()->secondaryDoc()->setRichText(srcIt.current()->secondaryDoc()->toRichText());
+			dstIt.current()->secondaryDoc()->setRichText(srcIt.current()->secondaryText());
 
 		// finally, we can remove the specified lines
 		RangeList::ConstIterator rangesIt = ranges.end(), begin = ranges.begin();
@@ -748,9 +953,8 @@ Subtitle::shiftLines(const RangeList &ranges, long msecs)
 				break;
 			}
 		}
-	} else {
-		for(SubtitleIterator it(*this, ranges); it.current(); ++it)
-			it.current()->shiftTimes(msecs);
+	} else if(!m_lines.empty()) {
+		processAction(new AdjustLinesTimesAction(this, ranges, msecs, 1.0, i18n("Shift Lines")));
 	}
 
 	endCompositeAction();
@@ -794,41 +998,32 @@ Subtitle::adjustLines(const Range &range, long newFirstTime, long newLastTime)
 	if(shiftMseconds == 0 && scaleFactor == 1.0)
 		return;
 
-	beginCompositeAction(i18n("Adjust Lines"));
-
-	for(SubtitleIterator it(*this, range); it.current(); ++it)
-		it.current()->adjustTimes(shiftMseconds, scaleFactor);
-
-	endCompositeAction();
+	processAction(new AdjustLinesTimesAction(this, RangeList(range), shiftMseconds, scaleFactor, i18n("Adjust Lines")));
 }
 
 void
 Subtitle::sortLines(const Range &range)
 {
-	beginCompositeAction(i18n("Sort"));
-
-	SubtitleIterator it(*this, range);
-	SubtitleLine *line = it.current();
-	SubtitleLine *nextLine = (++it).current();
-	for(; nextLine; ++it, line = nextLine, nextLine = it.current()) {
-		if(line->showTime() <= nextLine->showTime()) // already sorted
-			continue;
-
-		// TODO: could be improved by using insertIndex()
-		SubtitleIterator tmp(it);
-		int fromIndex = tmp.index();
-		int toIndex = -1;
-		while((--tmp).current() && tmp.current()->showTime() > nextLine->showTime())
-			toIndex = tmp.index();
+	if(m_lines.empty())
+		return;
 
-		Q_ASSERT(toIndex != -1);
+	const int firstIndex = qMax(0, range.start());
+	const int lastIndex = normalizeRangeIndex(range.end());
+	if(firstIndex >= lastIndex)
+		return;
 
-		processAction(new MoveLineAction(this, fromIndex, toIndex));
+	const auto lines = m_lines.cbegin() + firstIndex;
+	QVector<int> order(lastIndex - firstIndex + 1);
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&](int a, int b){ return lines[a]->showTime() < lines[b]->showTime(); });
 
-		--it;
-	}
+	bool sorted = true;
+	for(int i = 0, n = order.size(); sorted && i < n; i++)
+		sorted = order.at(i) == i;
+	if(sorted)
+		return;
 
-	endCompositeAction();
+	processAction(new SortLinesAction(this, firstIndex, order));
 }
 
 void
@@ -957,6 +1152,68 @@ Subtitle::fixOverlappingLines(const RangeList &ranges, const Time &minInterval)
 	endCompositeAction();
 }
 
+static double
+nearestTime(const QVector<double> &times, double time, double maxDistance)
+{
+	const auto it = std::lower_bound(times.cbegin(), times.cend(), time);
+	double nearest = time;
+	double distance = maxDistance;
+	if(it != times.cend() && *it - time <= distance) {
+		nearest = *it;
+		distance = *it - time;
+	}
+	if(it != times.cbegin() && time - *(it - 1) < distance)
+		nearest = *(it - 1);
+	return nearest;
+}
+
+void
+Subtitle::snapTimes(const RangeList &ranges, const QVector<double> &showTimes, const QVector<double> &hideTimes, const Time &maxDistance)
+{
+	if(m_lines.empty() || (showTimes.isEmpty() && hideTimes.isEmpty()))
+		return;
+
+	const double maxMillis = maxDistance.toMillis();
+	QVector<Time> times;
+	QList<QPair<SubtitleLine *, QPair<Time, Time>>> anchoredTimes;
+	int firstChanged = -1, lastChanged = -1;
+	for(SubtitleIterator it(*this, ranges); it.current(); ++it) {
+		SubtitleLine *line = it.current();
+		Time showTime(nearestTime(showTimes, line->showTime().toMillis(), maxMillis));
+		Time hideTime(nearestTime(hideTimes, line->hideTime().toMillis(), maxMillis));
+		// line would vanish if both ends snapped onto the same speech boundary
+		if(hideTime <= showTime || (showTime == line->showTime() && hideTime == line->hideTime())) {
+			showTime = line->showTime();
+			hideTime = line->hideTime();
+		} else if(isLineAnchored(line)) {
+			// moving an anchor adjusts the lines around it
+			anchoredTimes.append(qMakePair(line, qMakePair(showTime, hideTime)));
+			showTime = line->showTime();
+			hideTime = line->hideTime();
+		} else {
+			if(firstChanged == -1)
+				firstChanged = it.index();
+			lastChanged = it.index();
+		}
+		times.append(showTime);
+		times.append(hideTime);
+	}
+	if(firstChanged == -1 && anchoredTimes.isEmpty())
+		return;
+
+	beginCompositeAction(i18n("Snap Times to Speech"));
+
+	if(firstChanged != -1) {
+		processAction(new SetLinesTimesAction(this, ranges, times, i18n("Snap Times to Speech")));
+		// snapped lines are only moved a bit, they are sorted among themselves
+		sortLines(Range(firstChanged, lastChanged));
+	}
+	for(const auto &anchored: qAsConst(anchoredTimes))
+		anchored.first->setTimes(anchored.second.first, anchored.second.second);
+
+	endCompositeAction();
+}
+
 void
 Subtitle::fixPunctuation(const RangeList &ranges, bool spaces, bool quotes, bool engI, bool ellipsis, SubtitleTarget target)
 {
@@ -1364,23 +1621,38 @@ Subtitle::clearErrors(const RangeList &ranges, int errorFlags)
 void
 Subtitle::checkErrors(const RangeList &ranges, int errorFlags)
 {
-	beginCompositeAction(i18n("Check Lines Errors"));
-
-	for(SubtitleIterator it(*this, ranges); it.current(); ++it)
-		it.current()->check(errorFlags);
-
-	endCompositeAction();
+	checkLinesErrors(ranges, errorFlags, false);
 }
 
 void
 Subtitle::recheckErrors(const RangeList &ranges)
 {
-	beginCompositeAction(i18n("Check Lines Errors"));
+	checkLinesErrors(ranges, 0, true);
+}
 
+void
+Subtitle::checkLinesErrors(const RangeList &ranges, int errorFlags, bool recheck)
+{
+	QVector<SubtitleLine *> lines;
 	for(SubtitleIterator it(*this, ranges); it.current(); ++it)
-		it.current()->check(it.current()->errorFlags());
+		lines.push_back(it.current());
+
+	// text stats are the slow part of the checks, they are computed in parallel
+	// and the checks are only comparing them against limits
+	const int textCheckErrors = SubtitleLine::PrimaryUnneededDash | SubtitleLine::SecondaryUnneededDash
+		| SubtitleLine::PrimaryCapitalAfterEllipsis | SubtitleLine::SecondaryCapitalAfterEllipsis;
+	SubtitleLine::updateStats(lines, recheck || (errorFlags & textCheckErrors));
+
+	QVector<int> errorFlagsList(lines.size());
+	bool changed = false;
+	for(int i = 0, n = lines.size(); i < n; i++) {
+		SubtitleLine *line = lines.at(i);
+		errorFlagsList[i] = line->check(recheck ? line->errorFlags() : errorFlags, false);
+		changed = changed || errorFlagsList.at(i) != line->errorFlags();
+	}
 
-	endCompositeAction();
+	if(changed)
+		processAction(new SetLinesErrorsAction(this, ranges, errorFlagsList));
 }
 
 void
@@ -1388,6 +1660,8 @@ Subtitle::processAction(UndoAction *action) const
 {
 	if(appSubtitle() == this) {
 		appUndoStack()->push(action);
+	} else if(m_undoStack) {
+		m_undoStack->push(action);
 	} else {
 		action->redo();
 		delete action;
@@ -1399,6 +1673,8 @@ Subtitle::beginCompositeAction(const QString &title) const
 {
 	if(appSubtitle() == this)
 		appUndoStack()->beginMacro(title);
+	else if(m_undoStack)
+		m_undoStack->beginMacro(title);
 }
 
 void
@@ -1406,6 +1682,8 @@ Subtitle::endCompositeAction(UndoStack::DirtyMode dirtyOverride) const
 {
 	if(appSubtitle() == this)
 		appUndoStack()->endMacro(dirtyOverride);
+	else if(m_undoStack)
+		m_undoStack->endMacro();
 }
 
 bool
@@ -1483,6 +1761,24 @@ Subtitle::stylesheetClear()
 	m_stylesheet->clear();
 }
 
+void
+Subtitle::releaseDocs()
+{
+	for(const auto &ref : m_lines) {
+		SubtitleLine *line = ref.obj();
+		if(line->m_primaryDoc || line->m_secondaryDoc)
+			line->releaseDocs();
+	}
+}
+
+void
+Subtitle::scheduleDocsRelease() const
+{
+	// documents created while e.g. searching or painting are released after a while
+	if(!m_docsReleaseTimer.isActive() && QThread::currentThread() == thread())
+		m_docsReleaseTimer.start();
+}
+
 /// SUBTITLECOMPOSITEACTIONEXECUTOR
 
 SubtitleCompositeActionExecutor::SubtitleCompositeActionExecutor(const Subtitle *subtitle, const QString &title)
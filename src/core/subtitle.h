@@ -23,10 +23,17 @@
 #include <QMap>
 #include <QObject>
 #include <QPointer>
+#include <QSet>
 #include <QString>
 #include <QStringList>
+#include <QTimer>
+#include <QVector>
 
 QT_FORWARD_DECLARE_CLASS(QUndoCommand)
+QT_FORWARD_DECLARE_CLASS(QUndoStack)
+
+// Forward declaration, needed for friend declaration
+class SubtitleTest;
 QT_FORWARD_DECLARE_CLASS(QTextEdit)
 
 namespace SubtitleComposer {
@@ -50,6 +57,7 @@ class Subtitle : public QObject, public QSharedData
 	friend class InsertLinesAction;
 	friend class RemoveLinesAction;
 	friend class MoveLineAction;
+	friend class SortLinesAction;
 	friend class EditStylesheetAction;
 
 	friend class SubtitleLineAction;
@@ -67,6 +75,8 @@ class Subtitle : public QObject, public QSharedData
 	friend class Format;
 	friend class InputFormat;
 
+	friend class ::SubtitleTest;
+
 public:
 	static double defaultFramesPerSecond();
 	static void setDefaultFramesPerSecond(double framesPerSecond);
@@ -111,6 +121,14 @@ public:
 	inline const SubtitleLine * operator[](const int i) const { return m_lines.at(i).obj(); }
 	inline SubtitleLine * operator[](const int i) { return m_lines.at(i).obj(); }
 
+	/**
+	 * @brief Lines overlapping time span [start, end], in index order
+	 *
+	 * Lines are expected to be sorted by show time, the lookup is O(log n) + number of returned lines.
+	 */
+	QList<SubtitleLine *> linesInTimespan(const Time &start, const Time &end) const;
+	SubtitleLine * lineAt(const Time &time) const;
+
 	bool hasAnchors() const;
 	bool isLineAnchored(int index) const;
 	bool isLineAnchored(const SubtitleLine *line) const;
@@ -119,6 +137,7 @@ public:
 	void removeAllAnchors();
 
 	void insertLine(SubtitleLine *line);
+	void insertLines(const QList<SubtitleLine *> &lines);
 	SubtitleLine * insertNewLine(int index, bool timeAfter, SubtitleTarget target);
 	void removeLines(const RangeList &ranges, SubtitleTarget target);
 
@@ -138,6 +157,12 @@ public:
 	void setAutoDurations(const RangeList &ranges, int msecsPerChar, int msecsPerWord, int msecsPerLine, bool canOverlap, SubtitleTarget calculationTarget);
 
 	void fixOverlappingLines(const RangeList &ranges, const Time &minInterval = 100);
+	/**
+	 * @brief Move show and hide times to nearest of sorted @p showTimes and @p hideTimes (in milliseconds)
+	 *
+	 * Times that are further than @p maxDistance from all of them are left unchanged.
+	 */
+	void snapTimes(const RangeList &ranges, const QVector<double> &showTimes, const QVector<double> &hideTimes, const Time &maxDistance);
 
 	void fixPunctuation(const RangeList &ranges, bool spaces, bool quotes, bool englishI, bool ellipsis, SubtitleTarget target);
 
@@ -174,6 +199,15 @@ public:
 	void stylesheetClear();
 	inline const RichCSS *stylesheet() const { return m_stylesheet; }
 
+	void releaseDocs();
+
+	/**
+	 * @brief Record undo actions on @p undoStack when this isn't the application subtitle
+	 *
+	 * Without it actions of such subtitles are executed right away and can't be undone.
+	 */
+	inline void setUndoStack(QUndoStack *undoStack) { m_undoStack = undoStack; }
+
 signals:
 	void primaryChanged();
 	void secondaryChanged();
@@ -186,6 +220,8 @@ signals:
 	void linesInserted(int firstIndex, int lastIndex);
 	void linesAboutToBeRemoved(int firstIndex, int lastIndex);
 	void linesRemoved(int firstIndex, int lastIndex);
+	void linesTimesChanged(int firstIndex, int lastIndex);
+	void linesErrorFlagsChanged(int firstIndex, int lastIndex);
 
 	void compositeActionStart();
 	void compositeActionEnd();
@@ -212,6 +248,8 @@ private:
 	void endCompositeAction(UndoStack::DirtyMode dirtyOverride = UndoStack::Invalid) const;
 	void processAction(UndoAction *action) const;
 
+	void checkLinesErrors(const RangeList &ranges, int errorFlags, bool recheck);
+
 	bool isPrimaryDirty(int index) const;
 	bool isSecondaryDirty(int index) const;
 	void updateState();
@@ -219,6 +257,18 @@ private:
 	inline int normalizeRangeIndex(int index) const { return size_t(index) >= m_lines.size() ? m_lines.size() - 1 : index; }
 
 	inline SubtitleLine * takeAt(const int i) { SubtitleLine *s = m_lines.at(i).obj(); m_lines.erase(m_lines.cbegin() + i); return s; }
+	QList<SubtitleLine *> takeRange(int firstIndex, int lastIndex);
+	void insertAt(int index, const QList<SubtitleLine *> &lines);
+
+	void scheduleDocsRelease() const;
+
+	inline void invalidateTimeIndex(int index) const { if(index < m_maxHideTimeValid) m_maxHideTimeValid = qMax(0, index); }
+	void updateShowTimeOrder(int firstIndex, int lastIndex) const;
+	void shiftShowTimeOrder(int index, int count) const;
+	void updateTimeIndex(int count) const;
+	int firstIndexEndingAfter(const Time &time, int count) const;
+	int showingBeforeCount(const Time &time) const;
+	bool isShowTimeSorted() const;
 
 	inline bool ignoreDocChanges(bool ignore) {
 		bool r = m_ignoreDocChanges;
@@ -234,6 +284,8 @@ private:
 
 	bool m_ignoreDocChanges = false;
 
+	QUndoStack *m_undoStack = nullptr;
+
 	double m_framesPerSecond;
 	mutable ObjectRefArray<SubtitleLine> m_lines;
 	QList<QPointer<const SubtitleLine>> m_anchoredLines;
@@ -244,6 +296,16 @@ private:
 
 	FormatData *m_formatData;
 
+	mutable QTimer m_docsReleaseTimer;
+
+	// m_maxHideTime[i] is the latest hide time of lines [0, i], first m_maxHideTimeValid entries are up to date
+	mutable std::vector<double> m_maxHideTime;
+	mutable int m_maxHideTimeValid = 0;
+	// shifted or edited lines can be out of show time order, lookups scan all lines then
+	mutable bool m_showTimeOrderValid = false;
+	// indexes i of lines that show after line i + 1, kept up to date by line and time changes
+	mutable QSet<int> m_showTimeUnsorted;
+
 	static double s_defaultFramesPerSecond;
 };
 
@@ -10,6 +10,7 @@
 #include "core/undo/subtitlelineactions.h"
 #include "core/undo/subtitleactions.h"
 #include "helpers/common.h"
+#include "helpers/parallel.h"
 #include "scconfig.h"
 
 #include <QRegularExpression>
@@ -18,6 +19,9 @@
 
 #include <math.h>
 
+// text stats key of compact text that isn't in a document
+#define COMPACT_TEXT_KEY (~quint64(0))
+
 using namespace SubtitleComposer;
 
 
@@ -127,9 +131,6 @@ SubtitleLine::fullErrorText(SubtitleLine::ErrorID errorID) const
 void
 SubtitleLine::setupSignals()
 {
-	connect(m_primaryDoc, &RichDocument::contentsChanged, this, &SubtitleLine::primaryDocumentChanged);
-	connect(m_secondaryDoc, &RichDocument::contentsChanged, this, &SubtitleLine::secondaryDocumentChanged);
-
 	QObject::connect(this, &SubtitleLine::primaryTextChanged, [this](){
 		if(subtitle()) emit subtitle()->linePrimaryTextChanged(this);
 	});
@@ -147,8 +148,8 @@ SubtitleLine::setupSignals()
 SubtitleLine::SubtitleLine()
 	: QObject(),
 	  m_subtitle(nullptr),
-	  m_primaryDoc(new RichDocument(this)),
-	  m_secondaryDoc(new RichDocument(this)),
+	  m_primaryDoc(nullptr),
+	  m_secondaryDoc(nullptr),
 	  m_showTime(0.0),
 	  m_hideTime(0.0),
 	  m_errorFlags(0),
@@ -160,8 +161,8 @@ SubtitleLine::SubtitleLine()
 SubtitleLine::SubtitleLine(const Time &showTime, const Time &hideTime)
 	: QObject(),
 	  m_subtitle(nullptr),
-	  m_primaryDoc(new RichDocument(this)),
-	  m_secondaryDoc(new RichDocument(this)),
+	  m_primaryDoc(nullptr),
+	  m_secondaryDoc(nullptr),
 	  m_showTime(showTime),
 	  m_hideTime(hideTime),
 	  m_errorFlags(0),
@@ -253,6 +254,9 @@ SubtitleLine::primaryDocumentChanged()
 {
 	if(m_ignoreDocChanges || (m_subtitle && m_subtitle->m_ignoreDocChanges))
 		return;
+	// undo actions keep pointer to the document - it can't be released anymore
+	if(m_subtitle)
+		m_primaryDocPinned = true;
 	processAction(new SetLinePrimaryTextAction(this, m_primaryDoc));
 }
 
@@ -261,9 +265,139 @@ SubtitleLine::secondaryDocumentChanged()
 {
 	if(m_ignoreDocChanges || (m_subtitle && m_subtitle->m_ignoreDocChanges))
 		return;
+	if(m_subtitle)
+		m_secondaryDocPinned = true;
 	processAction(new SetLineSecondaryTextAction(this, m_secondaryDoc));
 }
 
+RichDocument *
+SubtitleLine::createDoc(bool primary) const
+{
+	SubtitleLine *self = const_cast<SubtitleLine *>(this);
+	RichDocument *doc = new RichDocument(self);
+	doc->setStylesheet(m_subtitle ? m_subtitle->m_stylesheet : nullptr);
+
+	RichString &text = primary ? m_primaryText : m_secondaryText;
+	if(!text.isEmpty()) {
+		doc->setRichText(text, true);
+		text = RichString();
+	}
+	// text didn't change since the document was released - keep caches keyed on it valid
+	if(const quint64 textKey = primary ? m_primaryTextKey : m_secondaryTextKey)
+		doc->restoreCacheKey(textKey);
+	// document has the same text, stats are still valid
+	quint64 &statsKey = primary ? m_primaryStatsKey : m_secondaryStatsKey;
+	if(statsKey == COMPACT_TEXT_KEY)
+		statsKey = doc->cacheKey();
+
+	if(primary) {
+		connect(doc, &RichDocument::contentsChanged, self, &SubtitleLine::primaryDocumentChanged);
+		m_primaryDoc = doc;
+	} else {
+		connect(doc, &RichDocument::contentsChanged, self, &SubtitleLine::secondaryDocumentChanged);
+		m_secondaryDoc = doc;
+	}
+	doc->markOwnObservers();
+
+	if(m_subtitle)
+		m_subtitle->scheduleDocsRelease();
+
+	return doc;
+}
+
+bool
+SubtitleLine::releaseDoc(bool primary)
+{
+	RichDocument *doc = primary ? m_primaryDoc : m_secondaryDoc;
+	if(!doc || doc->parent() != this || (primary ? m_primaryDocPinned : m_secondaryDocPinned))
+		return false;
+	if(doc->isUndoAvailable() || doc->isRedoAvailable() || doc->isObserved())
+		return false;
+
+	quint64 &statsKey = primary ? m_primaryStatsKey : m_secondaryStatsKey;
+	if(statsKey == doc->cacheKey())
+		statsKey = COMPACT_TEXT_KEY;
+
+	if(primary) {
+		m_primaryText = doc->toRichText();
+		m_primaryTextKey = doc->cacheKey();
+		m_primaryDoc = nullptr;
+	} else {
+		m_secondaryText = doc->toRichText();
+		m_secondaryTextKey = doc->cacheKey();
+		m_secondaryDoc = nullptr;
+	}
+	delete doc;
+	return true;
+}
+
+bool
+SubtitleLine::releaseDocs()
+{
+	const bool primary = releaseDoc(true);
+	const bool secondary = releaseDoc(false);
+	return primary || secondary;
+}
+
+RichString
+SubtitleLine::primaryText() const
+{
+	return m_primaryDoc ? m_primaryDoc->toRichText() : m_primaryText;
+}
+
+RichString
+SubtitleLine::secondaryText() const
+{
+	return m_secondaryDoc ? m_secondaryDoc->toRichText() : m_secondaryText;
+}
+
+static QString
+compactPlainText(const RichString &text)
+{
+	// same as QTextDocument::toPlainText()
+	QString plain = text.string();
+	plain.replace(QChar::Nbsp, QChar::Space);
+	return plain;
+}
+
+QString
+SubtitleLine::primaryPlainText() const
+{
+	return m_primaryDoc ? m_primaryDoc->toPlainText() : compactPlainText(m_primaryText);
+}
+
+QString
+SubtitleLine::secondaryPlainText() const
+{
+	return m_secondaryDoc ? m_secondaryDoc->toPlainText() : compactPlainText(m_secondaryText);
+}
+
+void
+SubtitleLine::setPrimaryText(const RichString &text)
+{
+	if(m_primaryDoc || m_subtitle) {
+		primaryDoc()->setRichText(text, !m_subtitle);
+		return;
+	}
+	m_primaryText = text;
+	m_primaryTextKey = 0;
+	m_primaryStatsKey = 0;
+	emit primaryTextChanged();
+}
+
+void
+SubtitleLine::setSecondaryText(const RichString &text)
+{
+	if(m_secondaryDoc || m_subtitle) {
+		secondaryDoc()->setRichText(text, !m_subtitle);
+		return;
+	}
+	m_secondaryText = text;
+	m_secondaryTextKey = 0;
+	m_secondaryStatsKey = 0;
+	emit secondaryTextChanged();
+}
+
 void
 SubtitleLine::setPrimaryDoc(RichDocument *doc)
 {
@@ -274,6 +408,9 @@ SubtitleLine::setPrimaryDoc(RichDocument *doc)
 		m_primaryDoc->setStylesheet(nullptr);
 	}
 	m_primaryDoc = doc;
+	m_primaryText = RichString();
+	m_primaryTextKey = 0;
+	m_primaryDocPinned = true;
 	m_primaryDoc->setParent(this);
 	m_primaryDoc->setStylesheet(m_subtitle ? m_subtitle->m_stylesheet : nullptr);
 	connect(m_primaryDoc, &RichDocument::contentsChanged, this, &SubtitleLine::primaryDocumentChanged);
@@ -289,11 +426,58 @@ SubtitleLine::setSecondaryDoc(RichDocument *doc)
 		m_secondaryDoc->setStylesheet(nullptr);
 	}
 	m_secondaryDoc = doc;
+	m_secondaryText = RichString();
+	m_secondaryTextKey = 0;
+	m_secondaryDocPinned = true;
 	m_secondaryDoc->setParent(this);
 	m_secondaryDoc->setStylesheet(m_subtitle ? m_subtitle->m_stylesheet : nullptr);
 	connect(m_secondaryDoc, &RichDocument::contentsChanged, this, &SubtitleLine::secondaryDocumentChanged);
 }
 
+void
+SubtitleLine::takeText(bool primary, const SubtitleLine *from, bool fromPrimary)
+{
+	// adopt an existing document, otherwise move compact text without creating one
+	RichDocument *doc = fromPrimary ? from->m_primaryDoc : from->m_secondaryDoc;
+	if(doc) {
+		if(primary)
+			setPrimaryDoc(doc);
+		else
+			setSecondaryDoc(doc);
+		return;
+	}
+
+	if(primary && m_primaryDoc) {
+		disconnect(m_primaryDoc, &RichDocument::contentsChanged, this, &SubtitleLine::primaryDocumentChanged);
+		m_primaryDoc->setStylesheet(nullptr);
+		m_primaryDoc = nullptr;
+	} else if(!primary && m_secondaryDoc) {
+		disconnect(m_secondaryDoc, &RichDocument::contentsChanged, this, &SubtitleLine::secondaryDocumentChanged);
+		m_secondaryDoc->setStylesheet(nullptr);
+		m_secondaryDoc = nullptr;
+	}
+
+	const bool statsValid = (fromPrimary ? from->m_primaryStatsKey : from->m_secondaryStatsKey) == COMPACT_TEXT_KEY;
+	const TextStats &stats = fromPrimary ? from->m_primaryStats : from->m_secondaryStats;
+	const RichString &text = fromPrimary ? from->m_primaryText : from->m_secondaryText;
+	const quint64 textKey = fromPrimary ? from->m_primaryTextKey : from->m_secondaryTextKey;
+	if(primary) {
+		m_primaryText = text;
+		m_primaryTextKey = textKey;
+		m_primaryDocPinned = false;
+		m_primaryStats = stats;
+		m_primaryStatsKey = statsValid ? COMPACT_TEXT_KEY : 0;
+		emit primaryTextChanged();
+	} else {
+		m_secondaryText = text;
+		m_secondaryTextKey = textKey;
+		m_secondaryDocPinned = false;
+		m_secondaryStats = stats;
+		m_secondaryStatsKey = statsValid ? COMPACT_TEXT_KEY : 0;
+		emit secondaryTextChanged();
+	}
+}
+
 void
 SubtitleLine::setTexts(RichDocument *pText, RichDocument *sText)
 {
@@ -306,14 +490,14 @@ SubtitleLine::breakText(int minBreakLength, SubtitleTarget target)
 {
 	switch(target) {
 	case Primary:
-		m_primaryDoc->breakText(minBreakLength);
+		primaryDoc()->breakText(minBreakLength);
 		break;
 	case Secondary:
-		m_secondaryDoc->breakText(minBreakLength);
+		secondaryDoc()->breakText(minBreakLength);
 		break;
 	case Both:
-		m_primaryDoc->breakText(minBreakLength);
-		m_secondaryDoc->breakText(minBreakLength);
+		primaryDoc()->breakText(minBreakLength);
+		secondaryDoc()->breakText(minBreakLength);
 		break;
 	default:
 		break;
@@ -325,14 +509,14 @@ SubtitleLine::unbreakText(SubtitleTarget target)
 {
 	switch(target) {
 	case Primary:
-		m_primaryDoc->joinLines();
+		primaryDoc()->joinLines();
 		break;
 	case Secondary:
-		m_secondaryDoc->joinLines();
+		secondaryDoc()->joinLines();
 		break;
 	case Both:
-		m_primaryDoc->joinLines();
-		m_secondaryDoc->joinLines();
+		primaryDoc()->joinLines();
+		secondaryDoc()->joinLines();
 		break;
 	default:
 		break;
@@ -344,14 +528,14 @@ SubtitleLine::simplifyTextWhiteSpace(SubtitleTarget target)
 {
 	switch(target) {
 	case Primary:
-		m_primaryDoc->cleanupSpaces();
+		primaryDoc()->cleanupSpaces();
 		break;
 	case Secondary:
-		m_secondaryDoc->cleanupSpaces();
+		secondaryDoc()->cleanupSpaces();
 		break;
 	case Both:
-		m_primaryDoc->cleanupSpaces();
-		m_secondaryDoc->cleanupSpaces();
+		primaryDoc()->cleanupSpaces();
+		secondaryDoc()->cleanupSpaces();
 		break;
 	default:
 		break;
@@ -417,7 +601,8 @@ SubtitleLine::setHideTime(const Time &hideTime)
 QColor
 SubtitleLine::durationColor(const QColor &textColor, bool usePrimary)
 {
-	const int textLen = (usePrimary ? primaryDoc() : secondaryDoc())->length();
+	// same as RichDocument::length(), which counts the final paragraph separator
+	const int textLen = stats(usePrimary).length + 1;
 	const int minD = textLen * SCConfig::minDurationPerCharacter();
 	const int maxD = textLen * SCConfig::maxDurationPerCharacter();
 	const int avgD = textLen * SCConfig::idealDurationPerCharacter();
@@ -463,46 +648,200 @@ SubtitleLine::setTimes(const Time &showTime, const Time &hideTime)
 		m_subtitle->endCompositeAction();
 }
 
-int
-SubtitleLine::primaryCharacters() const
+static inline bool
+isRegExpSpace(QChar ch)
 {
-	return m_primaryDoc->toPlainText().simplified().length();
+	// \s of QRegularExpression without UseUnicodePropertiesOption
+	const ushort c = ch.unicode();
+	return c == ' ' || (c >= '\t' && c <= '\r');
 }
 
-int
-SubtitleLine::primaryWords() const
+static inline bool
+isUnneededSpacePair(QChar ch, QChar next)
 {
-	QString text(m_primaryDoc->toPlainText().simplified());
-	return text.length() ? text.count(' ') + 1 : 0;
+	if(isRegExpSpace(ch))
+		return isRegExpSpace(next) || next == u'!' || next == u'?' || next == u':' || next == u';' || next == u',' || next == u'.';
+	return (ch == u'¿' || ch == u'¡') && isRegExpSpace(next);
 }
 
-int
-SubtitleLine::primaryLines() const
+static bool
+hasCapitalAfterEllipsis(const QString &text)
 {
-	RichString text(m_primaryDoc->toPlainText());
-	text.simplifyWhiteSpace();
-	return text.isEmpty() ? 0 : text.count('\n') + 1;
+	staticRE$(capitalAfterEllipsisRegExp, "^\\s*\\.\\.\\.[¡¿\\.,;\\(\\[\\{\"'\\s]*", REu);
+
+	QRegularExpressionMatchIterator it = capitalAfterEllipsisRegExp.globalMatch(text);
+	if(!it.hasNext())
+		return false;
+	const int end = it.next().capturedEnd();
+	if(end >= text.length())
+		return false;
+	const QChar chr = text.at(end);
+	return chr.isLetter() && chr == chr.toUpper();
 }
 
-int
-SubtitleLine::secondaryCharacters() const
+static bool
+hasUnneededDash(const QString &text)
+{
+	staticRE$(unneededDashRegExp, "(^|\n)\\s*-[^-]", REu);
+
+	return text.count(unneededDashRegExp) == 1;
+}
+
+static void
+computeTextStats(const QString &text, SubtitleLine::TextStats *stats)
+{
+	// characters and words are counted like QString::simplified() would leave them,
+	// lines like RichString::simplifyWhiteSpace() and unneeded spaces like the regexp
+	// in checkPrimaryUnneededSpaces() matched on every line
+	const QChar *data = text.constData();
+	const int len = text.length();
+
+	int nonSpace = 0;
+	int words = 0;
+	int lineNonSpace = 0;
+	int lineWords = 0;
+	int maxLineChars = 0;
+	int lines = 0;
+	bool inWord = false;
+	bool blankLine = true;
+	bool unneededSpaces = false;
+
+	for(int i = 0; i < len; i++) {
+		const QChar ch = data[i];
+
+		if(ch == QChar::LineFeed || ch == QChar::CarriageReturn) {
+			if(!blankLine)
+				lines++;
+			blankLine = true;
+		} else if(ch != QChar::Space && ch != QChar::Tabulation) {
+			blankLine = false;
+		}
+
+		if(ch == QChar::LineFeed) {
+			inWord = false;
+			maxLineChars = qMax(maxLineChars, lineNonSpace + qMax(0, lineWords - 1));
+			lineNonSpace = 0;
+			lineWords = 0;
+			continue;
+		}
+
+		if(ch.isSpace()) {
+			inWord = false;
+		} else {
+			nonSpace++;
+			lineNonSpace++;
+			if(!inWord) {
+				inWord = true;
+				words++;
+				lineWords++;
+			}
+		}
+
+		if(!unneededSpaces) {
+			const bool lineStart = i == 0 || data[i - 1] == QChar::LineFeed;
+			const bool lineEnd = i + 1 == len || data[i + 1] == QChar::LineFeed;
+			if(lineStart || lineEnd)
+				unneededSpaces = isRegExpSpace(ch);
+			if(!lineEnd && isUnneededSpacePair(ch, data[i + 1]))
+				unneededSpaces = true;
+		}
+	}
+	if(!blankLine)
+		lines++;
+
+	stats->length = len;
+	stats->characters = nonSpace + qMax(0, words - 1);
+	stats->words = words;
+	stats->lines = lines;
+	stats->maxLineCharacters = qMax(maxLineChars, lineNonSpace + qMax(0, lineWords - 1));
+	stats->unneededSpaces = unneededSpaces;
+	stats->textChecked = false;
+}
+
+static void
+computeTextChecks(const QString &text, SubtitleLine::TextStats *stats)
 {
-	return m_secondaryDoc->toPlainText().simplified().length();
+	stats->unneededDash = hasUnneededDash(text);
+	stats->capitalAfterEllipsis = hasCapitalAfterEllipsis(text);
+	stats->textChecked = true;
 }
 
-int
-SubtitleLine::secondaryWords() const
+quint64
+SubtitleLine::statsKey(bool primary) const
 {
-	QString text(m_secondaryDoc->toPlainText().simplified());
-	return text.length() ? text.count(' ') + 1 : 0;
+	const RichDocument *doc = primary ? m_primaryDoc : m_secondaryDoc;
+	return doc ? doc->cacheKey() : COMPACT_TEXT_KEY;
 }
 
-int
-SubtitleLine::secondaryLines() const
+const SubtitleLine::TextStats &
+SubtitleLine::primaryStats() const
 {
-	RichString text(m_secondaryDoc->toPlainText());
-	text.simplifyWhiteSpace();
-	return text.isEmpty() ? 0 : text.count('\n') + 1;
+	const quint64 key = statsKey(true);
+	if(m_primaryStatsKey != key) {
+		computeTextStats(primaryPlainText(), &m_primaryStats);
+		m_primaryStatsKey = key;
+	}
+	return m_primaryStats;
+}
+
+const SubtitleLine::TextStats &
+SubtitleLine::secondaryStats() const
+{
+	const quint64 key = statsKey(false);
+	if(m_secondaryStatsKey != key) {
+		computeTextStats(secondaryPlainText(), &m_secondaryStats);
+		m_secondaryStatsKey = key;
+	}
+	return m_secondaryStats;
+}
+
+const SubtitleLine::TextStats &
+SubtitleLine::checkedStats(bool primary) const
+{
+	const TextStats &textStats = stats(primary);
+	if(!textStats.textChecked)
+		computeTextChecks(plainText(primary), primary ? &m_primaryStats : &m_secondaryStats);
+	return textStats;
+}
+
+void
+SubtitleLine::updateStats(const QVector<SubtitleLine *> &lines, bool textChecks)
+{
+	struct StatsJob {
+		SubtitleLine *line;
+		bool primary;
+		quint64 key;
+		QString text;
+		TextStats stats;
+	};
+
+	// documents can't be read outside of their thread, plain texts are copied here
+	QVector<StatsJob> jobs;
+	for(SubtitleLine *line : lines) {
+		for(const bool primary : { true, false }) {
+			const quint64 key = line->statsKey(primary);
+			const bool valid = key == (primary ? line->m_primaryStatsKey : line->m_secondaryStatsKey);
+			if(!valid || (textChecks && !(primary ? line->m_primaryStats : line->m_secondaryStats).textChecked))
+				jobs.push_back(StatsJob{line, primary, key, line->plainText(primary), TextStats()});
+		}
+	}
+
+	Parallel::forEach(jobs.size(), [&](int i) {
+		StatsJob &job = jobs[i];
+		computeTextStats(job.text, &job.stats);
+		if(textChecks)
+			computeTextChecks(job.text, &job.stats);
+	});
+
+	for(const StatsJob &job : qAsConst(jobs)) {
+		if(job.primary) {
+			job.line->m_primaryStats = job.stats;
+			job.line->m_primaryStatsKey = job.key;
+		} else {
+			job.line->m_secondaryStats = job.stats;
+			job.line->m_secondaryStatsKey = job.key;
+		}
+	}
 }
 
 Time
@@ -529,15 +868,15 @@ SubtitleLine::autoDuration(int msecsPerChar, int msecsPerWord, int msecsPerLine,
 {
 	switch(calculationTarget) {
 	case Secondary:
-		return autoDuration(m_secondaryDoc->toPlainText(), msecsPerChar, msecsPerWord, msecsPerLine);
+		return autoDuration(secondaryPlainText(), msecsPerChar, msecsPerWord, msecsPerLine);
 	case Both: {
-		Time primary = autoDuration(m_primaryDoc->toPlainText(), msecsPerChar, msecsPerWord, msecsPerLine);
-		Time secondary = autoDuration(m_secondaryDoc->toPlainText(), msecsPerChar, msecsPerWord, msecsPerLine);
+		Time primary = autoDuration(primaryPlainText(), msecsPerChar, msecsPerWord, msecsPerLine);
+		Time secondary = autoDuration(secondaryPlainText(), msecsPerChar, msecsPerWord, msecsPerLine);
 		return primary > secondary ? primary : secondary;
 	}
 	case Primary:
 	default:
-		return autoDuration(m_primaryDoc->toPlainText(), msecsPerChar, msecsPerWord, msecsPerLine);
+		return autoDuration(primaryPlainText(), msecsPerChar, msecsPerWord, msecsPerLine);
 	}
 }
 
@@ -597,7 +936,7 @@ SubtitleLine::setErrorFlags(int errorFlags, bool value)
 bool
 SubtitleLine::checkEmptyPrimaryText(bool update)
 {
-	bool error = m_primaryDoc->isEmpty() || m_primaryDoc->toPlainText().trimmed().isEmpty();
+	bool error = primaryStats().characters == 0;
 
 	if(update)
 		setErrorFlags(EmptyPrimaryText, error);
@@ -608,7 +947,7 @@ SubtitleLine::checkEmptyPrimaryText(bool update)
 bool
 SubtitleLine::checkEmptySecondaryText(bool update)
 {
-	bool error = m_secondaryDoc->isEmpty() || m_secondaryDoc->toPlainText().trimmed().isEmpty();
+	bool error = secondaryStats().characters == 0;
 
 	if(update)
 		setErrorFlags(EmptySecondaryText, error);
@@ -619,7 +958,7 @@ SubtitleLine::checkEmptySecondaryText(bool update)
 bool
 SubtitleLine::checkUntranslatedText(bool update)
 {
-	bool error = m_primaryDoc->toPlainText() == m_secondaryDoc->toPlainText();
+	bool error = primaryStats().length == secondaryStats().length && primaryPlainText() == secondaryPlainText();
 
 	if(update)
 		setErrorFlags(UntranslatedText, error);
@@ -778,17 +1117,7 @@ SubtitleLine::checkMaxPrimaryCharsPerLine(int maxCharactersPerLine, bool update)
 {
 	Q_ASSERT(maxCharactersPerLine >= 0);
 
-	bool error = false;
-
-	QString text = primaryDoc()->toPlainText();
-	QStringList lines = text.split(u'\n');
-
-	for(auto line = lines.cbegin(); line != lines.cend(); ++line) {
-		if(line->simplified().length() > maxCharactersPerLine) {
-			error = true;
-			break;
-		}
-	}
+	bool error = primaryStats().maxLineCharacters > maxCharactersPerLine;
 
 	if(update)
 		setErrorFlags(MaxPrimaryCharsPerLine, error);
@@ -801,17 +1130,7 @@ SubtitleLine::checkMaxSecondaryCharsPerLine(int maxCharactersPerLine, bool updat
 {
 	Q_ASSERT(maxCharactersPerLine >= 0);
 
-	bool error = false;
-
-	QString text = secondaryDoc()->toPlainText();
-	QStringList lines = text.split(u'\n');
-
-	for(auto line = lines.cbegin(); line != lines.cend(); ++line) {
-		if(line->simplified().length() > maxCharactersPerLine) {
-			error = true;
-			break;
-		}
-	}
+	bool error = secondaryStats().maxLineCharacters > maxCharactersPerLine;
 
 	if(update)
 		setErrorFlags(MaxSecondaryCharsPerLine, error);
@@ -822,9 +1141,8 @@ SubtitleLine::checkMaxSecondaryCharsPerLine(int maxCharactersPerLine, bool updat
 bool
 SubtitleLine::checkPrimaryUnneededSpaces(bool update)
 {
-	static const QRegularExpression unneededSpaceRegExp("(^\\s|\\s$|¿\\s|¡\\s|\\s\\s|\\s!|\\s\\?|\\s:|\\s;|\\s,|\\s\\.)");
-
-	bool error = m_primaryDoc->indexOf(unneededSpaceRegExp) != -1;
+	// same as matching every line with (^\s|\s$|¿\s|¡\s|\s\s|\s!|\s\?|\s:|\s;|\s,|\s\.)
+	bool error = primaryStats().unneededSpaces;
 
 	if(update)
 		setErrorFlags(PrimaryUnneededSpaces, error);
@@ -835,9 +1153,8 @@ SubtitleLine::checkPrimaryUnneededSpaces(bool update)
 bool
 SubtitleLine::checkSecondaryUnneededSpaces(bool update)
 {
-	static const QRegularExpression unneededSpaceRegExp("(^\\s|\\s$|¿\\s|¡\\s|\\s\\s|\\s!|\\s\\?|\\s:|\\s;|\\s,|\\s\\.)");
-
-	bool error = m_secondaryDoc->indexOf(unneededSpaceRegExp) != -1;
+	// same as matching every line with (^\s|\s$|¿\s|¡\s|\s\s|\s!|\s\?|\s:|\s;|\s,|\s\.)
+	bool error = secondaryStats().unneededSpaces;
 
 	if(update)
 		setErrorFlags(SecondaryUnneededSpaces, error);
@@ -848,15 +1165,7 @@ SubtitleLine::checkSecondaryUnneededSpaces(bool update)
 bool
 SubtitleLine::checkPrimaryCapitalAfterEllipsis(bool update)
 {
-	staticRE$(capitalAfterEllipsisRegExp, "^\\s*\\.\\.\\.[¡¿\\.,;\\(\\[\\{\"'\\s]*", REu);
-
-	const QString text = m_primaryDoc->toPlainText();
-	QRegularExpressionMatchIterator it = capitalAfterEllipsisRegExp.globalMatch(text);
-	bool success = it.hasNext();
-	if(success) {
-		const QChar chr = text.at(it.next().capturedEnd());
-		success = chr.isLetter() && chr == chr.toUpper();
-	}
+	bool success = checkedStats(true).capitalAfterEllipsis;
 
 	if(update)
 		setErrorFlags(PrimaryCapitalAfterEllipsis, success);
@@ -867,15 +1176,7 @@ SubtitleLine::checkPrimaryCapitalAfterEllipsis(bool update)
 bool
 SubtitleLine::checkSecondaryCapitalAfterEllipsis(bool update)
 {
-	staticRE$(capitalAfterEllipsisRegExp, "^\\s*\\.\\.\\.[¡¿\\.,;\\(\\[\\{\"'\\s]*", REu);
-
-	const QString text = m_secondaryDoc->toPlainText();
-	QRegularExpressionMatchIterator it = capitalAfterEllipsisRegExp.globalMatch(text);
-	bool success = it.hasNext();
-	if(success) {
-		const QChar chr = text.at(it.next().capturedEnd());
-		success = chr.isLetter() && chr == chr.toUpper();
-	}
+	bool success = checkedStats(false).capitalAfterEllipsis;
 
 	if(update)
 		setErrorFlags(SecondaryCapitalAfterEllipsis, success);
@@ -886,9 +1187,7 @@ SubtitleLine::checkSecondaryCapitalAfterEllipsis(bool update)
 bool
 SubtitleLine::checkPrimaryUnneededDash(bool update)
 {
-	staticRE$(unneededDashRegExp, "(^|\n)\\s*-[^-]", REu);
-
-	bool success = m_primaryDoc->toPlainText().count(unneededDashRegExp) == 1;
+	bool success = checkedStats(true).unneededDash;
 
 	if(update)
 		setErrorFlags(PrimaryUnneededDash, success);
@@ -899,9 +1198,7 @@ SubtitleLine::checkPrimaryUnneededDash(bool update)
 bool
 SubtitleLine::checkSecondaryUnneededDash(bool update)
 {
-	staticRE$(unneededDashRegExp, "(^|\n)\\s*-[^-]", REu);
-
-	bool success = m_secondaryDoc->toPlainText().count(unneededDashRegExp) == 1;
+	bool success = checkedStats(false).unneededDash;
 
 	if(update)
 		setErrorFlags(SecondaryUnneededDash, success);
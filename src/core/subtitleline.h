@@ -10,12 +10,14 @@
 
 #include "core/time.h"
 #include "core/formatdata.h"
+#include "core/richstring.h"
 #include "core/subtitletarget.h"
 #include "helpers/objectref.h"
 
 #include <QExplicitlySharedDataPointer>
 #include <QObject>
 #include <QString>
+#include <QVector>
 
 
 namespace SubtitleComposer {
@@ -42,6 +44,8 @@ class SubtitleLine : public QObject
 	friend class Subtitle;
 	friend class SubtitleAction;
 	friend class SwapLinesTextsAction;
+	friend class AdjustLinesTimesAction;
+	friend class SetLinesTimesAction;
 	friend class SubtitleLineAction;
 	friend class SetLinePrimaryTextAction;
 	friend class SetLineSecondaryTextAction;
@@ -51,6 +55,7 @@ class SubtitleLine : public QObject
 	friend class SetLineTimesAction;
 	friend class SetLineStyleFlagsAction;
 	friend class SetLineErrorsAction;
+	friend class SetLinesErrorsAction;
 	friend class ToggleLineMarkedAction;
 	friend class Format;
 
@@ -145,9 +150,29 @@ public:
 	inline SubtitleLine * prevLine() const;
 	inline SubtitleLine * nextLine() const;
 
-	inline RichDocument * doc(bool primary) const { return primary ? m_primaryDoc : m_secondaryDoc; }
-	inline RichDocument * primaryDoc() const { return m_primaryDoc; }
-	inline RichDocument * secondaryDoc() const { return m_secondaryDoc; }
+	/**
+	 * @brief Text documents are created on first access
+	 *
+	 * Until then the text is kept as a compact RichString, use primaryText()/primaryPlainText()
+	 * and setPrimaryText() when the text is only read or replaced. releaseDocs() converts
+	 * documents that are not edited or displayed back to compact form.
+	 */
+	inline RichDocument * doc(bool primary) const { return primary ? primaryDoc() : secondaryDoc(); }
+	inline RichDocument * primaryDoc() const { return m_primaryDoc ? m_primaryDoc : createDoc(true); }
+	inline RichDocument * secondaryDoc() const { return m_secondaryDoc ? m_secondaryDoc : createDoc(false); }
+
+	RichString primaryText() const;
+	RichString secondaryText() const;
+	inline RichString text(bool primary) const { return primary ? primaryText() : secondaryText(); }
+
+	QString primaryPlainText() const;
+	QString secondaryPlainText() const;
+	inline QString plainText(bool primary) const { return primary ? primaryPlainText() : secondaryPlainText(); }
+
+	void setPrimaryText(const RichString &text);
+	void setSecondaryText(const RichString &text);
+
+	bool releaseDocs();
 
 	void breakText(int minBreakLength, SubtitleTarget target);
 	void unbreakText(SubtitleTarget target);
@@ -171,13 +196,39 @@ public:
 	inline bool containsTime(const Time &time) const { return m_showTime <= time && time <= m_hideTime; }
 	inline bool intersectsTimespan(const Time &start, const Time &end) const { return m_showTime <= end && start <= m_hideTime; }
 
-	int primaryCharacters() const;
-	int primaryWords() const;
-	int primaryLines() const;
-
-	int secondaryCharacters() const;
-	int secondaryWords() const;
-	int secondaryLines() const;
+	/**
+	 * @brief Plain text statistics, computed in a single pass and kept until the text changes
+	 */
+	struct TextStats {
+		int length = 0;                 // plain text length
+		int characters = 0;             // length of simplified text
+		int words = 0;
+		int lines = 0;                  // lines that aren't blank
+		int maxLineCharacters = 0;      // length of longest simplified line
+		bool unneededSpaces = false;
+		// regexp checks are only done for error checking, see checkedStats()
+		bool textChecked = false;
+		bool unneededDash = false;
+		bool capitalAfterEllipsis = false;
+	};
+
+	const TextStats & primaryStats() const;
+	const TextStats & secondaryStats() const;
+	inline const TextStats & stats(bool primary) const { return primary ? primaryStats() : secondaryStats(); }
+
+	/**
+	 * @brief Compute text stats of @p lines that don't have them cached yet using all CPU cores
+	 * @param textChecks also compute the regexp text checks of TextStats
+	 */
+	static void updateStats(const QVector<SubtitleLine *> &lines, bool textChecks = false);
+
+	inline int primaryCharacters() const { return primaryStats().characters; }
+	inline int primaryWords() const { return primaryStats().words; }
+	inline int primaryLines() const { return primaryStats().lines; }
+
+	inline int secondaryCharacters() const { return secondaryStats().characters; }
+	inline int secondaryWords() const { return secondaryStats().words; }
+	inline int secondaryLines() const { return secondaryStats().lines; }
 
 	static Time autoDuration(const QString &text, int msecsPerChar, int msecsPerWord, int msecsPerLine);
 	Time autoDuration(int msecsPerChar, int msecsPerWord, int msecsPerLine, SubtitleTarget calculationTarget);
@@ -245,9 +296,16 @@ private:
 	void setPrimaryDoc(RichDocument *doc);
 	void setSecondaryDoc(RichDocument *doc);
 	void setTexts(RichDocument *pText, RichDocument *sText);
+	void takeText(bool primary, const SubtitleLine *from, bool fromPrimary);
 	void primaryDocumentChanged();
 	void secondaryDocumentChanged();
 
+	RichDocument * createDoc(bool primary) const;
+	bool releaseDoc(bool primary);
+
+	quint64 statsKey(bool primary) const;
+	const TextStats & checkedStats(bool primary) const;
+
 	void setupSignals();
 
 	inline bool ignoreDocChanges(bool ignore) {
@@ -258,8 +316,20 @@ private:
 
 private:
 	QExplicitlySharedDataPointer<Subtitle> m_subtitle;
-	RichDocument *m_primaryDoc;
-	RichDocument *m_secondaryDoc;
+	mutable RichDocument *m_primaryDoc;
+	mutable RichDocument *m_secondaryDoc;
+	mutable RichString m_primaryText;
+	mutable RichString m_secondaryText;
+	bool m_primaryDocPinned = false;
+	bool m_secondaryDocPinned = false;
+	// cacheKey() of the released document, recreated document gets it back - 0 if the text changed since
+	quint64 m_primaryTextKey = 0;
+	quint64 m_secondaryTextKey = 0;
+	// stats are valid while the key matches document's cacheKey(), 0 is never valid
+	mutable TextStats m_primaryStats;
+	mutable TextStats m_secondaryStats;
+	mutable quint64 m_primaryStatsKey = 0;
+	mutable quint64 m_secondaryStatsKey = 0;
 	Time m_showTime;
 	Time m_hideTime;
 	int m_errorFlags;
@@ -16,6 +16,8 @@
 
 #include <KLocalizedString>
 
+#include <utility>
+
 using namespace SubtitleComposer;
 
 // *** SubtitleAction
@@ -88,15 +90,10 @@ InsertLinesAction::redo()
 {
 	emit m_subtitle->linesAboutToBeInserted(m_insertIndex, m_lastIndex);
 
-	SubtitleLine *line;
-	int insertOffset = 0;
-
-	while(!m_lines.isEmpty()) {
-		line = m_lines.takeFirst();
-		auto pos = m_subtitle->m_lines.cbegin() + m_insertIndex + insertOffset++;
+	for(SubtitleLine *line : qAsConst(m_lines))
 		setLineSubtitle(line);
-		m_subtitle->m_lines.insert(pos, line);
-	}
+	m_subtitle->insertAt(m_insertIndex, m_lines);
+	m_lines.clear();
 
 	emit m_subtitle->linesInserted(m_insertIndex, m_lastIndex);
 }
@@ -106,11 +103,9 @@ InsertLinesAction::undo()
 {
 	emit m_subtitle->linesAboutToBeRemoved(m_insertIndex, m_lastIndex);
 
-	for(int index = m_insertIndex; index <= m_lastIndex; ++index) {
-		SubtitleLine *line = m_subtitle->takeAt(m_insertIndex);
+	m_lines = m_subtitle->takeRange(m_insertIndex, m_lastIndex);
+	for(SubtitleLine *line : qAsConst(m_lines))
 		clearLineSubtitle(line);
-		m_lines.append(line);
-	}
 
 	emit m_subtitle->linesRemoved(m_insertIndex, m_lastIndex);
 }
@@ -166,11 +161,9 @@ RemoveLinesAction::redo()
 {
 	emit m_subtitle->linesAboutToBeRemoved(m_firstIndex, m_lastIndex);
 
-	for(int index = m_firstIndex; index <= m_lastIndex; ++index) {
-		SubtitleLine *line = m_subtitle->takeAt(m_firstIndex);
+	m_lines = m_subtitle->takeRange(m_firstIndex, m_lastIndex);
+	for(SubtitleLine *line : qAsConst(m_lines))
 		clearLineSubtitle(line);
-		m_lines.append(line);
-	}
 
 	emit m_subtitle->linesRemoved(m_firstIndex, m_lastIndex);
 }
@@ -180,14 +173,10 @@ RemoveLinesAction::undo()
 {
 	emit m_subtitle->linesAboutToBeInserted(m_firstIndex, m_lastIndex);
 
-	int insertOffset = 0;
-
-	while(!m_lines.isEmpty()) {
-		SubtitleLine *line = m_lines.takeFirst();
-		auto pos = m_subtitle->m_lines.cbegin() + m_firstIndex + insertOffset++;
+	for(SubtitleLine *line : qAsConst(m_lines))
 		setLineSubtitle(line);
-		m_subtitle->m_lines.insert(pos, line);
-	}
+	m_subtitle->insertAt(m_firstIndex, m_lines);
+	m_lines.clear();
 
 	emit m_subtitle->linesInserted(m_firstIndex, m_lastIndex);
 }
@@ -278,6 +267,53 @@ MoveLineAction::undo()
 }
 
 
+// *** SortLinesAction
+SortLinesAction::SortLinesAction(Subtitle *subtitle, int firstIndex, const QVector<int> &order)
+	: SubtitleAction(subtitle, UndoStack::Both, i18n("Sort")),
+	  m_firstIndex(firstIndex),
+	  m_lastIndex(firstIndex + order.size() - 1),
+	  m_order(order)
+{
+	Q_ASSERT(m_firstIndex >= 0);
+	Q_ASSERT(m_lastIndex < m_subtitle->linesCount());
+}
+
+SortLinesAction::~SortLinesAction()
+{}
+
+void
+SortLinesAction::reorder(bool inverse)
+{
+	emit m_subtitle->linesAboutToBeRemoved(m_firstIndex, m_lastIndex);
+	const QList<SubtitleLine *> lines = m_subtitle->takeRange(m_firstIndex, m_lastIndex);
+	emit m_subtitle->linesRemoved(m_firstIndex, m_lastIndex);
+
+	QList<SubtitleLine *> sorted = lines;
+	for(int i = 0, n = m_order.size(); i < n; i++) {
+		if(inverse)
+			sorted[m_order.at(i)] = lines.at(i);
+		else
+			sorted[i] = lines.at(m_order.at(i));
+	}
+
+	emit m_subtitle->linesAboutToBeInserted(m_firstIndex, m_lastIndex);
+	m_subtitle->insertAt(m_firstIndex, sorted);
+	emit m_subtitle->linesInserted(m_firstIndex, m_lastIndex);
+}
+
+void
+SortLinesAction::redo()
+{
+	reorder(false);
+}
+
+void
+SortLinesAction::undo()
+{
+	reorder(true);
+}
+
+
 // *** SwapLinesTextsAction
 SwapLinesTextsAction::SwapLinesTextsAction(Subtitle *subtitle, const RangeList &ranges) :
 	SubtitleAction(subtitle, UndoStack::Both, i18n("Swap Texts")),
@@ -292,15 +328,126 @@ SwapLinesTextsAction::redo()
 {
 	for(SubtitleIterator it(*m_subtitle, m_ranges); it.current(); ++it) {
 		SubtitleLine *line = it.current();
-		RichDocument *tmp = line->m_primaryDoc;
-		line->m_primaryDoc = line->m_secondaryDoc;
-		line->m_secondaryDoc = tmp;
+		std::swap(line->m_primaryDoc, line->m_secondaryDoc);
+		std::swap(line->m_primaryText, line->m_secondaryText);
+		std::swap(line->m_primaryDocPinned, line->m_secondaryDocPinned);
+		std::swap(line->m_primaryStats, line->m_secondaryStats);
+		std::swap(line->m_primaryStatsKey, line->m_secondaryStatsKey);
 		emit line->primaryTextChanged();
 		emit line->secondaryTextChanged();
 	}
 }
 
 
+// *** AdjustLinesTimesAction
+AdjustLinesTimesAction::AdjustLinesTimesAction(Subtitle *subtitle, const RangeList &ranges, double shiftMseconds, double scaleFactor, const QString &description)
+	: SubtitleAction(subtitle, UndoStack::Both, description),
+	  m_ranges(ranges),
+	  m_shiftMseconds(shiftMseconds),
+	  m_scaleFactor(scaleFactor)
+{}
+
+AdjustLinesTimesAction::~AdjustLinesTimesAction()
+{}
+
+void
+AdjustLinesTimesAction::emitTimesChanged()
+{
+	const int lastIndex = m_subtitle->lastIndex();
+	for(const Range &range : m_ranges) {
+		if(range.start() > lastIndex)
+			continue;
+		emit m_subtitle->linesTimesChanged(range.start(), qMin(range.end(), lastIndex));
+	}
+}
+
+void
+AdjustLinesTimesAction::redo()
+{
+	// after undo() lines have the original times again, so they are saved only once
+	const bool saveTimes = m_times.isEmpty();
+	for(SubtitleIterator it(*m_subtitle, m_ranges); it.current(); ++it) {
+		SubtitleLine *line = it.current();
+		if(saveTimes) {
+			m_times.append(line->m_showTime);
+			m_times.append(line->m_hideTime);
+		}
+		line->m_showTime = Time(line->m_showTime.toMillis() * m_scaleFactor + m_shiftMseconds);
+		line->m_hideTime = Time(line->m_hideTime.toMillis() * m_scaleFactor + m_shiftMseconds);
+	}
+
+	emitTimesChanged();
+}
+
+void
+AdjustLinesTimesAction::undo()
+{
+	auto time = m_times.cbegin();
+	for(SubtitleIterator it(*m_subtitle, m_ranges); it.current() && time != m_times.cend(); ++it) {
+		SubtitleLine *line = it.current();
+		line->m_showTime = *time++;
+		line->m_hideTime = *time++;
+	}
+
+	emitTimesChanged();
+}
+
+
+// *** SetLinesTimesAction
+SetLinesTimesAction::SetLinesTimesAction(Subtitle *subtitle, const RangeList &ranges, const QVector<Time> &times, const QString &description)
+	: SubtitleAction(subtitle, UndoStack::Both, description),
+	  m_ranges(ranges),
+	  m_times(times)
+{}
+
+SetLinesTimesAction::~SetLinesTimesAction()
+{}
+
+void
+SetLinesTimesAction::redo()
+{
+	auto time = m_times.begin();
+	for(SubtitleIterator it(*m_subtitle, m_ranges); it.current() && time != m_times.end(); ++it) {
+		SubtitleLine *line = it.current();
+		std::swap(line->m_showTime, *time++);
+		std::swap(line->m_hideTime, *time++);
+	}
+
+	const int lastIndex = m_subtitle->lastIndex();
+	for(const Range &range : m_ranges) {
+		if(range.start() > lastIndex)
+			continue;
+		emit m_subtitle->linesTimesChanged(range.start(), qMin(range.end(), lastIndex));
+	}
+}
+
+// *** SetLinesErrorsAction
+SetLinesErrorsAction::SetLinesErrorsAction(Subtitle *subtitle, const RangeList &ranges, const QVector<int> &errorFlags)
+	: SubtitleAction(subtitle, UndoStack::None, i18n("Check Lines Errors")),
+	  m_ranges(ranges),
+	  m_errorFlags(errorFlags)
+{}
+
+SetLinesErrorsAction::~SetLinesErrorsAction()
+{}
+
+void
+SetLinesErrorsAction::redo()
+{
+	auto errorFlags = m_errorFlags.begin();
+	for(SubtitleIterator it(*m_subtitle, m_ranges); it.current() && errorFlags != m_errorFlags.end(); ++it)
+		std::swap(it.current()->m_errorFlags, *errorFlags++);
+
+	// views are refreshed once instead of for every line
+	const int lastIndex = m_subtitle->lastIndex();
+	for(const Range &range : m_ranges) {
+		if(range.start() > lastIndex)
+			continue;
+		emit m_subtitle->linesErrorFlagsChanged(range.start(), qMin(range.end(), lastIndex));
+	}
+}
+
+
 // *** ChangeStylesheetAction
 EditStylesheetAction::EditStylesheetAction(Subtitle *subtitle, QTextEdit *textEdit)
 	: SubtitleAction(subtitle, UndoStack::Primary, i18n("Change stylesheet")),
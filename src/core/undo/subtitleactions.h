@@ -16,6 +16,7 @@
 
 #include <QString>
 #include <QList>
+#include <QVector>
 
 QT_FORWARD_DECLARE_CLASS(QTextEdit)
 
@@ -29,16 +30,20 @@ public:
 
 	inline void setLineSubtitle(SubtitleLine *line)
 	{
-		line->m_primaryDoc->setStylesheet(m_subtitle->stylesheet());
-		line->m_secondaryDoc->setStylesheet(m_subtitle->stylesheet());
+		if(line->m_primaryDoc)
+			line->m_primaryDoc->setStylesheet(m_subtitle->stylesheet());
+		if(line->m_secondaryDoc)
+			line->m_secondaryDoc->setStylesheet(m_subtitle->stylesheet());
 		line->m_subtitle = m_subtitle;
 	}
 
 	inline void clearLineSubtitle(SubtitleLine *line)
 	{
 		line->m_subtitle = nullptr;
-		line->m_primaryDoc->setStylesheet(nullptr);
-		line->m_secondaryDoc->setStylesheet(nullptr);
+		if(line->m_primaryDoc)
+			line->m_primaryDoc->setStylesheet(nullptr);
+		if(line->m_secondaryDoc)
+			line->m_secondaryDoc->setStylesheet(nullptr);
 	}
 };
 
@@ -113,6 +118,28 @@ private:
 	int m_toIndex;
 };
 
+class SortLinesAction : public SubtitleAction
+{
+public:
+	SortLinesAction(Subtitle *subtitle, int firstIndex, const QVector<int> &order);
+	virtual ~SortLinesAction();
+
+	inline int id() const override { return UndoAction::SortLines; }
+
+protected:
+	void redo() override;
+	void undo() override;
+
+private:
+	void reorder(bool inverse);
+
+private:
+	int m_firstIndex;
+	int m_lastIndex;
+	// m_order[i] is the previous position (relative to m_firstIndex) of line placed at position i
+	QVector<int> m_order;
+};
+
 class SwapLinesTextsAction : public SubtitleAction
 {
 public:
@@ -128,6 +155,66 @@ private:
 	const RangeList m_ranges;
 };
 
+class AdjustLinesTimesAction : public SubtitleAction
+{
+public:
+	AdjustLinesTimesAction(Subtitle *subtitle, const RangeList &ranges, double shiftMseconds, double scaleFactor, const QString &description);
+	virtual ~AdjustLinesTimesAction();
+
+	inline int id() const override { return UndoAction::AdjustLinesTimes; }
+
+protected:
+	void redo() override;
+	void undo() override;
+
+private:
+	void emitTimesChanged();
+
+private:
+	const RangeList m_ranges;
+	const double m_shiftMseconds;
+	const double m_scaleFactor;
+	// show and hide times of lines before the change
+	QVector<Time> m_times;
+};
+
+class SetLinesTimesAction : public SubtitleAction
+{
+public:
+	/**
+	 * @brief Set times of all lines in @p ranges, @p times holds show and hide time of every line
+	 */
+	SetLinesTimesAction(Subtitle *subtitle, const RangeList &ranges, const QVector<Time> &times, const QString &description);
+	virtual ~SetLinesTimesAction();
+
+	inline int id() const override { return UndoAction::SetLinesTimes; }
+
+protected:
+	void redo() override;
+
+private:
+	const RangeList m_ranges;
+	// swapped with the line times on every redo/undo
+	QVector<Time> m_times;
+};
+
+class SetLinesErrorsAction : public SubtitleAction
+{
+public:
+	SetLinesErrorsAction(Subtitle *subtitle, const RangeList &ranges, const QVector<int> &errorFlags);
+	virtual ~SetLinesErrorsAction();
+
+	inline int id() const override { return UndoAction::SetLinesErrors; }
+
+protected:
+	void redo() override;
+
+private:
+	const RangeList m_ranges;
+	// error flags of lines in ranges, swapped with the lines on every redo/undo
+	QVector<int> m_errorFlags;
+};
+
 class EditStylesheetAction : public SubtitleAction
 {
 public:
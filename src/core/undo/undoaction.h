@@ -27,8 +27,12 @@ public:
 		InsertLines,
 		RemoveLines,
 		MoveLine,
+		SortLines,
 		SwapLinesTexts,
+		AdjustLinesTimes,
 		ChangeStylesheet,
+		SetLinesErrors,
+		SetLinesTimes,
 
 		// subtitle line actions
 		SetLinePrimaryText,
@@ -0,0 +1,49 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "snaptospeechdialog.h"
+
+#include <QLabel>
+#include <QGroupBox>
+#include <QGridLayout>
+#include <QSpinBox>
+
+using namespace SubtitleComposer;
+
+SnapToSpeechDialog::SnapToSpeechDialog(QWidget *parent) :
+	ActionWithTargetDialog(i18n("Snap Times to Speech"), parent)
+{
+	QGroupBox *settingsGroupBox = createGroupBox(i18nc("@title:group", "Settings"));
+
+	m_maxDistanceSpinBox = new QSpinBox(settingsGroupBox);
+	m_maxDistanceSpinBox->setSuffix(i18n(" msecs"));
+	m_maxDistanceSpinBox->setMinimum(10);
+	m_maxDistanceSpinBox->setMaximum(5000);
+	m_maxDistanceSpinBox->setSingleStep(50);
+	m_maxDistanceSpinBox->setValue(500);
+
+	QLabel *maxDistanceLabel = new QLabel(settingsGroupBox);
+	maxDistanceLabel->setText(i18n("Maximum time change:"));
+	maxDistanceLabel->setBuddy(m_maxDistanceSpinBox);
+
+	createLineTargetsButtonGroup();
+
+	QGridLayout *settingsLayout = createLayout(settingsGroupBox);
+	settingsLayout->addWidget(maxDistanceLabel, 0, 0, Qt::AlignRight | Qt::AlignVCenter);
+	settingsLayout->addWidget(m_maxDistanceSpinBox, 0, 1);
+}
+
+Time
+SnapToSpeechDialog::maximumDistance() const
+{
+	return Time(m_maxDistanceSpinBox->value());
+}
+
+void
+SnapToSpeechDialog::setMaximumDistance(const Time &time)
+{
+	m_maxDistanceSpinBox->setValue(time.toMillis());
+}
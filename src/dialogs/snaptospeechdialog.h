@@ -0,0 +1,28 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef SNAPTOSPEECHDIALOG_H
+#define SNAPTOSPEECHDIALOG_H
+
+#include "actionwithtargetdialog.h"
+#include "core/time.h"
+
+QT_FORWARD_DECLARE_CLASS(QSpinBox)
+
+namespace SubtitleComposer {
+class SnapToSpeechDialog : public ActionWithTargetDialog
+{
+public:
+	SnapToSpeechDialog(QWidget *parent = 0);
+
+	Time maximumDistance() const;
+	void setMaximumDistance(const Time &time);
+
+private:
+	QSpinBox *m_maxDistanceSpinBox;
+};
+}
+#endif
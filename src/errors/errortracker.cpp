@@ -46,6 +46,7 @@ ErrorTracker::connectSlots()
 	connect(m_subtitle.constData(), &Subtitle::lineSecondaryTextChanged, this, &ErrorTracker::onLineSecondaryTextChanged);
 	connect(m_subtitle.constData(), &Subtitle::lineShowTimeChanged, this, &ErrorTracker::onLineTimesChanged);
 	connect(m_subtitle.constData(), &Subtitle::lineHideTimeChanged, this, &ErrorTracker::onLineTimesChanged);
+	connect(m_subtitle.constData(), &Subtitle::linesTimesChanged, this, &ErrorTracker::onLinesTimesChanged);
 }
 
 void
@@ -82,6 +83,19 @@ ErrorTracker::onLineTimesChanged(SubtitleLine *line)
 		updateLineErrors(prevLine, prevLine->errorFlags() & SubtitleLine::OverlapsWithNext);
 }
 
+void
+ErrorTracker::onLinesTimesChanged(int firstIndex, int lastIndex)
+{
+	for(int i = firstIndex; i <= lastIndex; i++) {
+		SubtitleLine *line = const_cast<SubtitleLine *>(m_subtitle->line(i));
+		updateLineErrors(line, line->errorFlags() & SubtitleLine::TimesErrors);
+	}
+
+	SubtitleLine *prevLine = const_cast<SubtitleLine *>(m_subtitle->line(firstIndex - 1));
+	if(prevLine)
+		updateLineErrors(prevLine, prevLine->errorFlags() & SubtitleLine::OverlapsWithNext);
+}
+
 void
 ErrorTracker::onConfigChanged()
 {
@@ -36,6 +36,7 @@ private slots:
 	void onLinePrimaryTextChanged(SubtitleLine *line);
 	void onLineSecondaryTextChanged(SubtitleLine *line);
 	void onLineTimesChanged(SubtitleLine *line);
+	void onLinesTimesChanged(int firstIndex, int lastIndex);
 
 	void onConfigChanged();
 
@@ -41,16 +41,27 @@
 #include <QFileDevice>
 #include <QFileInfo>
 #include <QSaveFile>
+#include <QScopedPointer>
 #include <QTextCodec>
+#include <QTextDecoder>
 
 #include <QUrl>
+#include <QVector>
+
+#include <algorithm>
 
 #ifdef HAVE_ICU
 #	include <unicode/ucsdet.h>
 #endif
 
+// upper bound of text buffer preallocated from file size, bigger files grow it while decoding
+#define MAX_TEXT_RESERVE (256 * 1024 * 1024)
+
 using namespace SubtitleComposer;
 
+// amount of text that InputFormat::probe() gets to see
+static const int probeSize = 4096;
+
 FormatManager &
 FormatManager::instance()
 {
@@ -169,6 +180,33 @@ FormatManager::readBinary(Subtitle &subtitle, const QUrl &url, bool primary,
 	return ERROR;
 }
 
+/**
+ * @brief Append decoded @p chunk to @p text converting CRLF and CR line breaks to LF.
+ * @p skipLineFeed carries a trailing CR over to the next chunk so split CRLF pairs
+ * are collapsed too.
+ */
+static void
+appendNormalizedText(QString &text, const QString &chunk, bool *skipLineFeed)
+{
+	const int oldSize = text.size();
+	text.resize(oldSize + chunk.size());
+	QChar *out = text.data() + oldSize;
+	for(const QChar ch : chunk) {
+		if(ch == QChar::CarriageReturn) {
+			*out++ = QChar::LineFeed;
+			*skipLineFeed = true;
+			continue;
+		}
+		if(ch == QChar::LineFeed && *skipLineFeed) {
+			*skipLineFeed = false;
+			continue;
+		}
+		*skipLineFeed = false;
+		*out++ = ch;
+	}
+	text.resize(out - text.constData());
+}
+
 FormatManager::Status
 FormatManager::readText(Subtitle &subtitle, const QUrl &url, bool primary,
 						QTextCodec **codec, QString *formatName) const
@@ -176,27 +214,35 @@ FormatManager::readText(Subtitle &subtitle, const QUrl &url, bool primary,
 	QFile file(url.toLocalFile());
 	if(!file.open(QIODevice::ReadOnly))
 		return ERROR;
-	// WARNING: only 1MB of text subtitle is being read here
-	QByteArray byteData = file.read(1024 * 1024);
-	file.close();
 
-	QString stringData;
-	if(!codec) {
-		// don't care about text nor text encoding
-		stringData = QString::fromLatin1(byteData);
-	} else {
+	// encoding is detected from the first chunk only, the rest of the file is
+	// decoded incrementally so we never keep the whole raw file around
+	const qint64 chunkSize = 1024 * 1024;
+	QByteArray byteData = file.read(chunkSize);
+
+	QScopedPointer<QTextDecoder> decoder;
+	if(codec) {
 		if(!*codec) {
 			QTextCodec *c = detectEncoding(byteData);
 			if(!c)
 				return CANCEL;
 			*codec = c;
 		}
-		if(*codec)
-			stringData = (*codec)->toUnicode(byteData);
+		decoder.reset((*codec)->makeDecoder());
 	}
 
-	stringData.replace(QLatin1String("\r\n"), QLatin1String("\n"));
-	stringData.replace('\r', '\n');
+	QString stringData;
+	// decoded text is never longer than the encoded byte data
+	stringData.reserve(static_cast<int>(qMin<qint64>(file.size(), MAX_TEXT_RESERVE)));
+	bool skipLineFeed = false;
+	while(!byteData.isEmpty()) {
+		// when we don't care about text nor text encoding latin1 is good enough
+		appendNormalizedText(stringData, decoder ? decoder->toUnicode(byteData) : QString::fromLatin1(byteData), &skipLineFeed);
+		byteData = file.read(chunkSize);
+	}
+	file.close();
+	if(stringData.capacity() - stringData.size() > stringData.size() / 2)
+		stringData.squeeze();
 
 	const QString extension = QFileInfo(url.path()).suffix();
 
@@ -211,14 +257,37 @@ FormatManager::readText(Subtitle &subtitle, const QUrl &url, bool primary,
 		}
 	}
 
-	// attempt to parse subtitles based on content
+	// attempt to parse subtitles based on content - probe the head of the data and
+	// run full parsers for formats that recognized it first, best match first
+	const QString sample = stringData.left(probeSize);
+	QVector<QPair<int, const InputFormat *>> candidates;
+	QVector<const InputFormat *> unrecognized;
 	for(QMap<QString, InputFormat *>::ConstIterator it = m_inputFormats.begin(), end = m_inputFormats.end(); it != end; ++it) {
 		if(!it.value()->knowsExtension(extension)) {
-			if(it.value()->readSubtitle(subtitle, primary, stringData)) {
-				if(formatName)
-					*formatName = it.value()->name();
-				return SUCCESS;
-			}
+			const int score = it.value()->probe(sample);
+			if(score > 0)
+				candidates.push_back(qMakePair(score, it.value()));
+			else
+				unrecognized.push_back(it.value());
+		}
+	}
+	std::stable_sort(candidates.begin(), candidates.end(),
+		[](const QPair<int, const InputFormat *> &a, const QPair<int, const InputFormat *> &b) { return a.first > b.first; });
+	for(const QPair<int, const InputFormat *> &candidate : qAsConst(candidates)) {
+		if(candidate.second->readSubtitle(subtitle, primary, stringData)) {
+			if(formatName)
+				*formatName = candidate.second->name();
+			return SUCCESS;
+		}
+	}
+
+	// content recognizable only past the probed head (e.g. after a long header) still
+	// has to load, so the remaining formats get a full parse too
+	for(const InputFormat *format : qAsConst(unrecognized)) {
+		if(format->readSubtitle(subtitle, primary, stringData)) {
+			if(formatName)
+				*formatName = format->name();
+			return SUCCESS;
 		}
 	}
 
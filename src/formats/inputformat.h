@@ -30,6 +30,12 @@ public:
 		return true;
 	}
 
+	/**
+	 * @brief Quickly check if @p sample (head of the document) looks like this format
+	 * @return confidence score 0-100, 0 meaning the data can't be parsed by this format
+	 */
+	virtual int probe(const QString &sample) const = 0;
+
 	virtual bool isBinary() const { return false; }
 	virtual FormatManager::Status readBinary(Subtitle &, const QUrl &) { return FormatManager::ERROR; }
 
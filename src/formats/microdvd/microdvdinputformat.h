@@ -25,6 +25,12 @@ protected:
 		: InputFormat($("MicroDVD"), QStringList() << $("sub") << $("txt"))
 	{}
 
+	int probe(const QString &sample) const override
+	{
+		staticRE$(reProbe, "\\{\\d+\\}\\{\\d+\\}[^\n]+\n", REu);
+		return sample.contains(reProbe) ? 90 : 0;
+	}
+
 	bool parseSubtitles(Subtitle &subtitle, const QString &data) const override
 	{
 		staticRE$(lineRE, "\\{(\\d+)\\}\\{(\\d+)\\}([^\n]+)\n", REu | REi);
@@ -50,6 +56,7 @@ protected:
 		if(!itLine.hasNext())
 			return false;
 
+		QList<SubtitleLine *> lines;
 		do {
 			mLine = itLine.next();
 
@@ -118,10 +125,12 @@ protected:
 			}
 
 			SubtitleLine *l = new SubtitleLine(showTime, hideTime);
-			l->primaryDoc()->setRichText(richText.replace('|', '\n'), true);
-			subtitle.insertLine(l);
+			l->setPrimaryText(richText.replace('|', '\n'));
+			lines.append(l);
 		} while(itLine.hasNext());
 
+		subtitle.insertLines(lines);
+
 		return true;
 	}
 };
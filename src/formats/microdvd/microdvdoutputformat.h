@@ -35,7 +35,7 @@ protected:
 		for(SubtitleIterator it(subtitle); it.current(); ++it) {
 			const SubtitleLine *line = it.current();
 
-			const RichString &text = (primary ? line->primaryDoc() : line->secondaryDoc())->toRichText();
+			const RichString &text = line->text(primary);
 			QString subtitle;
 
 			int prevStyle = 0;
@@ -24,6 +24,12 @@ protected:
 		: InputFormat($("MPlayer"), QStringList($("mpl")))
 	{}
 
+	int probe(const QString &sample) const override
+	{
+		staticRE$(reProbe, "(^|\n)\\d+,\\d+,0,[^\n]+", REu);
+		return sample.contains(reProbe) ? 80 : 0;
+	}
+
 	bool parseSubtitles(Subtitle &subtitle, const QString &data) const override
 	{
 		staticRE$(lineRE, "(^|\n)(\\d+),(\\d+),0,([^\n]+)[^\n]", REu | REi);
@@ -34,6 +40,7 @@ protected:
 		if(!itLine.hasNext())
 			return false;
 
+		QList<SubtitleLine *> lines;
 		do {
 			const QRegularExpressionMatch mLine = itLine.next();
 			const Time showTime(static_cast<long>((mLine.captured(1).toLong() / fps) * 1000));
@@ -41,10 +48,12 @@ protected:
 			const QString text = mLine.captured(3).replace(QChar('|'), QChar('\n'));
 
 			SubtitleLine *line = new SubtitleLine(showTime, hideTime);
-			line->primaryDoc()->setPlainText(text);
-			subtitle.insertLine(line);
+			line->setPrimaryText(RichString(text));
+			lines.append(line);
 		} while(itLine.hasNext());
 
+		subtitle.insertLines(lines);
+
 		return true;
 	}
 };
@@ -24,6 +24,12 @@ protected:
 		: InputFormat($("MPlayer2"), QStringList($("mpl")))
 	{}
 
+	int probe(const QString &sample) const override
+	{
+		staticRE$(reProbe, "\\[\\d+\\]\\[\\d+\\][^\n]+\n", REu);
+		return sample.contains(reProbe) ? 90 : 0;
+	}
+
 	bool parseSubtitles(Subtitle &subtitle, const QString &data) const override
 	{
 		staticRE$(lineRE, "\\[(\\d+)\\]\\[(\\d+)\\]([^\n]+)\n", REu | REi);
@@ -32,6 +38,7 @@ protected:
 		if(!itLine.hasNext())
 			return false;
 
+		QList<SubtitleLine *> lines;
 		do {
 			const QRegularExpressionMatch mLine = itLine.next();
 			const Time showTime(mLine.captured(1).toInt() * 100);
@@ -39,10 +46,12 @@ protected:
 			const QString text = mLine.captured(3).replace(QChar('|'), QChar('\n'));
 
 			SubtitleLine *line = new SubtitleLine(showTime, hideTime);
-			line->primaryDoc()->setPlainText(text);
-			subtitle.insertLine(line);
+			line->setPrimaryText(RichString(text));
+			lines.append(line);
 		} while(itLine.hasNext());
 
+		subtitle.insertLines(lines);
+
 		return true;
 	}
 };
@@ -10,9 +10,13 @@
 
 #include "core/richtext/richdocument.h"
 #include "helpers/common.h"
+#include "helpers/parallel.h"
 #include "formats/inputformat.h"
 
 #include <QRegularExpression>
+#include <QVector>
+
+#include <limits>
 
 namespace SubtitleComposer {
 class SubRipInputFormat : public InputFormat
@@ -25,32 +29,135 @@ protected:
 
 	{}
 
-	bool parseSubtitles(Subtitle &subtitle, const QString &data) const override
+	int probe(const QString &sample) const override
 	{
-		staticRE$(reTime, "[\\d]+\n([0-2][0-9]):([0-5][0-9]):([0-5][0-9])[,\\.]([0-9]+) --> ([0-2][0-9]):([0-5][0-9]):([0-5][0-9])[,\\.]([0-9]+)\n", REu);
+		staticRE$(reProbe, "[\\d]+\n[0-2][0-9]:[0-5][0-9]:[0-5][0-9][,\\.][0-9]+ --> ", REu);
+		return sample.contains(reProbe) ? 90 : 0;
+	}
 
-		QRegularExpressionMatchIterator itTime = reTime.globalMatch(data);
-		if(!itTime.hasNext())
+	bool parseSubtitles(Subtitle &subtitle, const QString &data) const override
+	{
+		const QChar *str = data.constData();
+		const int len = data.length();
+
+		struct Cue {
+			Time showTime;
+			Time hideTime;
+			int textStart;
+			int textEnd;
+			RichString text;
+		};
+		QVector<Cue> cues;
+
+		// find cue boundaries
+		int cueStart;
+		Time showTime;
+		Time hideTime;
+		int off = findCue(str, 0, len, &cueStart, &showTime, &hideTime);
+		if(off == -1)
 			return false;
 
 		do {
-			QRegularExpressionMatch mTime = itTime.next();
+			int nextStart;
+			Time nextShowTime;
+			Time nextHideTime;
+			const int nextOff = findCue(str, off, len, &nextStart, &nextShowTime, &nextHideTime);
+
+			// text is everything up to the next cue, trimmed
+			int textEnd = nextOff == -1 ? len : nextStart;
+			while(off < textEnd && str[off].isSpace())
+				off++;
+			while(textEnd > off && str[textEnd - 1].isSpace())
+				textEnd--;
+
+			cues.push_back(Cue{showTime, hideTime, off, textEnd, RichString()});
+
+			off = nextOff;
+			showTime = nextShowTime;
+			hideTime = nextHideTime;
+		} while(off != -1);
+
+		// parse cue markup
+		Parallel::forEach(cues.size(), [&](int i) {
+			Cue &cue = cues[i];
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+			cue.text.setRichString(QStringRef(&data, cue.textStart, cue.textEnd - cue.textStart));
+#else
+			cue.text.setRichString(QStringView(str + cue.textStart, cue.textEnd - cue.textStart));
+#endif
+		});
 
-			Time showTime(mTime.captured(1).toInt(), mTime.captured(2).toInt(), mTime.captured(3).toInt(), mTime.captured(4).toInt());
-			Time hideTime(mTime.captured(5).toInt(), mTime.captured(6).toInt(), mTime.captured(7).toInt(), mTime.captured(8).toInt());
+		QList<SubtitleLine *> lines;
+		lines.reserve(cues.size());
+		for(const Cue &cue : qAsConst(cues)) {
+			SubtitleLine *line = new SubtitleLine(cue.showTime, cue.hideTime);
+			line->setPrimaryText(cue.text);
+			lines.append(line);
+		}
+		subtitle.insertLines(lines);
 
-			const int off = mTime.capturedEnd();
-			const QString text = data.mid(off, itTime.hasNext() ? itTime.peekNext().capturedStart() - off : -1).trimmed();
+		return true;
+	}
 
-			RichString stext;
-			stext.setRichString(text);
+private:
+	static inline bool isDigit(const QChar ch) { return ch.unicode() >= '0' && ch.unicode() <= '9'; }
+	static inline int digit(const QChar ch) { return ch.unicode() - '0'; }
 
-			SubtitleLine *line = new SubtitleLine(showTime, hideTime);
-			line->primaryDoc()->setRichText(stext, true);
-			subtitle.insertLine(line);
-		} while(itTime.hasNext());
+	/**
+	 * @brief Parse "HH:MM:SS,mmm" timestamp at @p off
+	 * @return offset right after the timestamp or -1 if there is no valid timestamp
+	 */
+	static int parseTime(const QChar *str, int off, const int len, Time *time)
+	{
+		if(off + 10 > len)
+			return -1;
+		const QChar *p = str + off;
+		if(p[0].unicode() < '0' || p[0].unicode() > '2' || !isDigit(p[1]) || p[2] != QChar(':')
+			|| p[3].unicode() < '0' || p[3].unicode() > '5' || !isDigit(p[4]) || p[5] != QChar(':')
+			|| p[6].unicode() < '0' || p[6].unicode() > '5' || !isDigit(p[7])
+			|| (p[8] != QChar(',') && p[8] != QChar('.')) || !isDigit(p[9])) {
+			return -1;
+		}
+		off += 9;
+		qint64 millis = 0;
+		while(off < len && isDigit(str[off])) {
+			// stop accumulating once out of int range so long digit runs can't overflow
+			if(millis <= std::numeric_limits<int>::max())
+				millis = millis * 10 + digit(str[off]);
+			off++;
+		}
+		if(millis > std::numeric_limits<int>::max())
+			millis = 0; // same as QString::toInt() overflow
+		*time = Time(digit(p[0]) * 10 + digit(p[1]), digit(p[3]) * 10 + digit(p[4]), digit(p[6]) * 10 + digit(p[7]), int(millis));
+		return off;
+	}
 
-		return true;
+	/**
+	 * @brief Find next "index\nHH:MM:SS,mmm --> HH:MM:SS,mmm\n" cue header starting the search at @p off
+	 * @return offset right after the cue header or -1 if there are no more cues
+	 */
+	static int findCue(const QChar *str, int off, const int len, int *cueStart, Time *showTime, Time *hideTime)
+	{
+		for(int i = off; i < len; i++) {
+			if(str[i] != QChar::LineFeed)
+				continue;
+			int start = i;
+			while(start > off && isDigit(str[start - 1]))
+				start--;
+			if(start == i)
+				continue;
+			int pos = parseTime(str, i + 1, len, showTime);
+			if(pos == -1 || pos + 5 > len || str[pos] != QChar::Space || str[pos + 1] != QChar('-')
+				|| str[pos + 2] != QChar('-') || str[pos + 3] != QChar('>') || str[pos + 4] != QChar::Space) {
+				continue;
+			}
+			pos = parseTime(str, pos + 5, len, hideTime);
+			if(pos == -1 || pos >= len || str[pos] != QChar::LineFeed)
+				continue;
+			*cueStart = start;
+			return pos + 1;
+		}
+		return -1;
 	}
 };
 }
@@ -10,10 +10,12 @@
 
 #include "core/richtext/richdocument.h"
 #include "helpers/common.h"
+#include "helpers/parallel.h"
 #include "formats/inputformat.h"
 
 #include <QRegularExpression>
 #include <QStringBuilder>
+#include <QVector>
 #include <QDebug>
 
 namespace SubtitleComposer {
@@ -84,6 +86,20 @@ protected:
 		return ret;
 	}
 
+	int probe(const QString &sample) const override
+	{
+		return probeScriptInfo(sample, false);
+	}
+
+	int probeScriptInfo(const QString &sample, bool advanced) const
+	{
+		if(!sample.contains(QLatin1String("[Script Info]")))
+			return 0;
+		// both variants are parsed the same way, prefer the one matching the styles section
+		const bool v4plus = sample.contains(QLatin1String("[V4+ Styles]"), Qt::CaseInsensitive);
+		return v4plus == advanced ? 100 : 90;
+	}
+
 	bool parseSubtitles(Subtitle &subtitle, const QString &data) const override
 	{
 		staticRE$(reScriptInfo, "^ *\\[Script Info\\] *[\r\n]+", REu);
@@ -120,6 +136,13 @@ protected:
 		staticRE$(reDialogueData, " *(Dialogue: *[^,]+, *)[^,]+(, *)[^,]+(, *[^,]+, *[^,]*, *[^,]*, *[^,]*, *[^,]*, *[^,]*, *).*", REu);
 		staticRE$(reTime, "(\\d+):(\\d+):(\\d+).(\\d+)", REu);
 
+		struct Cue {
+			SubtitleLine *line;
+			QString text;
+			RichString richText;
+		};
+		QVector<Cue> cues;
+
 		do {
 			QRegularExpressionMatch mFormat = itFormat.next();
 			QRegularExpressionMatchIterator itDialogue = reDialogue.globalMatch(data, mFormat.capturedEnd());
@@ -143,15 +166,27 @@ protected:
 				Time hideTime(mTime.captured(1).toInt(), mTime.captured(2).toInt(), mTime.captured(3).toInt(), mTime.captured(4).toInt() * 10);
 
 				SubtitleLine *line = new SubtitleLine(showTime, hideTime);
-				line->primaryDoc()->setRichText(toRichString(mDialogue.captured(3)), true);
 
 				formatData.setValue($("Dialogue"), mDialogue.captured(0).replace(reDialogueData, $("\\1%1\\2%2\\3%3\n")));
 				setFormatData(line, &formatData);
 
-				subtitle.insertLine(line);
+				cues.push_back(Cue{line, mDialogue.captured(3), RichString()});
 			}
 		} while(itFormat.hasNext());
 
+		// dialogue texts are independent, convert their override codes in parallel
+		Parallel::forEach(cues.size(), [&](int i) {
+			cues[i].richText = toRichString(cues[i].text);
+		});
+
+		QList<SubtitleLine *> lines;
+		lines.reserve(cues.size());
+		for(const Cue &cue : qAsConst(cues)) {
+			cue.line->setPrimaryText(cue.richText);
+			lines.append(cue.line);
+		}
+		subtitle.insertLines(lines);
+
 		return true;
 	}
 
@@ -170,6 +205,11 @@ protected:
 	AdvancedSubStationAlphaInputFormat()
 		: SubStationAlphaInputFormat($("Advanced SubStation Alpha"), QStringList($("ass")))
 	{}
+
+	int probe(const QString &sample) const override
+	{
+		return probeScriptInfo(sample, true);
+	}
 };
 
 }
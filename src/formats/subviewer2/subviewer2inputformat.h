@@ -24,6 +24,12 @@ protected:
 		: InputFormat($("SubViewer 2.0"), QStringList($("sub")))
 	{}
 
+	int probe(const QString &sample) const override
+	{
+		staticRE$(reProbe, "[0-2][0-9]:[0-5][0-9]:[0-5][0-9]\\.[0-9][0-9],[0-2][0-9]:[0-5][0-9]:[0-5][0-9]\\.[0-9][0-9]\\n", REu);
+		return sample.contains(reProbe) ? 90 : 0;
+	}
+
 	bool parseSubtitles(Subtitle &subtitle, const QString &data) const override
 	{
 		staticRE$(reLine,
@@ -34,6 +40,7 @@ protected:
 		if(!itLine.hasNext())
 			return false;
 
+		QList<SubtitleLine *> lines;
 		do {
 			QRegularExpressionMatch mLine = itLine.next();
 
@@ -57,11 +64,13 @@ protected:
 			}
 
 			SubtitleLine *l = new SubtitleLine(showTime, hideTime);
-			l->primaryDoc()->setRichText(RichString(text, styleFlags), true);
-			subtitle.insertLine(l);
+			l->setPrimaryText(RichString(text, styleFlags));
+			lines.append(l);
 
 		} while(itLine.hasNext());
 
+		subtitle.insertLines(lines);
+
 		return subtitle.count() > 0;
 	}
 };
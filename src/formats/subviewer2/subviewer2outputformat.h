@@ -29,7 +29,7 @@ protected:
 			Time hideTime = line->hideTime();
 			ret += QString::asprintf("%02d:%02d:%02d.%02d,%02d:%02d:%02d.%02d\n", showTime.hours(), showTime.minutes(), showTime.seconds(), (showTime.millis() + 5) / 10, hideTime.hours(), hideTime.minutes(), hideTime.seconds(), (hideTime.millis() + 5) / 10);
 
-			const RichString text = (primary ? line->primaryDoc() : line->secondaryDoc())->toRichText();
+			const RichString text = line->text(primary);
 			ret += m_stylesMap[text.cummulativeStyleFlags()];
 			ret += text.string().replace("\n", "[br]");
 
@@ -32,12 +32,18 @@ protected:
 							  $("([0-2]?[0-9]):([0-5][0-9]):([0-5][0-9]):([^\n]*)\n?"))
 	{}
 
+	int probe(const QString &sample) const override
+	{
+		return sample.contains(m_reTime) ? 70 : 0;
+	}
+
 	bool parseSubtitles(Subtitle &subtitle, const QString &data) const override
 	{
 		QRegularExpressionMatchIterator itTime = m_reTime.globalMatch(data);
 		if(!itTime.hasNext())
 			return false;
 
+		QList<SubtitleLine *> lines;
 		do {
 			QRegularExpressionMatch mTime = itTime.next();
 
@@ -58,10 +64,12 @@ protected:
 			}
 
 			SubtitleLine *l = new SubtitleLine(showTime, hideTime);
-			l->primaryDoc()->setPlainText(text);
-			subtitle.insertLine(l);
+			l->setPrimaryText(RichString(text));
+			lines.append(l);
 		} while(itTime.hasNext());
 
+		subtitle.insertLines(lines);
+
 		return subtitle.count() > 0;
 	}
 
@@ -82,7 +82,7 @@ public:
 		quint32 ppFlags = dlgInit.postProcessingFlags();
 		for(int i = 0, n = subtitle.count(); i < n; i++) {
 			SubtitleLine *line = subtitle.at(i);
-			RichString text = line->primaryDoc()->toRichText();
+			RichString text = line->primaryText();
 			if(ppFlags & VobSubInputInitDialog::APOSTROPHE_TO_QUOTES)
 				text
 					.replace(QRegularExpression(QStringLiteral("(?:"
@@ -157,6 +157,11 @@ public:
 	}
 
 protected:
+	int probe(const QString &) const override
+	{
+		return 0;
+	}
+
 	bool parseSubtitles(Subtitle &, const QString &) const override
 	{
 		return false;
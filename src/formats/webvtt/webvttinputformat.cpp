@@ -11,6 +11,7 @@
 #include "core/subtitle.h"
 #include "core/subtitleline.h"
 #include "helpers/common.h"
+#include "helpers/parallel.h"
 
 #include <QMap>
 #include <QRegularExpression>
@@ -223,6 +224,12 @@ parseCueSettings(SubtitleLine *line, QStringView_ css)
 	line->setPosition(p);
 }
 
+int
+WebVTTInputFormat::probe(const QString &sample) const
+{
+	return sample.startsWith($("WEBVTT")) ? 100 : 0;
+}
+
 bool
 WebVTTInputFormat::parseSubtitles(Subtitle &subtitle, const QString &data) const
 {
@@ -240,6 +247,13 @@ WebVTTInputFormat::parseSubtitles(Subtitle &subtitle, const QString &data) const
 
 	subtitle.stylesheetClear();
 
+	struct Cue {
+		SubtitleLine *line;
+		QStringView_ text;
+		RichString richText;
+	};
+	QVector<Cue> cues;
+
 	// https://w3c.github.io/webvtt/
 	while(off < data.length()) {
 		if(QStringView(data).mid(off, 5) == $("STYLE")) {
@@ -276,6 +290,8 @@ WebVTTInputFormat::parseSubtitles(Subtitle &subtitle, const QString &data) const
 		QRegularExpressionMatch m = reTime.match(cueTime);
 		if(!m.isValid()) {
 			qWarning() << "Invalid WEBVTT subtitle";
+			for(const Cue &cue : qAsConst(cues))
+				delete cue.line;
 			return false;
 		}
 
@@ -288,13 +304,6 @@ WebVTTInputFormat::parseSubtitles(Subtitle &subtitle, const QString &data) const
 		off = end;
 
 		SubtitleLine *line = new SubtitleLine(showTime, hideTime);
-		RichString stext;
-		// TODO: handle voice/class tags
-		// https://developer.mozilla.org/en-US/docs/Web/API/WebVTT_API#cue_payload_text_tags
-		// TODO: handle pseudo classes
-		// https://developer.mozilla.org/en-US/docs/Web/API/WebVTT_API#css_pseudo-classes
-		stext.setRichString(cueText.toString());
-		line->primaryDoc()->setRichText(stext, true);
 
 		if(!notes.isEmpty()) {
 			QString comment;
@@ -310,8 +319,25 @@ WebVTTInputFormat::parseSubtitles(Subtitle &subtitle, const QString &data) const
 			parseCueSettings(line, cueSettings);
 		if(!cueId.isEmpty())
 			line->meta("id", cueId.toString());
-		subtitle.insertLine(line);
+		cues.push_back(Cue{line, cueText, RichString()});
+	}
+
+	// cue payloads are independent, parse their markup in parallel
+	Parallel::forEach(cues.size(), [&](int i) {
+		// TODO: handle voice/class tags
+		// https://developer.mozilla.org/en-US/docs/Web/API/WebVTT_API#cue_payload_text_tags
+		// TODO: handle pseudo classes
+		// https://developer.mozilla.org/en-US/docs/Web/API/WebVTT_API#css_pseudo-classes
+		cues[i].richText.setRichString(cues[i].text);
+	});
+
+	QList<SubtitleLine *> lines;
+	lines.reserve(cues.size());
+	for(const Cue &cue : qAsConst(cues)) {
+		cue.line->setPrimaryText(cue.richText);
+		lines.append(cue.line);
 	}
+	subtitle.insertLines(lines);
 
 	if(!notes.isEmpty()) {
 		int noteId = 0;
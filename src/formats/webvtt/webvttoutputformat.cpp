@@ -113,7 +113,7 @@ WebVTTOutputFormat::dumpSubtitles(const Subtitle &subtitle, bool primary) const
 			ret.append(QLatin1String(" align:end"));
 		ret.append(QChar::LineFeed);
 
-		const RichString text = (primary ? line->primaryDoc() : line->secondaryDoc())->toRichText();
+		const RichString text = line->text(primary);
 		ret += text.richString()
 				.replace(QLatin1String("&amp;"), QLatin1String("&"))
 				.replace(QLatin1String("&lt;"), QLatin1String("<"))
@@ -57,6 +57,7 @@ private:
 	void onLineTimesChanged(const Time &showTime, const Time &hideTime);
 	void onLineShowTimeChanged(const Time &showTime);
 	void onLineHideTimeChanged(const Time &hideTime);
+	void onLinesTimesChanged(int firstIndex, int lastIndex);
 
 	void onConfigChanged();
 
@@ -462,6 +462,7 @@ PlayerWidget::setSubtitle(Subtitle *subtitle)
 	if(m_subtitle) {
 		disconnect(m_subtitle.constData(), &Subtitle::linesInserted, this, &PlayerWidget::setPlayingLineFromVideo);
 		disconnect(m_subtitle.constData(), &Subtitle::linesRemoved, this, &PlayerWidget::setPlayingLineFromVideo);
+		disconnect(m_subtitle.constData(), &Subtitle::linesTimesChanged, this, &PlayerWidget::setPlayingLineFromVideo);
 
 		m_subtitle = nullptr;
 
@@ -473,6 +474,7 @@ PlayerWidget::setSubtitle(Subtitle *subtitle)
 	if(m_subtitle) {
 		connect(m_subtitle.constData(), &Subtitle::linesInserted, this, &PlayerWidget::setPlayingLineFromVideo);
 		connect(m_subtitle.constData(), &Subtitle::linesRemoved, this, &PlayerWidget::setPlayingLineFromVideo);
+		connect(m_subtitle.constData(), &Subtitle::linesTimesChanged, this, &PlayerWidget::setPlayingLineFromVideo);
 	}
 }
 
@@ -522,44 +524,7 @@ PlayerWidget::updatePlayingLine(const Time &videoPosition)
 	if(m_playingLine && m_playingLine->containsTime(videoPosition))
 		return; // playing line is still valid
 
-	SubtitleLine *firstLine = m_subtitle->firstLine();
-	SubtitleLine *lastLine = m_subtitle->lastLine();
-	bool pnValid = true;
-	if(m_prevLine ? videoPosition < m_prevLine->showTime() : m_nextLine != firstLine)
-		pnValid = false;
-	else if(m_nextLine ? videoPosition > m_nextLine->hideTime() : m_prevLine != lastLine)
-		pnValid = false;
-
-	if(!pnValid) {
-		// prev/next line are invalid
-		m_prevLine = m_nextLine = nullptr;
-		int first = 0;
-		int last = m_subtitle->lastIndex();
-		if(videoPosition < firstLine->showTime()) {
-			m_nextLine = firstLine;
-		} else if(videoPosition > lastLine->hideTime()) {
-			m_prevLine = lastLine;
-		} else {
-			while(last - first > 1) {
-				// log2 search lines
-				int mid = (first + last) / 2;
-				SubtitleLine *line = m_subtitle->at(mid);
-				if(videoPosition <= line->hideTime())
-					last = mid;
-				if(videoPosition >= line->showTime())
-					first = mid;
-			}
-			m_prevLine = m_subtitle->at(first);
-			m_nextLine = m_subtitle->at(last);
-		}
-	}
-
-	if(m_prevLine && m_prevLine->containsTime(videoPosition))
-		setPlayingLine(m_prevLine);
-	else if(m_nextLine && m_nextLine->containsTime(videoPosition))
-		setPlayingLine(m_nextLine);
-	else
-		setPlayingLine(nullptr);
+	setPlayingLine(m_subtitle->lineAt(videoPosition));
 }
 
 void
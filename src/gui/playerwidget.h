@@ -104,8 +104,6 @@ private:
 	bool m_translationMode;
 	bool m_showTranslation;
 	QPointer<SubtitleLine> m_playingLine;
-	QPointer<SubtitleLine> m_prevLine;
-	QPointer<SubtitleLine> m_nextLine;
 
 	QPointer<const SubtitleLine> m_pauseAfterPlayingLine;
 
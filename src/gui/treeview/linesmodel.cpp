@@ -63,6 +63,8 @@ LinesModel::setSubtitle(Subtitle *subtitle)
 			disconnect(m_subtitle.constData(), &Subtitle::lineSecondaryTextChanged, this, &LinesModel::onLineChanged);
 			disconnect(m_subtitle.constData(), &Subtitle::lineShowTimeChanged, this, &LinesModel::onLineChanged);
 			disconnect(m_subtitle.constData(), &Subtitle::lineHideTimeChanged, this, &LinesModel::onLineChanged);
+			disconnect(m_subtitle.constData(), &Subtitle::linesTimesChanged, this, &LinesModel::onLineRangeChanged);
+			disconnect(m_subtitle.constData(), &Subtitle::linesErrorFlagsChanged, this, &LinesModel::onLineRangeChanged);
 
 			disconnect(m_subtitle->stylesheet(), &RichCSS::changed, this, &LinesModel::onLinesChanged);
 
@@ -89,6 +91,8 @@ LinesModel::setSubtitle(Subtitle *subtitle)
 			connect(m_subtitle.constData(), &Subtitle::lineSecondaryTextChanged, this, &LinesModel::onLineChanged);
 			connect(m_subtitle.constData(), &Subtitle::lineShowTimeChanged, this, &LinesModel::onLineChanged);
 			connect(m_subtitle.constData(), &Subtitle::lineHideTimeChanged, this, &LinesModel::onLineChanged);
+			connect(m_subtitle.constData(), &Subtitle::linesTimesChanged, this, &LinesModel::onLineRangeChanged);
+			connect(m_subtitle.constData(), &Subtitle::linesErrorFlagsChanged, this, &LinesModel::onLineRangeChanged);
 
 			connect(m_subtitle->stylesheet(), &RichCSS::changed, this, &LinesModel::onLinesChanged);
 		}
@@ -378,6 +382,19 @@ LinesModel::onLineChanged(const SubtitleLine *line)
 	}
 }
 
+void
+LinesModel::onLineRangeChanged(int firstIndex, int lastIndex)
+{
+	if(m_minChangedLineIndex < 0) {
+		m_minChangedLineIndex = firstIndex;
+		m_maxChangedLineIndex = lastIndex;
+		m_dataChangedTimer->start();
+		return;
+	}
+	m_minChangedLineIndex = qMin(m_minChangedLineIndex, firstIndex);
+	m_maxChangedLineIndex = qMax(m_maxChangedLineIndex, lastIndex);
+}
+
 void
 LinesModel::onLinesChanged()
 {
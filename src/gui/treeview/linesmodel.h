@@ -58,6 +58,7 @@ private slots:
 	void onModelReset();
 
 	void onLineChanged(const SubtitleLine *line);
+	void onLineRangeChanged(int firstIndex, int lastIndex);
 	void onLinesChanged();
 	void emitDataChanged();
 
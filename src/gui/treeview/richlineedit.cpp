@@ -157,7 +157,12 @@ RichLineEdit::setupActions()
 void
 RichLineEdit::setDocument(RichDocument *document)
 {
+	if(m_document)
+		disconnect(m_document, nullptr, this, nullptr);
 	m_document = document;
+	// keeps the document observed so SubtitleLine won't release it while editing
+	if(m_document)
+		connect(m_document, &RichDocument::contentsChanged, this, QOverload<>::of(&RichLineEdit::update));
 	m_control->setDocument(m_document);
 	m_control->setFont(m_lineStyle.font);
 	m_control->setLayoutDirection(m_lineStyle.direction);
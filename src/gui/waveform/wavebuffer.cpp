@@ -8,10 +8,19 @@
 
 #include "application.h"
 #include "gui/waveform/waveformwidget.h"
+#include "gui/waveform/wavekernels.h"
+#include "gui/waveform/wavespeechboundaries.h"
 #include "gui/waveform/zoombuffer.h"
 
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
 #include <QProgressBar>
+#include <QSaveFile>
 #include <QScrollBar>
+#include <QStandardPaths>
 #include <QtMath>
 
 #define MAX_WINDOW_ZOOM 3000 // TODO: calculate this when receiving stream data and do sample rate conversion
@@ -19,15 +28,28 @@
 //#define SAMPLE_RATE_MILLIS (SAMPLE_RATE / 1000)
 //#define DRAG_TOLERANCE (double(10 * m_samplesPerPixel / SAMPLE_RATE_MILLIS))
 
+// long streams are split into segments of at least this length that are decoded concurrently
+#define DECODE_SEGMENT_MIN_DURATION (2 * 60 * 1000)
+
+#define CACHE_VERSION 1
+#define CACHE_MAX_SIZE (1024LL * 1024 * 1024)
+
 
 namespace SubtitleComposer {
 struct WaveformFrame {
-	explicit WaveformFrame(quint8 shift, quint8 channels)
-		: offset(0),
+	explicit WaveformFrame(StreamProcessor *stream, const WaveFormat *format, quint8 shift, quint8 channels, quint32 start, quint32 end)
+		: stream(stream),
+		  format(format),
+		  start(start),
+		  end(end),
+		  offset(start),
 		  sampleShift(shift),
 		  frameSize((1 << sampleShift) * channels),
 		  overflow(0),
-		  val(new qint32[channels])
+		  val(new qint32[channels]),
+		  msecStart(0),
+		  msecPos(0),
+		  finished(false)
 	{
 	}
 
@@ -35,11 +57,28 @@ struct WaveformFrame {
 		delete[] val;
 	}
 
+	StreamProcessor *stream;
+	const WaveFormat *format;
+	quint32 start;
+	quint32 end;
 	quint32 offset;
 	quint8 sampleShift;
 	quint16 frameSize;
 	quint16 overflow;
 	qint32 *val;
+	quint64 msecStart;
+	quint64 msecPos;
+	bool finished;
+};
+
+struct WaveCacheHeader {
+	char magic[4];
+	quint32 version;
+	quint32 sampleSize;
+	quint32 sampleRate;
+	quint32 channels;
+	quint32 channelSize;
+	quint64 duration;
 };
 }
 
@@ -49,19 +88,28 @@ using namespace SubtitleComposer;
 WaveBuffer::WaveBuffer(WaveformWidget *parent)
 	: QObject(parent),
 	  m_wfWidget(parent),
-	  m_stream(new StreamProcessor(this)),
+	  m_stream(nullptr),
+	  m_streamFormat(nullptr),
 	  m_waveformDuration(0),
 	  m_waveformChannelSize(0),
 	  m_waveformChannels(0),
 	  m_waveform(nullptr),
 	  m_samplesSec(0),
-	  m_wfFrame(nullptr),
-	  m_zoomBuffer(new ZoomBuffer(this))
+	  m_zoomBuffer(new ZoomBuffer(this)),
+	  m_cacheable(false)
 {
-	connect(m_stream, &StreamProcessor::streamProgress, this, &WaveBuffer::onStreamProgress);
-	connect(m_stream, &StreamProcessor::streamFinished, this, &WaveBuffer::onStreamFinished);
-	// Using Qt::DirectConnection here makes WaveBuffer::onStreamData() to execute in SpeechProcessor's thread
-	connect(m_stream, &StreamProcessor::audioDataAvailable, this, &WaveBuffer::onStreamData, Qt::DirectConnection);
+}
+
+void
+WaveBuffer::connectStream(StreamProcessor *stream)
+{
+	connect(stream, &StreamProcessor::streamProgress, this, [this, stream](quint64 msecPos, quint64){ onStreamProgress(stream, msecPos); });
+	connect(stream, &StreamProcessor::audioOutputFinished, this, &WaveBuffer::onStreamFinished);
+	connect(stream, &StreamProcessor::streamError, this, [this](){ m_cacheable = false; });
+	// Using Qt::DirectConnection here makes WaveBuffer::onStreamData() to execute in StreamProcessor's thread
+	connect(stream, &StreamProcessor::audioDataAvailable, this, [this](const void *buffer, qint32 size, const WaveFormat *format, qint64 msecStart, qint64){
+		onStreamData(format, buffer, size, msecStart);
+	}, Qt::DirectConnection);
 }
 
 quint32
@@ -70,10 +118,89 @@ WaveBuffer::millisPerPixel() const
 	return m_zoomBuffer->samplesPerPixel() * 1000 / m_samplesSec;
 }
 
+bool
+WaveBuffer::isDecoding() const
+{
+	QMutexLocker l(&m_segmentsMutex);
+	return !m_segments.isEmpty();
+}
+
 quint32
 WaveBuffer::samplesAvailable() const
 {
-	return m_wfFrame ? m_wfFrame->offset : m_waveformChannelSize;
+	QMutexLocker l(&m_segmentsMutex);
+	return samplesAvailableLocked();
+}
+
+quint32
+WaveBuffer::samplesAvailableLocked() const
+{
+	// samples are available up to the first segment that is still decoding
+	for(const WaveformFrame *frame : m_segments) {
+		if(!frame->finished)
+			return frame->offset;
+	}
+	return m_segments.isEmpty() ? m_waveformChannelSize : m_segments.last()->offset;
+}
+
+quint32
+WaveBuffer::waitForSamples(quint32 samples, const QThread *waiter) const
+{
+	QMutexLocker l(&m_segmentsMutex);
+	quint32 available = samplesAvailableLocked();
+	if(available <= samples && !m_segments.isEmpty() && !waiter->isInterruptionRequested()) {
+		m_samplesDecoded.wait(&m_segmentsMutex);
+		available = samplesAvailableLocked();
+	}
+	return available;
+}
+
+void
+WaveBuffer::wakeSampleWaiters() const
+{
+	QMutexLocker l(&m_segmentsMutex);
+	m_samplesDecoded.wakeAll();
+}
+
+WaveformFrame *
+WaveBuffer::segment(const StreamProcessor *stream) const
+{
+	for(WaveformFrame *frame : m_segments) {
+		if(frame->stream == stream)
+			return frame;
+	}
+	return nullptr;
+}
+
+WaveformFrame *
+WaveBuffer::segment(const WaveFormat *format) const
+{
+	// shared decoder is emitting data of other consumers too
+	for(WaveformFrame *frame : m_segments) {
+		if(frame->format == format)
+			return frame;
+	}
+	return nullptr;
+}
+
+void
+WaveBuffer::clearSegments()
+{
+	QMutexLocker l(&m_segmentsMutex);
+	qDeleteAll(m_segments);
+	m_segments.clear();
+	m_samplesDecoded.wakeAll();
+}
+
+bool
+WaveBuffer::analyzeSpeech(WaveSpeechBoundaries *boundaries) const
+{
+	boundaries->clear();
+	if(!m_waveform)
+		return false;
+	// decoded samples aren't written anymore
+	boundaries->analyze(m_waveform, m_waveformChannels, samplesAvailable(), m_samplesSec);
+	return true;
 }
 
 void
@@ -81,9 +208,80 @@ WaveBuffer::setAudioStream(const QString &mediaFile, int audioStream)
 {
 	m_waveformDuration = 0;
 
+	m_cachePath = cacheFilePath(mediaFile, audioStream);
+	if(loadCache())
+		return;
+
 	static WaveFormat waveFormat(0, 0, sizeof(SAMPLE_TYPE) * 8, true);
-	if(m_stream->open(mediaFile) && m_stream->initAudio(audioStream, waveFormat))
-		m_stream->start();
+	// decoder is shared with other consumers of the same stream (e.g. speech recognition)
+	m_stream = StreamProcessor::attachAudio(mediaFile, audioStream, waveFormat, &m_streamFormat);
+	if(!m_stream)
+		return;
+
+	const WaveFormat &streamFormat = *m_streamFormat;
+	Q_ASSERT(streamFormat.bitsPerSample() == sizeof(SAMPLE_TYPE) * 8);
+
+	m_waveformDuration = m_stream->duration();
+	m_samplesSec = streamFormat.sampleRate();
+	quint8 sampleShift = 0;
+	while(m_samplesSec > MAX_WINDOW_ZOOM) {
+		m_samplesSec >>= 1;
+		sampleShift++;
+	}
+	m_waveformChannels = streamFormat.channels();
+	m_waveformChannelSize = m_samplesSec * ((m_waveformDuration / 1000) + 60); // added 60sec as duration might be wrong
+	m_waveform = new SAMPLE_TYPE *[m_waveformChannels];
+	for(quint32 i = 0; i < m_waveformChannels; i++)
+		m_waveform[i] = new SAMPLE_TYPE[m_waveformChannelSize];
+
+	// each of the other segments has its own decoder which seeks to segment start
+	int segmentCount = qBound(1, int(m_waveformDuration / DECODE_SEGMENT_MIN_DURATION), QThread::idealThreadCount());
+	for(int i = 1; i < segmentCount; i++) {
+		if(i > m_streams.size()) {
+			m_streams.append(new StreamProcessor(this));
+			connectStream(m_streams.last());
+		}
+		StreamProcessor *stream = m_streams.at(i - 1);
+		if(!stream->open(mediaFile) || !stream->initAudio(audioStream, waveFormat)) {
+			stream->close();
+			segmentCount = i;
+			break;
+		}
+	}
+
+	// streams are configured under their audio lock, it's never nested with m_segmentsMutex
+	QVector<WaveformFrame *> segments;
+	for(int i = 0; i < segmentCount; i++) {
+		const bool last = i == segmentCount - 1;
+		const quint64 msecStart = m_waveformDuration * i / segmentCount;
+		const quint64 msecEnd = m_waveformDuration * (i + 1) / segmentCount;
+		StreamProcessor *stream = i ? m_streams.at(i - 1) : m_stream;
+		const WaveFormat *format = i ? &stream->audioFormat() : m_streamFormat;
+		stream->setAudioRange(msecStart, last ? -1 : msecEnd, format);
+		WaveformFrame *frame = new WaveformFrame(stream, format, sampleShift, m_waveformChannels,
+			msecStart * m_samplesSec / 1000, last ? m_waveformChannelSize : msecEnd * m_samplesSec / 1000);
+		frame->msecStart = frame->msecPos = msecStart;
+		segments.append(frame);
+	}
+	{
+		QMutexLocker l(&m_segmentsMutex);
+		m_segments.append(segments);
+	}
+
+	m_zoomBuffer->setWaveform(m_waveform);
+
+	m_wfWidget->m_progressBar->setRange(0, m_waveformDuration / 1000);
+	m_wfWidget->m_progressBar->setValue(0);
+	m_wfWidget->m_progressWidget->show();
+	m_wfWidget->m_scrollBar->setRange(0, m_waveformDuration - m_wfWidget->windowSizeInner());
+
+	emit waveformUpdated();
+
+	m_cacheable = !m_cachePath.isEmpty();
+	connectStream(m_stream);
+	m_stream->start();
+	for(int i = 1; i < segmentCount; i++)
+		m_streams.at(i - 1)->start();
 }
 
 void
@@ -99,12 +297,27 @@ WaveBuffer::setNullAudioStream(quint64 msecVideoLength)
 void
 WaveBuffer::clearAudioStream()
 {
-	m_stream->close();
+	// partially decoded waveform must not end up in the cache
+	m_cacheable = false;
+	for(StreamProcessor *stream : qAsConst(m_streams))
+		stream->close();
+	if(m_stream) {
+		disconnect(m_stream, nullptr, this, nullptr);
+		StreamProcessor::detachAudio(m_stream, m_streamFormat);
+		m_stream = nullptr;
+		m_streamFormat = nullptr;
+	}
+	clearSegments();
 
 	if(m_waveform) {
 		m_zoomBuffer->setWaveform(nullptr);
-		for(quint32 i = 0; i < m_waveformChannels; i++)
-			delete[] m_waveform[i];
+		if(m_cacheFile.isOpen()) {
+			// channels are pointing into the mapped cache file
+			m_cacheFile.close();
+		} else {
+			for(quint32 i = 0; i < m_waveformChannels; i++)
+				delete[] m_waveform[i];
+		}
 		delete[] m_waveform;
 		m_waveform = nullptr;
 		m_waveformChannelSize = 0;
@@ -114,128 +327,234 @@ WaveBuffer::clearAudioStream()
 }
 
 void
-WaveBuffer::onStreamProgress(quint64 msecPos, quint64 msecLength)
+WaveBuffer::onStreamProgress(StreamProcessor *stream, quint64 msecPos)
 {
-	if(!m_waveformDuration) {
-		m_waveformDuration = msecLength;
-		m_wfWidget->m_progressBar->setRange(0, m_waveformDuration / 1000);
-		m_wfWidget->m_progressWidget->show();
-		m_wfWidget->m_scrollBar->setRange(0, m_waveformDuration - m_wfWidget->windowSizeInner());
-	}
-	m_wfWidget->m_progressBar->setValue(msecPos / 1000);
+	WaveformFrame *frame = segment(stream);
+	if(!frame)
+		return;
+	frame->msecPos = msecPos;
+
+	quint64 msecDecoded = 0;
+	for(const WaveformFrame *seg : qAsConst(m_segments))
+		msecDecoded += qMax(seg->msecPos, seg->msecStart) - seg->msecStart;
+	m_wfWidget->m_progressBar->setValue(msecDecoded / 1000);
 }
 
 void
-WaveBuffer::onStreamFinished()
+WaveBuffer::onStreamFinished(const WaveFormat *format)
 {
-	m_wfWidget->m_progressWidget->hide();
-	if(m_wfFrame) {
-		m_waveformChannelSize = m_wfFrame->offset;
-		delete m_wfFrame;
-		m_wfFrame = nullptr;
+	{
+		QMutexLocker l(&m_segmentsMutex);
+
+		WaveformFrame *frame = segment(format);
+		if(!frame || frame->finished)
+			return;
+
+		// stitch with next segment - decoded data can end a bit before the segment end
+		if(frame != m_segments.last())
+			padSegment(frame, frame->end);
+		frame->finished = true;
+		m_samplesDecoded.wakeAll();
+
+		for(const WaveformFrame *seg : qAsConst(m_segments)) {
+			if(!seg->finished)
+				return;
+		}
+
+		m_waveformChannelSize = m_segments.last()->offset;
 	}
+
+	m_wfWidget->m_progressWidget->hide();
+	clearSegments();
+	if(m_cacheable)
+		saveCache();
+	m_cacheable = false;
 }
 
-inline static SAMPLE_TYPE
-scaleSample(SAMPLE_TYPE sample)
+QString
+WaveBuffer::cacheFilePath(const QString &mediaFile, int audioStream)
 {
-	static const qreal valMax = qreal(SAMPLE_MAX - SAMPLE_MIN) / 2.;
-	return qSqrt(qreal(sample) / valMax) * SAMPLE_MAX;
+	const QFileInfo fi(mediaFile);
+	if(!fi.isFile())
+		return QString();
+
+	const QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+	if(cacheDir.isEmpty())
+		return QString();
+
+	QCryptographicHash hash(QCryptographicHash::Sha1);
+	hash.addData(fi.canonicalFilePath().toUtf8());
+	hash.addData(QByteArray::number(fi.size()));
+	hash.addData(QByteArray::number(fi.lastModified().toMSecsSinceEpoch()));
+	hash.addData(QByteArray::number(audioStream));
+
+	return cacheDir + QStringLiteral("/waveform/") + QString::fromLatin1(hash.result().toHex()) + QStringLiteral(".wf");
 }
 
-void
-WaveBuffer::onStreamData(const void *buffer, qint32 size, const WaveFormat *waveFormat, const qint64 msecStart, const qint64 /*msecDuration*/)
+bool
+WaveBuffer::loadCache()
 {
-	// make sure WaveBuffer::onStreamProgress() signal was processed since we're in different thread
-	while(!m_waveformDuration) {
-		QThread::yieldCurrentThread();
-		if(m_stream->isInterruptionRequested())
-			return;
+	if(m_cachePath.isEmpty())
+		return false;
+
+	m_cacheFile.setFileName(m_cachePath);
+	if(!m_cacheFile.open(QIODevice::ReadOnly))
+		return false;
+
+	WaveCacheHeader hdr;
+	if(m_cacheFile.read(reinterpret_cast<char *>(&hdr), sizeof(hdr)) != sizeof(hdr)
+			|| memcmp(hdr.magic, "SCWF", 4) || hdr.version != CACHE_VERSION || hdr.sampleSize != sizeof(SAMPLE_TYPE)
+			|| !hdr.sampleRate || !hdr.channels || !hdr.channelSize || !hdr.duration
+			|| m_cacheFile.size() != qint64(sizeof(hdr) + quint64(hdr.channels) * hdr.channelSize * sizeof(SAMPLE_TYPE))) {
+		m_cacheFile.close();
+		QFile::remove(m_cachePath);
+		return false;
 	}
 
-	if(!m_waveformChannels) {
-		m_samplesSec = waveFormat->sampleRate();
-		quint8 sampleShift = 0;
-		while(m_samplesSec > MAX_WINDOW_ZOOM) {
-			m_samplesSec >>= 1;
-			sampleShift++;
-		}
-		m_waveformChannels = waveFormat->channels();
-		m_waveformChannelSize = m_samplesSec * ((m_waveformDuration / 1000) + 60); // added 60sec as duration might be wrong
-		m_waveform = new SAMPLE_TYPE *[m_waveformChannels];
-		for(quint32 i = 0; i < m_waveformChannels; i++)
-			m_waveform[i] = new SAMPLE_TYPE[m_waveformChannelSize];
+	// private mapping - pages are loaded on demand and nothing is ever written back to the file
+	uchar *data = m_cacheFile.map(sizeof(hdr), m_cacheFile.size() - sizeof(hdr), QFileDevice::MapPrivateOption);
+	if(!data) {
+		m_cacheFile.close();
+		return false;
+	}
+
+	m_waveformDuration = hdr.duration;
+	m_samplesSec = hdr.sampleRate;
+	m_waveformChannels = hdr.channels;
+	m_waveformChannelSize = hdr.channelSize;
+	m_waveform = new SAMPLE_TYPE *[m_waveformChannels];
+	for(quint32 i = 0; i < m_waveformChannels; i++)
+		m_waveform[i] = reinterpret_cast<SAMPLE_TYPE *>(data) + i * m_waveformChannelSize;
+
+	// touch the file so pruneCache() keeps recently used waveforms
+	m_cacheFile.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
 
-		m_wfFrame = new WaveformFrame(sampleShift, m_waveformChannels);
+	m_wfWidget->m_scrollBar->setRange(0, m_waveformDuration - m_wfWidget->windowSizeInner());
+	m_zoomBuffer->setWaveform(m_waveform);
 
-		m_zoomBuffer->setWaveform(m_waveform);
+	emit waveformUpdated();
+
+	return true;
+}
 
-		emit waveformUpdated();
+void
+WaveBuffer::saveCache() const
+{
+	const QFileInfo fi(m_cachePath);
+	if(!QDir().mkpath(fi.absolutePath()))
+		return;
+
+	WaveCacheHeader hdr;
+	memcpy(hdr.magic, "SCWF", 4);
+	hdr.version = CACHE_VERSION;
+	hdr.sampleSize = sizeof(SAMPLE_TYPE);
+	hdr.sampleRate = m_samplesSec;
+	hdr.channels = m_waveformChannels;
+	hdr.channelSize = m_waveformChannelSize;
+	hdr.duration = m_waveformDuration;
+
+	QSaveFile file(m_cachePath);
+	if(!file.open(QIODevice::WriteOnly))
+		return;
+	file.write(reinterpret_cast<const char *>(&hdr), sizeof(hdr));
+	for(quint32 i = 0; i < m_waveformChannels; i++)
+		file.write(reinterpret_cast<const char *>(m_waveform[i]), m_waveformChannelSize * sizeof(SAMPLE_TYPE));
+	if(!file.commit()) {
+		qWarning() << "Failed writing waveform cache" << m_cachePath << file.errorString();
+		return;
 	}
 
-	Q_ASSERT(waveFormat->bitsPerSample() == sizeof(SAMPLE_TYPE) * 8);
+	pruneCache(fi.absolutePath());
+}
+
+void
+WaveBuffer::pruneCache(const QString &cacheDir)
+{
+	const QFileInfoList files = QDir(cacheDir).entryInfoList({QStringLiteral("*.wf")}, QDir::Files, QDir::Time);
+	qint64 totalSize = 0;
+	for(const QFileInfo &fi : files) {
+		totalSize += fi.size();
+		if(totalSize > CACHE_MAX_SIZE)
+			QFile::remove(fi.absoluteFilePath());
+	}
+}
+
+void
+WaveBuffer::padSegment(WaveformFrame *frame, quint32 offset)
+{
+	if(frame->offset >= offset)
+		return;
+	if(frame->offset > frame->start) {
+		for(quint32 i = frame->offset; i < offset; i++) {
+			for(quint32 c = 0; c < m_waveformChannels; c++)
+				m_waveform[c][i] = m_waveform[c][i - 1];
+		}
+	} else {
+		for(quint32 c = 0; c < m_waveformChannels; c++)
+			memset(m_waveform[c] + frame->offset, 0, (offset - frame->offset) * sizeof(SAMPLE_TYPE));
+	}
+	frame->offset = offset;
+}
+
+void
+WaveBuffer::onStreamData(const WaveFormat *format, const void *buffer, qint32 size, const qint64 msecStart)
+{
+	// readers take the segment offsets under the same lock and clearSegments()
+	// can't delete the segment while it's written
+	QMutexLocker l(&m_segmentsMutex);
+
+	WaveformFrame *frame = segment(format);
+	if(!frame)
+		return;
 
 	const SAMPLE_TYPE *sample = reinterpret_cast<const SAMPLE_TYPE *>(buffer);
 
 	{ // handle overlaps and holes between buffers (tested streams had ~2ms error - might be useless)
-		const quint32 inStartOffset = qMax(0LL, msecStart) * m_samplesSec / 1000;
-		if(inStartOffset < m_wfFrame->offset) {
+		const quint32 inStartOffset = qBound(quint64(frame->start), quint64(qMax(0LL, msecStart)) * m_samplesSec / 1000, quint64(frame->end));
+		if(inStartOffset < frame->offset) {
 			// overwrite part of local buffer
-			m_wfFrame->offset = inStartOffset;
-		} else if(inStartOffset > m_wfFrame->offset) {
+			frame->offset = inStartOffset;
+		} else {
 			// pad hole in local buffer
-			quint32 i = m_wfFrame->offset;
-			if(i > 0) {
-				for(; i < inStartOffset; i++) {
-					for(quint32 c = 0; c < m_waveformChannels; c++)
-						m_waveform[c][i] = m_waveform[c][i - 1];
-				}
-			} else {
-				for(quint32 c = 0; c < m_waveformChannels; c++)
-					memset(m_waveform[c], 0, inStartOffset * sizeof(SAMPLE_TYPE));
-			}
-			m_wfFrame->offset = inStartOffset;
+			padSegment(frame, inStartOffset);
 		}
 	}
 
+	// segment is full, rest of data belongs to the next one
+	if(frame->offset >= frame->end)
+		return;
+
 	Q_ASSERT(m_waveformChannels > 0);
 
 	quint32 len = size / sizeof(SAMPLE_TYPE);
 
-	if(m_wfFrame->overflow) {
-		const quint32 overflowFrameSize = qMin(m_wfFrame->overflow + len, quint32(m_wfFrame->frameSize));
+	if(frame->overflow) {
+		const quint32 overflowFrameSize = qMin(frame->overflow + len, quint32(frame->frameSize));
 
-		quint32 c = m_wfFrame->overflow;
+		quint32 c = frame->overflow;
 		for(; c < m_waveformChannels; c++)
-			m_wfFrame->val[c] = *sample++;
+			frame->val[c] = *sample++;
 		for(; c < overflowFrameSize; c++)
-			m_wfFrame->val[c % m_waveformChannels] += *sample++;
+			frame->val[c % m_waveformChannels] += *sample++;
 		for(c = 0; c < m_waveformChannels; c++)
-			m_waveform[c][m_wfFrame->offset] = scaleSample(m_wfFrame->val[c] >> m_wfFrame->sampleShift);
+			m_waveform[c][frame->offset] = WaveKernels::scaleSample(frame->val[c] >> frame->sampleShift);
 
-		len -= overflowFrameSize - m_wfFrame->overflow;
-		if(overflowFrameSize < m_wfFrame->frameSize) {
+		len -= overflowFrameSize - frame->overflow;
+		if(overflowFrameSize < frame->frameSize) {
 			// no more data
 			Q_ASSERT(len == 0);
-			m_wfFrame->overflow = overflowFrameSize;
+			frame->overflow = overflowFrameSize;
 			return;
 		}
-		m_wfFrame->offset++;
+		frame->offset++;
 	}
 
-	if(m_wfFrame->offset + (len >> m_wfFrame->sampleShift) >= m_waveformChannelSize) // make sure we don't overflow
-		len = (m_waveformChannelSize - m_wfFrame->offset - 1) << m_wfFrame->sampleShift;
+	// last frame is always left for the overflow handling
+	const quint32 frames = qMin(len ? (len - 1) / frame->frameSize : 0, frame->end - frame->offset);
+	WaveKernels::decimate(sample, frames, m_waveformChannels, frame->sampleShift, m_waveform, frame->offset);
+	frame->offset += frames;
+	frame->overflow = frame->offset < frame->end ? len - frames * frame->frameSize : 0;
 
-	while(len > m_wfFrame->frameSize) {
-		quint32 c = 0;
-		for(; c < m_waveformChannels; c++)
-			m_wfFrame->val[c] = *sample++;
-		for(; c < m_wfFrame->frameSize; c++)
-			m_wfFrame->val[c % m_waveformChannels] += *sample++;
-		for(c = 0; c < m_waveformChannels; c++)
-			m_waveform[c][m_wfFrame->offset] = scaleSample(m_wfFrame->val[c] >> m_wfFrame->sampleShift);
-		len -= m_wfFrame->frameSize;
-		m_wfFrame->offset++;
-	}
-	m_wfFrame->overflow = len;
+	// zoom processing is sleeping until new samples arrive
+	m_samplesDecoded.wakeAll();
 }
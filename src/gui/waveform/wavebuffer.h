@@ -9,7 +9,11 @@
 
 #include "streamprocessor/streamprocessor.h"
 
+#include <QFile>
+#include <QMutex>
 #include <QObject>
+#include <QVector>
+#include <QWaitCondition>
 
 // FIXME: make sample size configurable or drop this
 //*
@@ -24,6 +28,7 @@
 
 namespace SubtitleComposer {
 class WaveformWidget;
+class WaveSpeechBoundaries;
 class ZoomBuffer;
 
 struct WaveZoomData {
@@ -57,7 +62,7 @@ public:
 
 	inline quint16 channels() const { return m_waveformChannels; }
 
-	inline bool isDecoding() const { return m_wfFrame != nullptr; }
+	bool isDecoding() const;
 
 	/**
 	 * @brief MAX_WINDOW_ZOOM
@@ -66,6 +71,15 @@ public:
 	inline static quint32 MAX_WINDOW_ZOOM() { return 3000; }
 
 	quint32 samplesAvailable() const;
+	/**
+	 * @brief Sleep until more than @p samples are available, decoding ends or @p waiter is interrupted
+	 * @return number of samples available
+	 */
+	quint32 waitForSamples(quint32 samples, const QThread *waiter) const;
+	/**
+	 * @brief Wake threads sleeping in waitForSamples() so they can check for interruption
+	 */
+	void wakeSampleWaiters() const;
 
 	void setAudioStream(const QString &mediaFile, int audioStream);
 	void setNullAudioStream(quint64 msecVideoLength);
@@ -73,18 +87,39 @@ public:
 
 	inline ZoomBuffer * zoomBuffer() const { return m_zoomBuffer; }
 
+	/**
+	 * @brief Find speech boundaries in the part of waveform that is decoded
+	 * @return false if there is no waveform
+	 */
+	bool analyzeSpeech(WaveSpeechBoundaries *boundaries) const;
+
 signals:
 	void waveformUpdated();
 
 private:
-	void onStreamData(const void *buffer, qint32 size, const WaveFormat *waveFormat, const qint64 msecStart, const qint64 msecDuration);
-	void onStreamProgress(quint64 msecPos, quint64 msecLength);
-	void onStreamFinished();
+	void connectStream(StreamProcessor *stream);
+	struct WaveformFrame * segment(const StreamProcessor *stream) const;
+	struct WaveformFrame * segment(const WaveFormat *format) const;
+	void padSegment(struct WaveformFrame *frame, quint32 offset);
+	void clearSegments();
+	quint32 samplesAvailableLocked() const;
+
+	void onStreamData(const WaveFormat *format, const void *buffer, qint32 size, const qint64 msecStart);
+	void onStreamProgress(StreamProcessor *stream, quint64 msecPos);
+	void onStreamFinished(const WaveFormat *format);
+
+	static QString cacheFilePath(const QString &mediaFile, int audioStream);
+	bool loadCache();
+	void saveCache() const;
+	static void pruneCache(const QString &cacheDir);
 
 private:
 	WaveformWidget *m_wfWidget;
 
+	// first segment is decoded by the shared decoder, other segments have their own
 	StreamProcessor *m_stream;
+	const WaveFormat *m_streamFormat;
+	QVector<StreamProcessor *> m_streams;
 
 	quint64 m_waveformDuration;
 	quint32 m_waveformChannelSize;
@@ -93,9 +128,15 @@ private:
 
 	quint32 m_samplesSec;
 
-	struct WaveformFrame *m_wfFrame;
+	QVector<struct WaveformFrame *> m_segments;
+	mutable QMutex m_segmentsMutex;
+	mutable QWaitCondition m_samplesDecoded;
 
 	ZoomBuffer *m_zoomBuffer;
+
+	QString m_cachePath;
+	QFile m_cacheFile;
+	bool m_cacheable;
 };
 }
 
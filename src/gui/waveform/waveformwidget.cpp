@@ -16,6 +16,7 @@
 #include "gui/treeview/lineswidget.h"
 #include "gui/waveform/wavebuffer.h"
 #include "gui/waveform/waverenderer.h"
+#include "gui/waveform/wavetilecache.h"
 #include "gui/waveform/zoombuffer.h"
 
 #include <QRect>
@@ -36,6 +37,8 @@
 
 #include <KLocalizedString>
 
+#include <algorithm>
+
 using namespace SubtitleComposer;
 
 #define ZOOM_MIN (1 << 3)
@@ -65,6 +68,7 @@ WaveformWidget::WaveformWidget(QWidget *parent)
 	  m_showTranslation(false),
 	  m_wfBuffer(new WaveBuffer(this)),
 	  m_zoomData(nullptr),
+	  m_zoomDataStart(0),
 	  m_zoomDataLen(0)
 {
 	m_widgetLayout = new QBoxLayout(QBoxLayout::LeftToRight);
@@ -174,6 +178,12 @@ WaveformWidget::windowSizeInner(double *autoScrollPadding) const
 	return qMax(innerSize, 1.);
 }
 
+bool
+WaveformWidget::analyzeSpeech(WaveSpeechBoundaries *boundaries) const
+{
+	return m_wfBuffer->analyzeSpeech(boundaries);
+}
+
 void
 WaveformWidget::setZoom(quint32 val)
 {
@@ -228,7 +238,8 @@ WaveformWidget::handleTimeUpdate(quint32 msSpan)
 		m_wfBuffer->zoomBuffer()->setZoomScale(m_zoom);
 		if(!m_zoomData)
 			m_zoomData = new WaveZoomData *[chans];
-		m_wfBuffer->zoomBuffer()->zoomedBuffer(m_timeStart.toMillis(), m_timeEnd.toMillis(), m_zoomData, &m_zoomDataLen);
+		// whole tiles are requested so the ones on window edges don't change while scrolling
+		m_wfBuffer->zoomBuffer()->zoomedBuffer(m_timeStart.toMillis(), m_timeEnd.toMillis(), WAVE_TILE_SIZE, m_zoomData, &m_zoomDataStart, &m_zoomDataLen);
 	}
 
 	m_visibleLinesDirty = true;
@@ -357,7 +368,10 @@ WaveformWidget::clearAudioStream()
 
 	delete[] m_zoomData;
 	m_zoomData = nullptr;
+	m_zoomDataStart = 0;
 	m_zoomDataLen = 0;
+
+	m_waveformGraphics->clearWaveformCache();
 }
 
 void
@@ -381,12 +395,17 @@ WaveformWidget::updateVisibleLines()
 		}
 	}
 
+	QList<SubtitleLine *> lines = m_subtitle->linesInTimespan(m_timeStart, m_timeEnd);
+	if(m_draggedLine && m_draggedLine->line()->subtitle() == m_subtitle.data() && !lines.contains(m_draggedLine->line())) {
+		const int draggedIndex = m_draggedLine->line()->index();
+		auto pos = std::lower_bound(lines.begin(), lines.end(), draggedIndex,
+			[](const SubtitleLine *line, int index){ return line->index() < index; });
+		lines.insert(pos, m_draggedLine->line());
+	}
+
 	it = m_visibleLines.begin();
-	for(int i = 0, n = m_subtitle->count(); i < n; i++) {
-		SubtitleLine *sub = m_subtitle->at(i);
+	for(SubtitleLine *sub : qAsConst(lines)) {
 		const bool isDragged = m_draggedLine != nullptr && sub == m_draggedLine->line();
-		if(!sub->intersectsTimespan(m_timeStart, m_timeEnd) && !isDragged)
-			continue;
 		const Time showTime = isDragged ? m_draggedLine->showTime() : sub->showTime();
 		while(it != m_visibleLines.end() && (*it)->showTime() < showTime) {
 			if((*it)->line() == sub)
@@ -710,20 +729,9 @@ WaveformWidget::showContextMenu(QPoint pos)
 		menu->addSeparator();
 		needSubtitle.append(
 			menu->addAction(i18n("Join Lines"), this, [=](){
-				int startIndex = -1, endIndex = -1;
-				const Time startTime = rightMouseSoonerTime();
-				const Time endTime = rightMouseLaterTime();
-				for(int idx = 0, n = m_subtitle->count(); idx < n; idx++) {
-					const SubtitleLine *sub = m_subtitle->at(idx);
-					if(sub->intersectsTimespan(startTime, endTime)) {
-						if(startIndex == -1 || startIndex > idx)
-							startIndex = idx;
-						if(endIndex == -1 || endIndex < idx)
-							endIndex = idx;
-					}
-				}
-				if(endIndex >= 0 && startIndex != endIndex)
-					m_subtitle->joinLines(RangeList(Range(startIndex, endIndex)));
+				const QList<SubtitleLine *> lines = m_subtitle->linesInTimespan(rightMouseSoonerTime(), rightMouseLaterTime());
+				if(lines.size() > 1)
+					m_subtitle->joinLines(RangeList(Range(lines.first()->index(), lines.last()->index())));
 			})
 		);
 		needCurrentLine.append(
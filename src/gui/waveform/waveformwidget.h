@@ -30,6 +30,7 @@ QT_FORWARD_DECLARE_CLASS(QBoxLayout)
 namespace SubtitleComposer {
 class WaveBuffer;
 class WaveRenderer;
+class WaveSpeechBoundaries;
 struct WaveZoomData;
 
 class WaveformWidget : public QWidget
@@ -67,6 +68,12 @@ public:
 	inline void zoomIn() { setZoom(zoom() / 2); }
 	inline void zoomOut() { setZoom(zoom() * 2); }
 
+	/**
+	 * @brief Find speech boundaries in the decoded audio
+	 * @return false if there is no audio
+	 */
+	bool analyzeSpeech(WaveSpeechBoundaries *boundaries) const;
+
 signals:
 	void doubleClick(Time time);
 	void middleMouseDown(Time time);
@@ -163,6 +170,7 @@ private:
 	WaveBuffer *m_wfBuffer;
 
 	WaveZoomData **m_zoomData;
+	quint32 m_zoomDataStart;
 	quint32 m_zoomDataLen;
 
 	friend class WaveRenderer;
@@ -0,0 +1,189 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef WAVEKERNELS_H
+#define WAVEKERNELS_H
+
+#include "gui/waveform/wavebuffer.h"
+
+#include <QVarLengthArray>
+#include <QtMath>
+
+#include <algorithm>
+
+/*
+ * Inner loops of waveform decoding and zooming.
+ *
+ * Loops are kept free of modulo indexing, branches and function calls so the compiler
+ * can vectorize them for whatever instruction set the build is targeting.
+ */
+
+namespace SubtitleComposer {
+namespace WaveKernels {
+
+// interpolated scale table has at most this many entries
+#define SCALE_LUT_SIZE 512
+// samples below this many table steps are looked up exactly, interpolation error of the steep start of the curve is too large
+#define SCALE_LUT_EXACT_STEPS 4
+
+/**
+ * @brief Number of samples per scale table step, so the table of SAMPLE_MAX range has at most SCALE_LUT_SIZE entries
+ */
+constexpr int
+scaleLutShift()
+{
+	int shift = 0;
+	while((SAMPLE_MAX >> shift) >= SCALE_LUT_SIZE)
+		shift++;
+	return shift;
+}
+
+/**
+ * @brief Reference sqrt scaling of decimated sample, only positive half of the wave is kept
+ */
+inline SAMPLE_TYPE
+scaleSampleExact(qint32 sample)
+{
+	static const qreal valMax = qreal(SAMPLE_MAX - SAMPLE_MIN) / 2.;
+	return sample <= 0 ? 0 : SAMPLE_TYPE(qSqrt(qreal(sample) / valMax) * SAMPLE_MAX);
+}
+
+/**
+ * @brief Same as scaleSampleExact() interpolated from a lookup table
+ *
+ * Relative error is below 1%, samples close to zero are exact.
+ */
+inline SAMPLE_TYPE
+scaleSample(qint32 sample)
+{
+	constexpr int shift = scaleLutShift();
+	constexpr qint32 exactEnd = SCALE_LUT_EXACT_STEPS << shift;
+	static const struct ScaleLUT {
+		ScaleLUT() {
+			for(qint32 i = 0; i < exactEnd; i++)
+				exact[i] = scaleSampleExact(i);
+			for(qint32 i = 0; i <= (SAMPLE_MAX >> shift) + 1; i++)
+				val[i] = scaleSampleExact(qMin(i << shift, SAMPLE_MAX));
+		}
+		qint32 exact[exactEnd];
+		qint32 val[(SAMPLE_MAX >> shift) + 2];
+	} lut;
+
+	if(sample <= 0)
+		return 0;
+	if(sample < exactEnd)
+		return lut.exact[sample];
+	const qint32 i = sample >> shift;
+	const qint32 frac = sample & ((1 << shift) - 1);
+	return lut.val[i] + (((lut.val[i + 1] - lut.val[i]) * frac) >> shift);
+}
+
+/**
+ * @brief Distance of the sample from silence
+ */
+inline quint32
+amplitude(SAMPLE_TYPE sample)
+{
+	return qAbs(qint32(sample) - SAMPLE_MIN - (SAMPLE_MAX - SAMPLE_MIN) / 2);
+}
+
+/**
+ * @brief Sum and peak of amplitudes of @p count samples
+ */
+inline void
+amplitudeSumMax(const SAMPLE_TYPE *samples, quint32 count, quint64 *sum, quint32 *max)
+{
+	quint64 s = 0;
+	quint32 m = 0;
+	for(quint32 i = 0; i < count; i++) {
+		const quint32 val = amplitude(samples[i]);
+		s += val;
+		m = qMax(m, val);
+	}
+	*sum += s;
+	*max = qMax(*max, m);
+}
+
+/**
+ * @brief Average and peak amplitude of samples [@p start, @p end) using zoom @p level of 2^@p shift samples per entry
+ *
+ * Only entries that lie completely inside the range and are among the first @p available ones are used,
+ * samples of partially covered entries are read from @p samples. Null @p level reads all of them.
+ */
+inline WaveZoomData
+reduceZoomLevel(const SAMPLE_TYPE *samples, const WaveZoomData *level, quint8 shift, quint32 available, quint32 start, quint32 end)
+{
+	quint64 sum = 0;
+	quint32 max = 0;
+
+	const quint32 iStart = level ? ((start >> shift) + ((start & ((1U << shift) - 1)) != 0)) : 0;
+	const quint32 iEnd = level ? qMin(end >> shift, available) : 0;
+	if(iStart >= iEnd) {
+		amplitudeSumMax(samples + start, end - start, &sum, &max);
+		return WaveZoomData{quint32(sum / (end - start)), max};
+	}
+
+	// WaveZoomData::min is holding the average value
+	for(quint32 i = iStart; i < iEnd; i++) {
+		sum += level[i].min;
+		max = qMax(max, level[i].max);
+	}
+	sum <<= shift;
+
+	amplitudeSumMax(samples + start, (iStart << shift) - start, &sum, &max);
+	amplitudeSumMax(samples + (iEnd << shift), end - (iEnd << shift), &sum, &max);
+	return WaveZoomData{quint32(sum / (end - start)), max};
+}
+
+template<int CH>
+inline void
+decimateChannels(const SAMPLE_TYPE *in, quint32 frames, quint8 shift, SAMPLE_TYPE * const *out, quint32 offset)
+{
+	const quint32 frameLen = 1U << shift;
+	for(quint32 f = 0; f < frames; f++) {
+		qint32 acc[CH] = {};
+		for(quint32 i = 0; i < frameLen; i++) {
+			for(int c = 0; c < CH; c++)
+				acc[c] += in[c];
+			in += CH;
+		}
+		for(int c = 0; c < CH; c++)
+			out[c][offset + f] = scaleSample(acc[c] >> shift);
+	}
+}
+
+/**
+ * @brief Downmix @p frames frames of 2^@p shift interleaved samples into one scaled sample per channel
+ *
+ * Results are written to @p out[channel][@p offset + frame].
+ */
+inline void
+decimate(const SAMPLE_TYPE *in, quint32 frames, quint16 channels, quint8 shift, SAMPLE_TYPE * const *out, quint32 offset)
+{
+	switch(channels) {
+	case 1: decimateChannels<1>(in, frames, shift, out, offset); return;
+	case 2: decimateChannels<2>(in, frames, shift, out, offset); return;
+	case 6: decimateChannels<6>(in, frames, shift, out, offset); return;
+	}
+
+	const quint32 frameLen = 1U << shift;
+	QVarLengthArray<qint32, 16> acc(channels);
+	for(quint32 f = 0; f < frames; f++) {
+		std::fill(acc.begin(), acc.end(), 0);
+		for(quint32 i = 0; i < frameLen; i++) {
+			for(quint16 c = 0; c < channels; c++)
+				acc[c] += in[c];
+			in += channels;
+		}
+		for(quint16 c = 0; c < channels; c++)
+			out[c][offset + f] = scaleSample(acc[c] >> shift);
+	}
+}
+
+}
+}
+
+#endif // WAVEKERNELS_H
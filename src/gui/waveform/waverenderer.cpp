@@ -13,6 +13,8 @@
 #include "gui/waveform/wavebuffer.h"
 #include "gui/waveform/waveformwidget.h"
 #include "gui/waveform/wavesubtitle.h"
+#include "gui/waveform/wavetextcache.h"
+#include "gui/waveform/wavetilecache.h"
 #include "gui/waveform/zoombuffer.h"
 
 #include <QBoxLayout>
@@ -25,13 +27,17 @@ using namespace SubtitleComposer;
 
 WaveRenderer::WaveRenderer(WaveformWidget *parent)
 	: QWidget(parent),
-	  m_wfw(parent)
+	  m_wfw(parent),
+	  m_tileCache(new WaveTileCache(this)),
+	  m_textCache(new WaveTextCache(this))
 {
 	setAttribute(Qt::WA_NoSystemBackground, true);
 	setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
 	setMouseTracking(true);
 
 	connect(SCConfig::self(), &SCConfig::configChanged, this, &WaveRenderer::onConfigChanged);
+	connect(m_tileCache, &WaveTileCache::tilesUpdated, this, QOverload<>::of(&QWidget::update));
+	connect(m_textCache, &WaveTextCache::imagesUpdated, this, QOverload<>::of(&QWidget::update));
 	onConfigChanged();
 }
 
@@ -41,6 +47,13 @@ WaveRenderer::showTranslation() const
 	return m_wfw->m_showTranslation;
 }
 
+void
+WaveRenderer::clearWaveformCache()
+{
+	m_tileCache->clear();
+	m_samplesDecoded = 0;
+}
+
 void
 WaveRenderer::onConfigChanged()
 {
@@ -52,10 +65,11 @@ WaveRenderer::onConfigChanged()
 
 	m_subNumberColor = QPen(QColor(SCConfig::wfSubNumberColor()), 0, Qt::SolidLine);
 	m_subTextColor = QPen(QColor(SCConfig::wfSubTextColor()), 0, Qt::SolidLine);
+	m_textCache->setStyle(m_fontText, m_subTextColor.color().rgba());
 
-	// FIXME: instead of using devicePixelRatioF() for pen width we should draw waveform in higher resolution
-	m_waveInner = QPen(QColor(SCConfig::wfInnerColor()), devicePixelRatioF(), Qt::SolidLine);
-	m_waveOuter = QPen(QColor(SCConfig::wfOuterColor()), devicePixelRatioF(), Qt::SolidLine);
+	// waveform tiles are rasterized at logical pixels, only the color is used
+	m_waveInner = QPen(QColor(SCConfig::wfInnerColor()), 0, Qt::SolidLine);
+	m_waveOuter = QPen(QColor(SCConfig::wfOuterColor()), 0, Qt::SolidLine);
 
 	m_subtitleBack = QColor(SCConfig::wfSubBackground());
 	m_subtitleBorder = QColor(SCConfig::wfSubBorder());
@@ -136,27 +150,45 @@ void
 WaveRenderer::paintWaveform(QPainter &painter, quint32 widgetWidth, quint32 widgetHeight)
 {
 	const quint16 chans = m_wfw->m_wfBuffer->channels();
-	if(!chans || !m_wfw->m_zoomDataLen)
+	// zoom thread is extending the available length
+	const quint32 zoomDataLen = m_wfw->m_zoomDataLen;
+	if(!chans || !zoomDataLen)
 		return;
 
 	const quint32 chHalfWidth = (m_vertical ? widgetWidth : widgetHeight) / chans / 2;
+	m_tileCache->setStyle(WaveTileStyle{m_vertical, chHalfWidth, m_waveOuter.color().rgba(), m_waveInner.color().rgba()});
 
-	for(quint16 ch = 0; ch < chans; ch++) {
-		const qint32 chCenter = (ch * 2 + 1) * chHalfWidth;
-		for(quint32 y = 0; y < m_wfw->m_zoomDataLen; y++) {
-			const qint32 xMin = m_wfw->m_zoomData[ch][y].min * chHalfWidth / SAMPLE_MAX;
-			const qint32 xMax = m_wfw->m_zoomData[ch][y].max * chHalfWidth / SAMPLE_MAX;
+	// pixels of tiles past the previously decoded samples could have changed
+	const quint32 samplesDecoded = m_wfw->m_wfBuffer->samplesAvailable();
+	if(m_samplesDecoded != samplesDecoded) {
+		m_tileCache->invalidate(qMin(m_samplesDecoded, samplesDecoded));
+		m_samplesDecoded = samplesDecoded;
+	}
 
-			painter.setPen(m_waveOuter);
-			if(m_vertical)
-				painter.drawLine(chCenter - xMax, y, chCenter + xMax, y);
-			else
-				painter.drawLine(y, chCenter - xMax, y, chCenter + xMax);
-			painter.setPen(m_waveInner);
+	const ZoomBuffer *zoomBuffer = m_wfw->m_wfBuffer->zoomBuffer();
+	const quint32 samplesPerPixel = zoomBuffer->samplesPerPixel();
+	// zoomed data starts at the first visible tile
+	const quint32 dataStart = m_wfw->m_zoomDataStart;
+	const quint32 dataEnd = dataStart + zoomDataLen;
+	const quint32 first = zoomBuffer->pixelIndex(m_wfw->m_timeStart.toMillis());
+	const quint32 end = qMin(zoomBuffer->pixelIndex(m_wfw->m_timeEnd.toMillis()), dataEnd);
+
+	// waveform is blitted from cached tiles, cached ones that need more pixels are rendered in background
+	for(quint32 index = first / WAVE_TILE_SIZE; index * WAVE_TILE_SIZE < end; index++) {
+		const quint32 tileStart = index * WAVE_TILE_SIZE;
+		if(tileStart < dataStart)
+			continue;
+		const quint32 to = qMin(dataEnd - tileStart, quint32(WAVE_TILE_SIZE));
+		const int pos = int(tileStart) - int(first);
+		for(quint16 ch = 0; ch < chans; ch++) {
+			const QImage tile = m_tileCache->tile(samplesPerPixel, index, ch, m_wfw->m_zoomData[ch] + (tileStart - dataStart), 0, to);
+			if(tile.isNull())
+				continue;
+			const int lane = ch * 2 * chHalfWidth;
 			if(m_vertical)
-				painter.drawLine(chCenter - xMin, y, chCenter + xMin, y);
+				painter.drawImage(lane, pos, tile);
 			else
-				painter.drawLine(y, chCenter - xMin, y, chCenter + xMin);
+				painter.drawImage(pos, lane, tile);
 		}
 	}
 }
@@ -16,6 +16,8 @@
 
 namespace SubtitleComposer {
 class WaveformWidget;
+class WaveTextCache;
+class WaveTileCache;
 
 class WaveRenderer : public QWidget
 {
@@ -27,11 +29,12 @@ public:
 	inline int span() const { return m_vertical ? height() : width(); }
 	inline bool vertical() const { return m_vertical; }
 
-	inline const QFont & fontText() const { return m_fontText; }
-	inline const QPen & subTextColor() const { return m_subTextColor; }
+	inline WaveTextCache * textCache() const { return m_textCache; }
 
 	bool showTranslation() const;
 
+	void clearWaveformCache();
+
 private:
 	bool event(QEvent *evt) override;
 
@@ -42,6 +45,9 @@ private:
 
 private:
 	WaveformWidget *m_wfw;
+	WaveTileCache *m_tileCache;
+	WaveTextCache *m_textCache;
+	quint32 m_samplesDecoded = 0;
 
 	bool m_vertical = false;
 
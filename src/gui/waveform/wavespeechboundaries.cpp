@@ -0,0 +1,113 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "wavespeechboundaries.h"
+
+#include <algorithm>
+
+// analyzed frames per second
+#define FRAME_RATE 100
+// RMS window is centered on the frame and spans this many frames on each side
+#define WINDOW_HALF_FRAMES 1
+// waveform samples are sqrt scaled so their mean square follows the amplitude,
+// this is mean square of quietest speech (-40dBFS)
+#define MIN_SPEECH_ENERGY (qint64(SAMPLE_MAX) * SAMPLE_MAX / 100)
+// speech starts 12dB above the noise floor and ends 6dB lower
+#define SPEECH_NOISE_RATIO 4
+#define HYSTERESIS_RATIO 2
+// noise floor is the level that quietest tenth of frames is below
+#define NOISE_PERCENTILE 10
+// pause that ends the speech
+#define HANG_FRAMES 15
+// speech shorter than this is noise
+#define MIN_SPEECH_FRAMES 10
+
+using namespace SubtitleComposer;
+
+WaveSpeechBoundaries::WaveSpeechBoundaries()
+{
+}
+
+void
+WaveSpeechBoundaries::clear()
+{
+	m_onsets.clear();
+	m_offsets.clear();
+}
+
+void
+WaveSpeechBoundaries::analyze(const SAMPLE_TYPE * const *waveform, quint16 channels, quint32 length, quint32 sampleRate)
+{
+	clear();
+
+	const quint32 frameLen = qMax(1U, sampleRate / FRAME_RATE);
+	const int frames = length / frameLen;
+	if(!channels || !frames)
+		return;
+
+	// prefix sums of frame mean squares make every window a single subtraction
+	QVector<qint64> energySum(frames + 1);
+	energySum[0] = 0;
+	for(int f = 0; f < frames; f++) {
+		qint64 sum = 0;
+		for(quint16 c = 0; c < channels; c++) {
+			const SAMPLE_TYPE *sample = waveform[c] + f * frameLen;
+			for(quint32 i = 0; i < frameLen; i++)
+				sum += qint32(sample[i]) * sample[i];
+		}
+		energySum[f + 1] = energySum[f] + sum / (frameLen * channels);
+	}
+
+	QVector<qint64> energy(frames);
+	for(int f = 0; f < frames; f++) {
+		const int start = qMax(0, f - WINDOW_HALF_FRAMES);
+		const int end = qMin(frames, f + WINDOW_HALF_FRAMES + 1);
+		energy[f] = (energySum[end] - energySum[start]) / (end - start);
+	}
+	energySum.clear();
+
+	QVector<qint64> sorted = energy;
+	const auto noiseIt = sorted.begin() + sorted.size() * NOISE_PERCENTILE / 100;
+	std::nth_element(sorted.begin(), noiseIt, sorted.end());
+	const qint64 speechLevel = qMax(*noiseIt * SPEECH_NOISE_RATIO, MIN_SPEECH_ENERGY);
+	const qint64 silenceLevel = speechLevel / HYSTERESIS_RATIO;
+	sorted.clear();
+
+	const double frameMillis = double(frameLen) * 1000. / sampleRate;
+	auto addSpeech = [&](int start, int end){
+		if(end - start < MIN_SPEECH_FRAMES)
+			return;
+		m_onsets.push_back(start * frameMillis);
+		m_offsets.push_back(end * frameMillis);
+	};
+
+	bool speech = false;
+	int speechStart = 0;
+	int speechEnd = 0;
+	int quietFrames = 0;
+	for(int f = 0; f < frames; f++) {
+		if(!speech) {
+			if(energy[f] > speechLevel) {
+				// speech started where the level crossed the lower threshold
+				speechStart = f;
+				while(speechStart > speechEnd && energy[speechStart - 1] > silenceLevel)
+					speechStart--;
+				speech = true;
+				quietFrames = 0;
+			}
+		} else if(energy[f] < silenceLevel) {
+			if(++quietFrames >= HANG_FRAMES) {
+				speechEnd = f - quietFrames + 1;
+				addSpeech(speechStart, speechEnd);
+				speech = false;
+			}
+		} else {
+			quietFrames = 0;
+		}
+	}
+	if(speech)
+		addSpeech(speechStart, frames - quietFrames);
+}
@@ -0,0 +1,48 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef WAVESPEECHBOUNDARIES_H
+#define WAVESPEECHBOUNDARIES_H
+
+#include "gui/waveform/wavebuffer.h"
+
+#include <QVector>
+
+namespace SubtitleComposer {
+/**
+ * @brief Finds where speech starts and ends in the decoded waveform
+ *
+ * Waveform samples are analyzed in 10ms frames with a sliding window RMS, speech is detected
+ * when it rises well above the noise floor and ends when it falls back near it. Different
+ * start and end thresholds keep short dips inside words from splitting the speech.
+ */
+class WaveSpeechBoundaries
+{
+public:
+	WaveSpeechBoundaries();
+
+	/**
+	 * @brief Analyze first @p length samples of every one of @p channels waveform channels
+	 */
+	void analyze(const SAMPLE_TYPE * const *waveform, quint16 channels, quint32 length, quint32 sampleRate);
+	void clear();
+
+	/**
+	 * @brief Sorted times when speech starts, in milliseconds
+	 */
+	inline const QVector<double> & onsets() const { return m_onsets; }
+	/**
+	 * @brief Sorted times when speech ends, in milliseconds
+	 */
+	inline const QVector<double> & offsets() const { return m_offsets; }
+
+private:
+	QVector<double> m_onsets;
+	QVector<double> m_offsets;
+};
+}
+
+#endif // WAVESPEECHBOUNDARIES_H
@@ -9,12 +9,7 @@
 #include "core/richtext/richdocument.h"
 #include "core/subtitleline.h"
 #include "gui/waveform/waverenderer.h"
-
-#include <QPainter>
-#include <QScopedPointer>
-#include <QTextBlock>
-#include <QTextLayout>
-#include <QTextLine>
+#include "gui/waveform/wavetextcache.h"
 
 using namespace SubtitleComposer;
 
@@ -24,8 +19,7 @@ WaveSubtitle::WaveSubtitle(SubtitleLine *line, WaveRenderer *parent)
 	  m_rend(parent),
 	  m_image(1, 1, QImage::Format_ARGB32_Premultiplied)
 {
-	const RichDocument *doc = m_rend->showTranslation() ? m_line->secondaryDoc() : m_line->primaryDoc();
-	connect(doc, &RichDocument::contentsChanged, this, [&](){ m_imageDirty = true; });
+	m_image.fill(Qt::transparent);
 }
 
 WaveSubtitle::~WaveSubtitle()
@@ -133,61 +127,8 @@ WaveSubtitle::hideTime() const
 const QImage &
 WaveSubtitle::image() const
 {
-	if(!m_imageDirty)
-		return m_image;
-
+	// previous image is kept while the changed text is rendering
 	const RichDocument *doc = m_rend->showTranslation() ? m_line->secondaryDoc() : m_line->primaryDoc();
-	const RichDocumentLayout *layout = doc->documentLayout();
-
-	qreal width = 0., height = 0.;
-	QScopedPointer<QTextLayout, QScopedPointerArrayDeleter<QTextLayout>> layouts(new QTextLayout[doc->blockCount()]);
-
-	QTextLayout *bl = layouts.data();
-	for(QTextBlock bi = doc->begin(); bi != doc->end(); bi = bi.next()) {
-		bl->setCacheEnabled(true);
-		bl->setFont(m_rend->fontText());
-		bl->setText(bi.text());
-		bl->setFormats(layout->applyCSS(bi.textFormats()));
-		bl->beginLayout();
-		QTextOption option = bi.layout()->textOption();
-		option.setAlignment(Qt::AlignTop | Qt::AlignLeft | Qt::AlignAbsolute);
-		bl->setTextOption(option);
-		for(;;) {
-			QTextLine line = bl->createLine();
-			if(!line.isValid())
-				break;
-			line.setLeadingIncluded(true);
-			line.setLineWidth(10000);
-			line.setPosition(QPointF(0., height));
-			height += line.height();
-			width = qMax(width, line.naturalTextWidth());
-		}
-		bl->endLayout();
-		bl++;
-	}
-
-	m_image = QImage(QSize(width, height), QImage::Format_ARGB32_Premultiplied);
-	if(m_image.isNull())
-		return m_image;
-	m_image.fill(Qt::transparent);
-	QScopedPointer<QPainter> painter(new QPainter(&m_image));
-	if(!painter->isActive())
-		return m_image;
-	painter->setRenderHints(QPainter::Antialiasing | QPainter::TextAntialiasing | QPainter::SmoothPixmapTransform);
-	painter->setFont(m_rend->fontText());
-	painter->setPen(m_rend->subTextColor());
-
-	while(bl-- != layouts.data()) {
-		const int n = bl->lineCount();
-		for(int i = 0; i < n; i++) {
-			const QTextLine &tl = bl->lineAt(i);
-			const QPointF pos((width - tl.naturalTextWidth()) / 2., 0.);
-			tl.draw(painter.data(), pos);
-		}
-	}
-
-	painter->end();
-
-	m_imageDirty = false;
+	m_rend->textCache()->image(doc, &m_image);
 	return m_image;
 }
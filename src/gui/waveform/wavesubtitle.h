@@ -12,8 +12,6 @@
 #include <QImage>
 #include <QObject>
 
-QT_FORWARD_DECLARE_CLASS(QTextLayout)
-
 namespace SubtitleComposer {
 class SubtitleLine;
 class WaveRenderer;
@@ -53,7 +51,6 @@ private:
 	WaveRenderer *m_rend;
 
 	mutable QImage m_image;
-	mutable bool m_imageDirty = true;
 
 	DragPosition m_dragMode = DRAG_NONE;
 	double m_dragTime = 0.;
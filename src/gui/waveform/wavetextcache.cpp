@@ -0,0 +1,207 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "wavetextcache.h"
+
+#include "core/richtext/richdocument.h"
+
+#include <QFontDatabase>
+#include <QMutexLocker>
+#include <QPainter>
+#include <QRunnable>
+#include <QScopedPointer>
+#include <QTextBlock>
+#include <QTextLine>
+
+// memory used by cached images in KiB
+#define TEXT_CACHE_SIZE (32 * 1024)
+
+namespace SubtitleComposer {
+class WaveTextJob : public QRunnable
+{
+public:
+	WaveTextJob(WaveTextCache *cache, int generation, const WaveTextKey &key, const QVector<WaveTextBlock> &blocks,
+				const QFont &font, QRgb color)
+		: m_cache(cache),
+		  m_generation(generation),
+		  m_key(key),
+		  m_blocks(blocks),
+		  m_font(font),
+		  m_color(color)
+	{
+	}
+
+	void run() override
+	{
+		m_cache->deliver(m_generation, m_key, WaveTextCache::render(m_blocks, m_font, m_color));
+	}
+
+private:
+	WaveTextCache *m_cache;
+	int m_generation;
+	WaveTextKey m_key;
+	QVector<WaveTextBlock> m_blocks;
+	QFont m_font;
+	QRgb m_color;
+};
+}
+
+using namespace SubtitleComposer;
+
+WaveTextCache::WaveTextCache(QObject *parent)
+	: QObject(parent),
+	  m_color(0),
+	  m_images(TEXT_CACHE_SIZE),
+	  m_generation(0),
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+	  m_threaded(QFontDatabase::supportsThreadedFontRendering())
+#else
+	  m_threaded(true)
+#endif
+{
+	m_pool.setMaxThreadCount(1);
+}
+
+WaveTextCache::~WaveTextCache()
+{
+	m_pool.clear();
+	m_pool.waitForDone();
+}
+
+void
+WaveTextCache::setStyle(const QFont &font, QRgb color)
+{
+	if(m_font == font && m_color == color)
+		return;
+	m_font = font;
+	m_color = color;
+	clear();
+}
+
+void
+WaveTextCache::clear()
+{
+	m_pool.clear();
+
+	QMutexLocker l(&m_resultsMutex);
+	m_generation++;
+	m_results.clear();
+	m_pending.clear();
+	m_images.clear();
+}
+
+void
+WaveTextCache::deliver(int generation, const WaveTextKey &key, const QImage &image)
+{
+	{
+		QMutexLocker l(&m_resultsMutex);
+		if(generation != m_generation)
+			return;
+		m_results.insert(key, image);
+	}
+	emit imagesUpdated();
+}
+
+void
+WaveTextCache::collectResults()
+{
+	QMutexLocker l(&m_resultsMutex);
+	for(auto it = m_results.cbegin(); it != m_results.cend(); ++it) {
+		m_pending.remove(it.key());
+		const QImage &image = it.value();
+		m_images.insert(it.key(), new QImage(image), qMax(1, image.bytesPerLine() * image.height() / 1024));
+	}
+	m_results.clear();
+}
+
+bool
+WaveTextCache::image(const RichDocument *doc, QImage *image)
+{
+	collectResults();
+
+	const RichCSS *css = doc->stylesheet();
+	const WaveTextKey key{doc->cacheKey(), css ? css->cacheKey() : 0};
+	if(const QImage *cached = m_images.object(key)) {
+		*image = *cached;
+		return true;
+	}
+
+	if(m_pending.contains(key))
+		return false;
+
+	// document can only be accessed from GUI thread - grab styled blocks for the renderer
+	const RichDocumentLayout *layout = doc->documentLayout();
+	QVector<WaveTextBlock> blocks;
+	blocks.reserve(doc->blockCount());
+	for(QTextBlock bi = doc->begin(); bi != doc->end(); bi = bi.next())
+		blocks.push_back(WaveTextBlock{bi.text(), layout->applyCSS(bi.textFormats()), bi.layout()->textOption()});
+
+	if(!m_threaded) {
+		*image = render(blocks, m_font, m_color);
+		m_images.insert(key, new QImage(*image), qMax(1, image->bytesPerLine() * image->height() / 1024));
+		return true;
+	}
+
+	m_pending.insert(key);
+	m_pool.start(new WaveTextJob(this, m_generation, key, blocks, m_font, m_color));
+
+	return false;
+}
+
+QImage
+WaveTextCache::render(const QVector<WaveTextBlock> &blocks, const QFont &font, QRgb color)
+{
+	qreal width = 0., height = 0.;
+	QScopedPointer<QTextLayout, QScopedPointerArrayDeleter<QTextLayout>> layouts(new QTextLayout[blocks.size()]);
+
+	QTextLayout *bl = layouts.data();
+	for(const WaveTextBlock &block: blocks) {
+		bl->setCacheEnabled(true);
+		bl->setFont(font);
+		bl->setText(block.text);
+		bl->setFormats(block.formats);
+		bl->beginLayout();
+		QTextOption option = block.option;
+		option.setAlignment(Qt::AlignTop | Qt::AlignLeft | Qt::AlignAbsolute);
+		bl->setTextOption(option);
+		for(;;) {
+			QTextLine line = bl->createLine();
+			if(!line.isValid())
+				break;
+			line.setLeadingIncluded(true);
+			line.setLineWidth(10000);
+			line.setPosition(QPointF(0., height));
+			height += line.height();
+			width = qMax(width, line.naturalTextWidth());
+		}
+		bl->endLayout();
+		bl++;
+	}
+
+	QImage image(QSize(width, height), QImage::Format_ARGB32_Premultiplied);
+	if(image.isNull())
+		return image;
+	image.fill(Qt::transparent);
+	QPainter painter(&image);
+	if(!painter.isActive())
+		return image;
+	painter.setRenderHints(QPainter::Antialiasing | QPainter::TextAntialiasing | QPainter::SmoothPixmapTransform);
+	painter.setFont(font);
+	painter.setPen(QColor::fromRgba(color));
+
+	while(bl-- != layouts.data()) {
+		const int n = bl->lineCount();
+		for(int i = 0; i < n; i++) {
+			const QTextLine &tl = bl->lineAt(i);
+			const QPointF pos((width - tl.naturalTextWidth()) / 2., 0.);
+			tl.draw(&painter, pos);
+		}
+	}
+
+	painter.end();
+
+	return image;
+}
@@ -0,0 +1,104 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef WAVETEXTCACHE_H
+#define WAVETEXTCACHE_H
+
+#include <QCache>
+#include <QFont>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <QTextLayout>
+#include <QTextOption>
+#include <QThreadPool>
+#include <QVector>
+
+namespace SubtitleComposer {
+class RichDocument;
+
+struct WaveTextKey {
+	quint64 document;
+	quint64 stylesheet;
+
+	inline bool operator==(const WaveTextKey &other) const { return document == other.document && stylesheet == other.stylesheet; }
+};
+
+inline uint
+qHash(const WaveTextKey &key, uint seed = 0)
+{
+	return qHash(key.document, seed) ^ qHash(key.stylesheet, seed);
+}
+
+/**
+ * @brief Text of one document block with stylesheet already applied
+ */
+struct WaveTextBlock {
+	QString text;
+	QVector<QTextLayout::FormatRange> formats;
+	QTextOption option;
+};
+
+/**
+ * @brief Rendered subtitle text images shared by all waveform lines
+ *
+ * Images are keyed by document and stylesheet cache keys, so they outlive the lines that are
+ * currently visible and are reused when scrolling back. Missing images are rasterized in
+ * a background thread, imagesUpdated() is emitted when they are ready.
+ */
+class WaveTextCache : public QObject
+{
+	Q_OBJECT
+
+public:
+	explicit WaveTextCache(QObject *parent = nullptr);
+	virtual ~WaveTextCache();
+
+	/**
+	 * @brief Set font and color of the text - all images are dropped if they changed
+	 */
+	void setStyle(const QFont &font, QRgb color);
+
+	/**
+	 * @brief Get rendered image of @p doc
+	 *
+	 * If image is not cached a render is scheduled and @p image is left untouched.
+	 * @return true if @p image was updated
+	 */
+	bool image(const RichDocument *doc, QImage *image);
+
+	static QImage render(const QVector<WaveTextBlock> &blocks, const QFont &font, QRgb color);
+
+public slots:
+	void clear();
+
+signals:
+	void imagesUpdated();
+
+private:
+	void deliver(int generation, const WaveTextKey &key, const QImage &image);
+	void collectResults();
+
+	friend class WaveTextJob;
+
+private:
+	QFont m_font;
+	QRgb m_color;
+	QCache<WaveTextKey, QImage> m_images;
+	QSet<WaveTextKey> m_pending;
+	int m_generation;
+	bool m_threaded;
+
+	QMutex m_resultsMutex;
+	QHash<WaveTextKey, QImage> m_results;
+
+	QThreadPool m_pool;
+};
+}
+
+#endif // WAVETEXTCACHE_H
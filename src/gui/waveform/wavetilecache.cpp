@@ -0,0 +1,222 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "wavetilecache.h"
+
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QVector>
+
+// memory used by cached tiles in KiB
+#define TILE_CACHE_SIZE (64 * 1024)
+
+namespace SubtitleComposer {
+class WaveTileJob : public QRunnable
+{
+public:
+	WaveTileJob(WaveTileCache *cache, int generation, quint64 key, const WaveTileStyle &style,
+				const WaveZoomData *data, quint32 from, quint32 to, const QImage &base, quint32 tileFrom, quint32 tileTo)
+		: m_cache(cache),
+		  m_generation(generation),
+		  m_key(key),
+		  m_style(style),
+		  m_data(data, data + (to - from)),
+		  m_from(from),
+		  m_to(to),
+		  m_base(base),
+		  m_tileFrom(tileFrom),
+		  m_tileTo(tileTo)
+	{
+	}
+
+	void run() override
+	{
+		const QImage image = WaveTileCache::render(m_style, m_data.constData(), m_from, m_to, m_base);
+		m_cache->deliver(m_generation, m_key, image, m_tileFrom, m_tileTo);
+	}
+
+private:
+	WaveTileCache *m_cache;
+	int m_generation;
+	quint64 m_key;
+	WaveTileStyle m_style;
+	// copy of zoomed data - zoom buffer can be freed while the tile is rendering
+	QVector<WaveZoomData> m_data;
+	quint32 m_from;
+	quint32 m_to;
+	// pixels [m_tileFrom, m_tileTo) of the rendered tile are valid
+	QImage m_base;
+	quint32 m_tileFrom;
+	quint32 m_tileTo;
+};
+}
+
+using namespace SubtitleComposer;
+
+WaveTileCache::WaveTileCache(QObject *parent)
+	: QObject(parent),
+	  m_style{false, 0, 0, 0},
+	  m_tiles(TILE_CACHE_SIZE),
+	  m_generation(0)
+{
+	m_pool.setMaxThreadCount(1);
+}
+
+WaveTileCache::~WaveTileCache()
+{
+	m_pool.clear();
+	m_pool.waitForDone();
+}
+
+void
+WaveTileCache::setStyle(const WaveTileStyle &style)
+{
+	if(m_style == style)
+		return;
+	m_style = style;
+	clear();
+}
+
+void
+WaveTileCache::clear()
+{
+	m_pool.clear();
+
+	QMutexLocker l(&m_resultsMutex);
+	m_generation++;
+	m_results.clear();
+	m_pending.clear();
+	m_tiles.clear();
+}
+
+void
+WaveTileCache::deliver(int generation, quint64 key, const QImage &image, quint32 from, quint32 to)
+{
+	{
+		QMutexLocker l(&m_resultsMutex);
+		if(generation != m_generation)
+			return;
+		m_results.insert(key, Tile{image, from, to, false});
+	}
+	emit tilesUpdated();
+}
+
+void
+WaveTileCache::collectResults()
+{
+	QMutexLocker l(&m_resultsMutex);
+	for(auto it = m_results.cbegin(); it != m_results.cend(); ++it) {
+		m_pending.remove(it.key());
+		insertTile(it.key(), it.value());
+	}
+	m_results.clear();
+}
+
+void
+WaveTileCache::insertTile(quint64 key, const Tile &tile)
+{
+	m_tiles.insert(key, new Tile(tile), qMax(1, tile.image.bytesPerLine() * tile.image.height() / 1024));
+}
+
+void
+WaveTileCache::invalidate(quint32 sample)
+{
+	collectResults();
+
+	const QList<quint64> keys = m_tiles.keys();
+	for(const quint64 key : keys) {
+		const quint64 samplesPerPixel = key >> 32;
+		const quint64 index = (key >> 8) & 0xffffff;
+		if((index + 1) * WAVE_TILE_SIZE * samplesPerPixel <= sample)
+			continue;
+		m_tiles.object(key)->stale = true;
+		// renders that are already queued have old data, they are delivered first so the next one wins
+		m_pending.remove(key);
+	}
+}
+
+QImage
+WaveTileCache::tile(quint32 samplesPerPixel, quint32 index, quint16 channel, const WaveZoomData *data, quint32 from, quint32 to)
+{
+	Q_ASSERT(from < to && to <= WAVE_TILE_SIZE);
+
+	collectResults();
+
+	const quint64 key = (quint64(samplesPerPixel) << 32) | (quint64(index) << 8) | channel;
+	const Tile *cached = m_tiles.object(key);
+	if(!cached) {
+		// there is nothing to show meanwhile, rendering it now is better than leaving a gap
+		const Tile tile{render(m_style, data, from, to), from, to, false};
+		insertTile(key, tile);
+		return tile.image;
+	}
+
+	const QImage image = cached->image;
+	QImage base;
+	quint32 tileFrom = from;
+	quint32 tileTo = to;
+	if(!cached->stale) {
+		if(cached->from <= from && cached->to >= to)
+			return image;
+		// only [from, to) is available in zoomed data, it's drawn over the adjoining cached pixels
+		if(cached->from <= to && from <= cached->to) {
+			base = image;
+			tileFrom = qMin(from, cached->from);
+			tileTo = qMax(to, cached->to);
+		}
+	}
+
+	if(m_pending.contains(key))
+		return image;
+
+	m_pending.insert(key);
+	m_pool.start(new WaveTileJob(this, m_generation, key, m_style, data, from, to, base, tileFrom, tileTo));
+
+	return image;
+}
+
+static inline void
+fillSpan(QRgb *pixel, int step, int first, int last, QRgb color)
+{
+	for(int i = first; i <= last; i++)
+		pixel[i * step] = color;
+}
+
+QImage
+WaveTileCache::render(const WaveTileStyle &style, const WaveZoomData *data, quint32 from, quint32 to, const QImage &base)
+{
+	if(!style.halfWidth)
+		return QImage();
+
+	const qint32 laneWidth = style.halfWidth * 2;
+	const QSize size = style.vertical ? QSize(laneWidth, WAVE_TILE_SIZE) : QSize(WAVE_TILE_SIZE, laneWidth);
+	const bool composite = base.size() == size && base.format() == QImage::Format_ARGB32_Premultiplied;
+	QImage image = composite ? base : QImage(size, QImage::Format_ARGB32_Premultiplied);
+	if(!composite)
+		image.fill(Qt::transparent);
+
+	QRgb *bits = reinterpret_cast<QRgb *>(image.bits());
+	const int stride = image.bytesPerLine() / sizeof(QRgb);
+	// every zoomed pixel is a row of vertical tile or a column of horizontal one
+	const int pixelStep = style.vertical ? stride : 1;
+	const int spanStep = style.vertical ? 1 : stride;
+	const QRgb outer = qPremultiply(style.outer);
+	const QRgb inner = qPremultiply(style.inner);
+	const qint32 center = style.halfWidth;
+
+	for(quint32 i = from; i < to; i++, data++) {
+		// WaveZoomData::min is holding the average value
+		const qint32 outerHalf = data->max * style.halfWidth / SAMPLE_MAX;
+		const qint32 innerHalf = data->min * style.halfWidth / SAMPLE_MAX;
+		QRgb *pixel = bits + i * pixelStep;
+		if(composite)
+			fillSpan(pixel, spanStep, 0, laneWidth - 1, 0);
+		fillSpan(pixel, spanStep, qMax(0, center - outerHalf), qMin(laneWidth - 1, center + outerHalf), outer);
+		fillSpan(pixel, spanStep, qMax(0, center - innerHalf), qMin(laneWidth - 1, center + innerHalf), inner);
+	}
+
+	return image;
+}
@@ -0,0 +1,111 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef WAVETILECACHE_H
+#define WAVETILECACHE_H
+
+#include "gui/waveform/wavebuffer.h"
+
+#include <QCache>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <QThreadPool>
+
+// number of zoomed pixels along the time axis in one tile
+#define WAVE_TILE_SIZE 256
+
+namespace SubtitleComposer {
+struct WaveTileStyle {
+	bool vertical;
+	quint32 halfWidth;
+	QRgb outer;
+	QRgb inner;
+
+	inline bool operator==(const WaveTileStyle &other) const {
+		return vertical == other.vertical && halfWidth == other.halfWidth && outer == other.outer && inner == other.inner;
+	}
+	inline bool operator!=(const WaveTileStyle &other) const { return !operator==(other); }
+};
+
+/**
+ * @brief Waveform rasterized into images of WAVE_TILE_SIZE pixels per channel
+ *
+ * Tiles are keyed by zoom level, tile index and channel. Missing tiles are rendered right away, cached
+ * ones that need more pixels are rendered in a background thread from a copy of the zoomed data and
+ * tilesUpdated() is emitted when they are ready.
+ */
+class WaveTileCache : public QObject
+{
+	Q_OBJECT
+
+public:
+	explicit WaveTileCache(QObject *parent = nullptr);
+	virtual ~WaveTileCache();
+
+	/**
+	 * @brief Set look of the tiles - all tiles are dropped if it changed
+	 */
+	void setStyle(const WaveTileStyle &style);
+
+	/**
+	 * @brief Get image of tile @p index of @p channel at @p samplesPerPixel zoom
+	 *
+	 * Zoomed pixels [@p from, @p to) of the tile are currently available, @p data points to pixel @p from.
+	 * If cached tile doesn't cover them or it was invalidated a render is scheduled and the old image is returned.
+	 */
+	QImage tile(quint32 samplesPerPixel, quint32 index, quint16 channel, const WaveZoomData *data, quint32 from, quint32 to);
+
+	/**
+	 * @brief Rerender tiles of all zoom levels that show any sample after @p sample
+	 *
+	 * Invalidated tiles are still returned until they are rendered again.
+	 */
+	void invalidate(quint32 sample);
+
+	/**
+	 * @brief Render pixels [@p from, @p to) of a tile, @p data points to pixel @p from
+	 *
+	 * Other pixels are taken from @p base if it's a tile of the same style, otherwise they are transparent.
+	 */
+	static QImage render(const WaveTileStyle &style, const WaveZoomData *data, quint32 from, quint32 to, const QImage &base = QImage());
+
+public slots:
+	void clear();
+
+signals:
+	void tilesUpdated();
+
+private:
+	struct Tile {
+		QImage image;
+		quint32 from;
+		quint32 to;
+		bool stale;
+	};
+
+	void deliver(int generation, quint64 key, const QImage &image, quint32 from, quint32 to);
+	void collectResults();
+	void insertTile(quint64 key, const Tile &tile);
+
+	friend class WaveTileJob;
+
+private:
+	WaveTileStyle m_style;
+	QCache<quint64, Tile> m_tiles;
+	QSet<quint64> m_pending;
+	int m_generation;
+
+	QMutex m_resultsMutex;
+	QHash<quint64, Tile> m_results;
+
+	QThreadPool m_pool;
+};
+}
+
+#endif // WAVETILECACHE_H
@@ -6,6 +6,8 @@
 
 #include "zoombuffer.h"
 
+#include "gui/waveform/wavekernels.h"
+
 #include <list>
 
 struct DataRange {
@@ -14,6 +16,9 @@ struct DataRange {
 };
 typedef std::list<DataRange> RangeList;
 
+// first pyramid level holds 8 samples per entry - all levels together take as much memory as raw samples
+#define PYRAMID_SHIFT 3
+
 using namespace SubtitleComposer;
 
 ZoomBuffer::ZoomBuffer(WaveBuffer *parent)
@@ -22,19 +27,36 @@ ZoomBuffer::ZoomBuffer(WaveBuffer *parent)
 	  m_samplesPerPixel(0),
 	  m_waveformZoomed(nullptr),
 	  m_waveformZoomedSize(0),
-	  m_waveform(nullptr)
+	  m_waveform(nullptr),
+	  m_pyramidLength(0),
+	  m_pyramidChannels(0),
+	  m_pyramidSamples(0),
+	  m_pyramidLevel(-1)
 {
 }
 
 ZoomBuffer::~ZoomBuffer()
 {
 	stopAndClear();
+	clearPyramid();
+}
+
+void
+ZoomBuffer::clearPyramid()
+{
+	for(WaveZoomData *level : qAsConst(m_pyramid))
+		delete[] level;
+	m_pyramid.clear();
+	m_pyramidLength = 0;
+	m_pyramidChannels = 0;
+	m_pyramidSamples = 0;
 }
 
 void
 ZoomBuffer::stopAndClear()
 {
 	requestInterruption();
+	m_waveBuffer->wakeSampleWaiters();
 	wait();
 
 	if(m_waveformZoomed) {
@@ -55,6 +77,11 @@ ZoomBuffer::start()
 
 	Q_ASSERT(m_waveformZoomed == nullptr);
 
+	// coarsest pyramid level with entries not larger than a pixel
+	m_pyramidLevel = -1;
+	while(m_pyramidLevel + 1 < m_pyramid.size() && (1U << (PYRAMID_SHIFT + m_pyramidLevel + 1)) <= m_samplesPerPixel)
+		m_pyramidLevel++;
+
 	// alloc memory for zoomed pixel data
 	m_waveformZoomedSize = (m_waveBuffer->lengthSamples() + m_samplesPerPixel - 1) / m_samplesPerPixel;
 	m_waveformZoomed = new WaveZoomData *[m_waveBuffer->channels()];
@@ -81,16 +108,19 @@ ZoomBuffer::run()
 	for(;;) {
 		// wait for more samples if there aren't any
 		if(ranges.empty()) {
+			quint32 samplesAvailable = m_waveBuffer->samplesAvailable();
 			while(!isInterruptionRequested()) {
 				const bool decoding = m_waveBuffer->isDecoding();
-				const quint32 lastAvailable = m_waveBuffer->samplesAvailable() / m_samplesPerPixel;
+				updatePyramid(samplesAvailable);
+				const quint32 lastAvailable = m_pyramidSamples / m_samplesPerPixel;
 				if(lastProcessed != lastAvailable) {
 					ranges.push_back(DataRange{lastProcessed, lastAvailable});
 					break;
 				}
 				if(!decoding)
 					break;
-				msleep(100);
+				// decoder wakes us up as soon as there is more data
+				samplesAvailable = m_waveBuffer->waitForSamples(samplesAvailable, this);
 			}
 		}
 
@@ -122,7 +152,7 @@ ZoomBuffer::run()
 			}
 
 			if(reqRange == ranges.end()) {
-				const quint32 lastAvailable = m_waveBuffer->samplesAvailable() / m_samplesPerPixel;
+				const quint32 lastAvailable = m_pyramidSamples / m_samplesPerPixel;
 				if(lastAvailable < m_reqEnd) {
 					*m_reqLen = lastAvailable - qMin(m_reqStart, lastAvailable);
 				} else {
@@ -155,6 +185,58 @@ ZoomBuffer::run()
 	}
 }
 
+void
+ZoomBuffer::updatePyramid(quint32 samplesAvailable)
+{
+	samplesAvailable = qMin(samplesAvailable, m_pyramidLength);
+	if(samplesAvailable <= m_pyramidSamples)
+		return;
+
+	for(int l = 0; l < m_pyramid.size(); l++) {
+		const quint32 shift = PYRAMID_SHIFT + l;
+		const quint32 levelSize = m_pyramidLength >> shift;
+		const quint32 iStart = m_pyramidSamples >> shift;
+		const quint32 iEnd = samplesAvailable >> shift;
+
+		for(quint16 ch = 0; ch < m_pyramidChannels; ch++) {
+			WaveZoomData *level = m_pyramid.at(l) + ch * levelSize;
+			if(l == 0) {
+				for(quint32 i = iStart; i < iEnd; i++) {
+					quint64 sum = 0;
+					quint32 max = 0;
+					WaveKernels::amplitudeSumMax(m_waveform[ch] + (i << shift), 1U << shift, &sum, &max);
+					level[i].min = sum >> shift;
+					level[i].max = max;
+				}
+			} else {
+				const WaveZoomData *child = m_pyramid.at(l - 1) + ch * (m_pyramidLength >> (shift - 1));
+				for(quint32 i = iStart; i < iEnd; i++) {
+					const WaveZoomData &c0 = child[2 * i];
+					const WaveZoomData &c1 = child[2 * i + 1];
+					level[i].min = (c0.min + c1.min) / 2;
+					level[i].max = qMax(c0.max, c1.max);
+				}
+			}
+		}
+	}
+
+	m_pyramidSamples = samplesAvailable;
+}
+
+WaveZoomData
+ZoomBuffer::reducePyramid(quint16 channel, quint32 sampleStart, quint32 sampleEnd) const
+{
+	// zoomed in more than the first level - samples are read directly
+	if(m_pyramidLevel < 0)
+		return WaveKernels::reduceZoomLevel(m_waveform[channel], nullptr, 0, 0, sampleStart, sampleEnd);
+
+	// entries of chosen level are never larger than a pixel, those on pixel edges and past the
+	// processed samples are replaced by the samples they hold
+	const quint32 shift = PYRAMID_SHIFT + m_pyramidLevel;
+	const WaveZoomData *level = m_pyramid.at(m_pyramidLevel) + channel * (m_pyramidLength >> shift);
+	return WaveKernels::reduceZoomLevel(m_waveform[channel], level, shift, m_pyramidSamples >> shift, sampleStart, sampleEnd);
+}
+
 void
 ZoomBuffer::updateZoomRange(quint32 *start, quint32 end)
 {
@@ -163,27 +245,17 @@ ZoomBuffer::updateZoomRange(quint32 *start, quint32 end)
 	const quint16 channels = m_waveBuffer->channels();
 
 	while(*start < end) {
-		quint32 i = *start * m_samplesPerPixel;
-
-		for(quint16 ch = 0; ch < channels; ch++) {
-			const quint32 val = qAbs(qint32(m_waveform[ch][i]) - SAMPLE_MIN - (SAMPLE_MAX - SAMPLE_MIN) / 2);
-			m_waveformZoomed[ch][*start].min = val / m_samplesPerPixel;
-			m_waveformZoomed[ch][*start].max = val;
-		}
+		const quint32 sampleStart = *start * m_samplesPerPixel;
+		const quint32 sampleEnd = sampleStart + m_samplesPerPixel;
 
-		const quint32 iEnd = i + m_samplesPerPixel;
-		while(++i < iEnd) {
-			for(quint16 ch = 0; ch < channels; ch++) {
-				const quint32 val = qAbs(qint32(m_waveform[ch][i]) - SAMPLE_MIN - (SAMPLE_MAX - SAMPLE_MIN) / 2);
-				m_waveformZoomed[ch][*start].min += val / m_samplesPerPixel;
-				if(m_waveformZoomed[ch][*start].max < val)
-					m_waveformZoomed[ch][*start].max = val;
-			}
-		}
+		// WaveZoomData::min is holding the average value
+		for(quint16 ch = 0; ch < channels; ch++)
+			m_waveformZoomed[ch][*start] = reducePyramid(ch, sampleStart, sampleEnd);
 
 		(*start)++;
 
-		if(isInterruptionRequested() || m_restartProcessing)
+		// pixels are cheap, checking after each one would cost more than computing them
+		if((*start & 0x3f) == 0 && (isInterruptionRequested() || m_restartProcessing))
 			break;
 	}
 }
@@ -194,9 +266,17 @@ ZoomBuffer::setWaveform(const SAMPLE_TYPE * const *waveform)
 	QMutexLocker l(&m_publicMutex);
 
 	stopAndClear();
+	clearPyramid();
 
 	m_waveform = waveform;
 
+	if(m_waveform) {
+		m_pyramidLength = m_waveBuffer->lengthSamples();
+		m_pyramidChannels = m_waveBuffer->channels();
+		for(quint32 shift = PYRAMID_SHIFT; m_pyramidLength >> shift; shift++)
+			m_pyramid.append(new WaveZoomData[m_pyramidChannels * (m_pyramidLength >> shift)]);
+	}
+
 	start();
 }
 
@@ -215,9 +295,16 @@ ZoomBuffer::setZoomScale(quint32 samplesPerPixel)
 	start();
 }
 
+quint32
+ZoomBuffer::pixelIndex(quint32 msec) const
+{
+	return qMin(quint64(msec) * m_waveBuffer->sampleRate() / m_samplesPerPixel / 1000, quint64(m_waveformZoomedSize));
+}
+
 void
-ZoomBuffer::zoomedBuffer(quint32 timeStart, quint32 timeEnd, WaveZoomData **buffers, quint32 *bufLen)
+ZoomBuffer::zoomedBuffer(quint32 timeStart, quint32 timeEnd, quint32 align, WaveZoomData **buffers, quint32 *bufStart, quint32 *bufLen)
 {
+	*bufStart = 0;
 	*bufLen = 0;
 
 	if(!m_waveform || !m_waveformZoomed)
@@ -225,15 +312,16 @@ ZoomBuffer::zoomedBuffer(quint32 timeStart, quint32 timeEnd, WaveZoomData **buff
 
 	QMutexLocker l(&m_reqMutex);
 
-	m_reqStart = qMin(quint64(timeStart) * m_waveBuffer->sampleRate() / m_samplesPerPixel / 1000, quint64(m_waveformZoomedSize));
-	m_reqEnd = qMin(quint64(timeEnd) * m_waveBuffer->sampleRate() / m_samplesPerPixel / 1000, quint64(m_waveformZoomedSize));
+	m_reqStart = pixelIndex(timeStart) / align * align;
+	m_reqEnd = qMin(quint64(pixelIndex(timeEnd) + align - 1) / align * align, quint64(m_waveformZoomedSize));
 	m_reqLen = bufLen;
+	*bufStart = m_reqStart;
 
 	for(quint16 ch = 0; ch < m_waveBuffer->channels(); ch++)
 		buffers[ch] = &m_waveformZoomed[ch][m_reqStart];
 
 	if(isFinished()) {
-		const quint32 lastAvailable = m_waveBuffer->samplesAvailable() / m_samplesPerPixel;
+		const quint32 lastAvailable = m_pyramidSamples / m_samplesPerPixel;
 		*bufLen = qMin(m_reqEnd, lastAvailable) - qMin(m_reqStart, lastAvailable);
 	} else {
 		*bufLen = 0;
@@ -9,6 +9,7 @@
 
 #include <QMutex>
 #include <QThread>
+#include <QVector>
 #include <QWaitCondition>
 
 #include "gui/waveform/wavebuffer.h"
@@ -24,13 +25,25 @@ public:
 
 	void setWaveform(const SAMPLE_TYPE * const *waveform);
 	void setZoomScale(quint32 samplesPerPixel);
-	void zoomedBuffer(quint32 timeStart, quint32 timeEnd, WaveZoomData **buffers, quint32 *bufLen);
+	/**
+	 * @brief Request zoomed pixels of [@p timeStart, @p timeEnd) extended to multiples of @p align pixels
+	 *
+	 * Index of the first requested pixel is stored in @p bufStart, @p bufLen is updated as pixels are processed.
+	 */
+	void zoomedBuffer(quint32 timeStart, quint32 timeEnd, quint32 align, WaveZoomData **buffers, quint32 *bufStart, quint32 *bufLen);
 
 	inline quint32 samplesPerPixel() const { return m_samplesPerPixel; }
+	/**
+	 * @brief Index of zoomed pixel at @p msec
+	 */
+	quint32 pixelIndex(quint32 msec) const;
 
 private:
 	void run() override;
 	void updateZoomRange(quint32 *start, quint32 end);
+	void updatePyramid(quint32 samplesAvailable);
+	WaveZoomData reducePyramid(quint16 channel, quint32 sampleStart, quint32 sampleEnd) const;
+	void clearPyramid();
 	void stopAndClear();
 	void start();
 
@@ -45,6 +58,13 @@ private:
 	quint32 m_waveformZoomedSize;
 	const SAMPLE_TYPE * const *m_waveform;
 
+	// power-of-two levels of min/max data - survive zoom changes and are extended as samples arrive
+	QVector<WaveZoomData *> m_pyramid;
+	quint32 m_pyramidLength;
+	quint16 m_pyramidChannels;
+	quint32 m_pyramidSamples;
+	int m_pyramidLevel;
+
 	QMutex m_publicMutex;
 
 	bool m_restartProcessing;
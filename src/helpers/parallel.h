@@ -0,0 +1,84 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <QAtomicInt>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThreadPool>
+
+#include <functional>
+
+namespace SubtitleComposer {
+namespace Parallel {
+class Worker : public QRunnable
+{
+public:
+	Worker(const std::function<void()> &fn, QSemaphore *done) : m_fn(fn), m_done(done) {}
+
+	void run() override
+	{
+		m_fn();
+		m_done->release();
+	}
+
+private:
+	std::function<void()> m_fn;
+	QSemaphore *m_done;
+};
+
+/**
+ * @brief Call @p fn(index) for every index in [0, count) using the global thread pool
+ *
+ * Indexes are handed out to the workers in chunks of @p chunkSize, the calling thread
+ * is also processing chunks so there is progress even when the pool is busy.
+ * Returns after all indexes have been processed. @p fn must be safe to call concurrently
+ * for different indexes.
+ */
+template<class Fn>
+void
+forEach(const int count, Fn fn, const int chunkSize = 64)
+{
+	QThreadPool *pool = QThreadPool::globalInstance();
+	const int workerCount = qMin(pool->maxThreadCount(), count / chunkSize) - 1;
+	if(workerCount < 1) {
+		for(int i = 0; i < count; i++)
+			fn(i);
+		return;
+	}
+
+	QAtomicInt next(0);
+	const std::function<void()> work = [&]() {
+		for(;;) {
+			const int start = next.fetchAndAddRelaxed(chunkSize);
+			if(start >= count)
+				break;
+			const int end = qMin(start + chunkSize, count);
+			for(int i = start; i < end; i++)
+				fn(i);
+		}
+	};
+
+	QSemaphore done;
+	int started = 0;
+	for(int i = 0; i < workerCount; i++) {
+		Worker *worker = new Worker(work, &done);
+		if(!pool->tryStart(worker)) {
+			delete worker;
+			break;
+		}
+		started++;
+	}
+
+	work();
+	done.acquire(started);
+}
+}
+}
+
+#endif // PARALLEL_H
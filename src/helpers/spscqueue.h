@@ -0,0 +1,165 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <QAtomicInteger>
+#include <QMutex>
+#include <QWaitCondition>
+
+#include <utility>
+
+namespace SubtitleComposer {
+/**
+ * @brief Bounded lock-free queue with a single producer and a single consumer thread
+ *
+ * push()/pushWait() must only be called from the producer and pop()/popWait() only from the consumer thread.
+ * Blocking variants only take the lock when the other side is actually sleeping.
+ * @p Size must be a power of two.
+ */
+template<class T, int Size>
+class SPSCQueue
+{
+	static_assert(Size > 0 && (Size & (Size - 1)) == 0, "SPSCQueue size must be a power of two");
+
+public:
+	SPSCQueue() : m_head(0), m_tail(0), m_consumerWaiting(0), m_producerWaiting(0), m_closed(0), m_interrupted(0) {}
+
+	/**
+	 * @brief Append @p value to the queue
+	 * @return false if the queue is full, @p value is left untouched in that case
+	 */
+	bool push(T &&value)
+	{
+		const quint32 tail = m_tail.loadAcquire();
+		if(tail - m_head.loadAcquire() == quint32(Size))
+			return false;
+		m_data[tail & (Size - 1)] = std::move(value);
+		// full barrier - either we see the waiting consumer or it sees the new value
+		m_tail.fetchAndStoreOrdered(tail + 1);
+		if(m_consumerWaiting.loadAcquire())
+			wake(&m_notEmpty);
+		return true;
+	}
+
+	/**
+	 * @brief Take the oldest value from the queue into @p value
+	 * @return false if the queue is empty
+	 */
+	bool pop(T *value)
+	{
+		const quint32 head = m_head.loadAcquire();
+		if(m_tail.loadAcquire() == head)
+			return false;
+		*value = std::move(m_data[head & (Size - 1)]);
+		m_data[head & (Size - 1)] = T();
+		m_head.fetchAndStoreOrdered(head + 1);
+		if(m_producerWaiting.loadAcquire())
+			wake(&m_notFull);
+		return true;
+	}
+
+	/**
+	 * @brief Append @p value to the queue, sleeping while it is full
+	 * @return false if interrupt() was called
+	 */
+	bool pushWait(T &&value)
+	{
+		while(!push(std::move(value))) {
+			QMutexLocker l(&m_waitMutex);
+			m_producerWaiting.fetchAndStoreOrdered(1);
+			if(size() == Size && !m_interrupted.loadAcquire())
+				m_notFull.wait(&m_waitMutex);
+			m_producerWaiting.storeRelease(0);
+			if(m_interrupted.loadAcquire())
+				return false;
+		}
+		return true;
+	}
+
+	/**
+	 * @brief Take the oldest value from the queue into @p value, sleeping while it is empty
+	 * @return false if interrupt() was called or the queue was closed and there are no more values
+	 */
+	bool popWait(T *value)
+	{
+		while(!m_interrupted.loadAcquire() && !pop(value)) {
+			QMutexLocker l(&m_waitMutex);
+			m_consumerWaiting.fetchAndStoreOrdered(1);
+			const bool closed = m_closed.loadAcquire();
+			if(isEmpty() && !closed && !m_interrupted.loadAcquire())
+				m_notEmpty.wait(&m_waitMutex);
+			m_consumerWaiting.storeRelease(0);
+			// values pushed before close() are still delivered
+			if(closed && isEmpty())
+				return false;
+		}
+		return !m_interrupted.loadAcquire();
+	}
+
+	/**
+	 * @brief Mark end of data, popWait() returns false once the queue is drained
+	 */
+	void close()
+	{
+		QMutexLocker l(&m_waitMutex);
+		m_closed.storeRelease(1);
+		m_notEmpty.wakeAll();
+	}
+
+	/**
+	 * @brief Abort pushWait() and popWait() on both sides
+	 */
+	void interrupt()
+	{
+		QMutexLocker l(&m_waitMutex);
+		m_interrupted.storeRelease(1);
+		m_notEmpty.wakeAll();
+		m_notFull.wakeAll();
+	}
+
+	/**
+	 * @brief Drop all values and clear closed/interrupted state, neither side may be using the queue
+	 */
+	void reset()
+	{
+		T value;
+		while(pop(&value))
+			continue;
+		m_closed.storeRelease(0);
+		m_interrupted.storeRelease(0);
+	}
+
+	inline bool isEmpty() const { return m_tail.loadAcquire() == m_head.loadAcquire(); }
+	inline int size() const { return int(m_tail.loadAcquire() - m_head.loadAcquire()); }
+	inline bool isInterrupted() const { return m_interrupted.loadAcquire(); }
+	inline static int capacity() { return Size; }
+
+private:
+	inline void wake(QWaitCondition *cond)
+	{
+		QMutexLocker l(&m_waitMutex);
+		cond->wakeAll();
+	}
+
+private:
+	T m_data[Size];
+	// producer and consumer are writing to their own cache line
+	alignas(64) QAtomicInteger<quint32> m_head;
+	alignas(64) QAtomicInteger<quint32> m_tail;
+
+	alignas(64) QAtomicInt m_consumerWaiting;
+	QAtomicInt m_producerWaiting;
+	QAtomicInt m_closed;
+	QAtomicInt m_interrupted;
+	QMutex m_waitMutex;
+	QWaitCondition m_notEmpty;
+	QWaitCondition m_notFull;
+};
+}
+
+#endif // SPSCQUEUE_H
@@ -37,6 +37,13 @@ PocketSphinxPlugin::waveFormat() const
 	return wf;
 }
 
+/*virtual*/ SpeechPlugin *
+PocketSphinxPlugin::newInstance() const
+{
+	// every instance has its own decoder
+	return new PocketSphinxPlugin();
+}
+
 /*virtual*/ bool
 PocketSphinxPlugin::init()
 {
@@ -170,11 +177,14 @@ PocketSphinxPlugin::processSamples(const void *sampleData, qint32 sampleCount)
 /*virtual*/ void
 PocketSphinxPlugin::processComplete()
 {
-	if(m_psDecoder) {
-		if(m_utteranceStarted)
-			ps_end_utt(m_psDecoder);
+	// utterance that already ended was processed in processSamples()
+	if(m_psDecoder && m_utteranceStarted) {
+		ps_end_utt(m_psDecoder);
 		processUtterance();
 	}
+	// next samples start new utterance
+	m_utteranceStarted = false;
+	m_speechStarted = false;
 }
 
 QWidget *
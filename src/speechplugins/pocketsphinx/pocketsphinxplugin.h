@@ -31,6 +31,7 @@ private:
 	const QString & name() override;
 
 	const WaveFormat & waveFormat() const override;
+	SpeechPlugin * newInstance() const override;
 	bool init() override;
 	void cleanup() override;
 
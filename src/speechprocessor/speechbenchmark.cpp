@@ -0,0 +1,379 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "config.h"
+
+#include "core/subtitle.h"
+#include "core/subtitleline.h"
+#include "formats/formatmanager.h"
+#include "helpers/pluginhelper.h"
+#include "speechprocessor/speechpipeline.h"
+#include "speechprocessor/speechplugin.h"
+
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QExplicitlySharedDataPointer>
+#include <QMap>
+#include <QSet>
+#include <QTextCodec>
+#include <QTextStream>
+#include <QUrl>
+#include <QVector>
+
+#include <algorithm>
+
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#endif
+
+namespace SubtitleComposer {
+/**
+ * @brief Headless speech recognition run that reports throughput and timing accuracy of a plugin
+ */
+class SpeechBenchmark : public QObject
+{
+	Q_OBJECT
+
+	template <class C, class T> friend class PluginHelper;
+
+public:
+	explicit SpeechBenchmark(QObject *parent = nullptr);
+	virtual ~SpeechBenchmark();
+
+	void loadPlugins(const QStringList &files);
+	bool loadReference(const QString &file);
+	bool start(const QString &pluginName, const QString &mediaFile, int audioStream, int recognizers);
+	void report();
+
+	inline void setVerbose(bool verbose) { m_verbose = verbose; }
+
+private slots:
+	void onProgress(quint64 msecPos, quint64 msecLength);
+	void onSegmentRecognized(int index, double milliStart, double milliDuration, qint64 msecLatency, qint64 msecProcessing);
+	void onTextRecognized(const QString &text, double milliShow, double milliHide);
+	void onFinished();
+	void onError(int code, const QString &message, const QString &debug);
+
+private:
+	struct Segment {
+		double milliStart;
+		double milliDuration;
+		qint64 msecLatency;
+		qint64 msecProcessing;
+	};
+
+	struct Line {
+		QString text;
+		double milliShow;
+		double milliHide;
+	};
+
+	void reportDrift();
+
+private:
+	QMap<QString, SpeechPlugin *> m_plugins;
+	SpeechPlugin *m_plugin;
+	SpeechPipeline *m_pipeline;
+
+	QElapsedTimer m_timer;
+	qint64 m_msecElapsed;
+	quint64 m_msecAudio;
+
+	QVector<Segment> m_segments;
+	QVector<Line> m_lines;
+	QExplicitlySharedDataPointer<Subtitle> m_reference;
+
+	bool m_verbose;
+	QTextStream m_out;
+	QTextStream m_err;
+};
+}
+
+using namespace SubtitleComposer;
+
+/**
+ * @brief Peak resident memory of the process in KiB, -1 if unknown
+ */
+static qint64
+peakMemory()
+{
+#ifdef Q_OS_UNIX
+	struct rusage usage;
+	if(getrusage(RUSAGE_SELF, &usage) == 0)
+#ifdef Q_OS_MACOS
+		return usage.ru_maxrss / 1024;
+#else
+		return usage.ru_maxrss;
+#endif
+#endif
+	return -1;
+}
+
+template<class T>
+static T
+percentile(QVector<T> values, int percent)
+{
+	if(values.isEmpty())
+		return T();
+	std::sort(values.begin(), values.end());
+	return values.at((values.size() - 1) * percent / 100);
+}
+
+static QString
+formatDrift(const QVector<double> &drift)
+{
+	if(drift.isEmpty())
+		return QStringLiteral("-");
+	double sum = 0., sumAbs = 0., maxAbs = 0.;
+	for(const double d: drift) {
+		sum += d;
+		sumAbs += qAbs(d);
+		maxAbs = qMax(maxAbs, qAbs(d));
+	}
+	return QStringLiteral("mean %1 ms, mean abs %2 ms, max abs %3 ms")
+			.arg(sum / drift.size(), 0, 'f', 0)
+			.arg(sumAbs / drift.size(), 0, 'f', 0)
+			.arg(maxAbs, 0, 'f', 0);
+}
+
+SpeechBenchmark::SpeechBenchmark(QObject *parent)
+	: QObject(parent),
+	  m_plugin(nullptr),
+	  m_pipeline(new SpeechPipeline(this)),
+	  m_msecElapsed(0),
+	  m_msecAudio(0),
+	  m_verbose(false),
+	  m_out(stdout),
+	  m_err(stderr)
+{
+	connect(m_pipeline, &SpeechPipeline::progress, this, &SpeechBenchmark::onProgress);
+	connect(m_pipeline, &SpeechPipeline::segmentRecognized, this, &SpeechBenchmark::onSegmentRecognized);
+	connect(m_pipeline, &SpeechPipeline::textRecognized, this, &SpeechBenchmark::onTextRecognized);
+	connect(m_pipeline, &SpeechPipeline::finished, this, &SpeechBenchmark::onFinished);
+	connect(m_pipeline, &SpeechPipeline::error, this, &SpeechBenchmark::onError);
+}
+
+SpeechBenchmark::~SpeechBenchmark()
+{
+	m_pipeline->stop();
+	if(m_plugin)
+		m_plugin->cleanup();
+}
+
+void
+SpeechBenchmark::loadPlugins(const QStringList &files)
+{
+	PluginHelper<SpeechBenchmark, SpeechPlugin> helper(this);
+	if(files.isEmpty()) {
+		helper.loadAll(QStringLiteral("speechplugins"));
+		return;
+	}
+	for(const QString &file: files)
+		helper.pluginLoad(file);
+}
+
+bool
+SpeechBenchmark::loadReference(const QString &file)
+{
+	m_reference = new Subtitle();
+	// fixed encoding - detection could ask the user
+	QTextCodec *codec = QTextCodec::codecForName("UTF-8");
+	if(FormatManager::instance().readSubtitle(*m_reference, true, QUrl::fromLocalFile(file), &codec) != FormatManager::SUCCESS) {
+		m_err << "Failed reading reference subtitle " << file << '\n';
+		m_reference.reset();
+		return false;
+	}
+	return true;
+}
+
+bool
+SpeechBenchmark::start(const QString &pluginName, const QString &mediaFile, int audioStream, int recognizers)
+{
+	if(m_plugins.isEmpty()) {
+		m_err << "No speech recognition plugins available" << '\n';
+		return false;
+	}
+	m_plugin = pluginName.isEmpty() ? m_plugins.first() : m_plugins.value(pluginName);
+	if(!m_plugin) {
+		m_err << "Unknown plugin " << pluginName << ", available: " << QStringList(m_plugins.keys()).join(QStringLiteral(", ")) << '\n';
+		return false;
+	}
+	if(!m_plugin->init()) {
+		m_err << "Initialization of " << m_plugin->name() << " failed" << '\n';
+		m_plugin->cleanup();
+		m_plugin = nullptr;
+		return false;
+	}
+
+	m_pipeline->setMaxRecognizers(recognizers);
+	m_timer.start();
+	if(!m_pipeline->start(m_plugin, mediaFile, audioStream)) {
+		m_err << "Failed opening audio stream " << audioStream << " of " << mediaFile << '\n';
+		return false;
+	}
+	return true;
+}
+
+void
+SpeechBenchmark::onProgress(quint64 /*msecPos*/, quint64 msecLength)
+{
+	m_msecAudio = msecLength;
+}
+
+void
+SpeechBenchmark::onSegmentRecognized(int index, double milliStart, double milliDuration, qint64 msecLatency, qint64 msecProcessing)
+{
+	m_segments.push_back(Segment{milliStart, milliDuration, msecLatency, msecProcessing});
+	if(m_verbose) {
+		m_out << "segment " << index << " at " << QString::number(milliStart / 1000., 'f', 2)
+			  << "s, " << QString::number(milliDuration / 1000., 'f', 2) << "s long - latency "
+			  << msecLatency << "ms, processing " << msecProcessing << "ms" << '\n';
+		m_out.flush();
+	}
+}
+
+void
+SpeechBenchmark::onTextRecognized(const QString &text, double milliShow, double milliHide)
+{
+	m_lines.push_back(Line{text, milliShow, milliHide});
+	if(m_verbose) {
+		m_out << QString::number(milliShow / 1000., 'f', 2) << "s - " << QString::number(milliHide / 1000., 'f', 2)
+			  << "s: " << text << '\n';
+		m_out.flush();
+	}
+}
+
+void
+SpeechBenchmark::onFinished()
+{
+	m_msecElapsed = m_timer.elapsed();
+	QCoreApplication::exit(0);
+}
+
+void
+SpeechBenchmark::onError(int code, const QString &message, const QString &debug)
+{
+	m_err << "Speech recognition failed: " << message << "\nCode " << code << ": " << debug << '\n';
+	m_err.flush();
+	QCoreApplication::exit(1);
+}
+
+void
+SpeechBenchmark::report()
+{
+	const double audioSec = m_msecAudio / 1000.;
+	const double elapsedSec = m_msecElapsed / 1000.;
+
+	m_out << "Plugin:              " << m_plugin->name() << " x" << m_pipeline->recognizerCount() << '\n';
+	m_out << "Audio length:        " << QString::number(audioSec, 'f', 2) << "s" << '\n';
+	m_out << "Processing time:     " << QString::number(elapsedSec, 'f', 2) << "s" << '\n';
+	if(audioSec > 0.)
+		m_out << "Real-time factor:    " << QString::number(elapsedSec / audioSec, 'f', 3) << '\n';
+
+	double speechMsec = 0.;
+	qint64 processingMsec = 0;
+	QVector<qint64> latency;
+	for(const Segment &s: qAsConst(m_segments)) {
+		speechMsec += s.milliDuration;
+		processingMsec += s.msecProcessing;
+		latency.push_back(s.msecLatency);
+	}
+	m_out << "Segments:            " << m_segments.size() << ", " << QString::number(speechMsec / 1000., 'f', 2) << "s of audio" << '\n';
+	if(speechMsec > 0.)
+		m_out << "Recognizer RTF:      " << QString::number(processingMsec / speechMsec, 'f', 3) << " (single instance)" << '\n';
+	if(!latency.isEmpty()) {
+		m_out << "Segment latency:     p50 " << percentile(latency, 50) << "ms, p95 " << percentile(latency, 95)
+			  << "ms, max " << percentile(latency, 100) << "ms" << '\n';
+	}
+
+	const qint64 peak = peakMemory();
+	if(peak >= 0)
+		m_out << "Peak memory:         " << peak / 1024 << "MiB" << '\n';
+
+	m_out << "Recognized lines:    " << m_lines.size() << '\n';
+	if(m_reference)
+		reportDrift();
+	m_out.flush();
+}
+
+void
+SpeechBenchmark::reportDrift()
+{
+	QVector<double> showDrift, hideDrift;
+	QSet<int> matched;
+	for(const Line &line: qAsConst(m_lines)) {
+		// reference line that overlaps the most
+		int best = -1;
+		double bestOverlap = 0.;
+		for(int i = 0; i < m_reference->count(); i++) {
+			const SubtitleLine *ref = m_reference->at(i);
+			const double overlap = qMin(line.milliHide, ref->hideTime().toMillis()) - qMax(line.milliShow, ref->showTime().toMillis());
+			if(overlap > bestOverlap) {
+				bestOverlap = overlap;
+				best = i;
+			}
+		}
+		if(best < 0)
+			continue;
+		const SubtitleLine *ref = m_reference->at(best);
+		showDrift.push_back(line.milliShow - ref->showTime().toMillis());
+		hideDrift.push_back(line.milliHide - ref->hideTime().toMillis());
+		matched.insert(best);
+	}
+
+	m_out << "Reference lines:     " << m_reference->count() << ", " << matched.size() << " matched, "
+		  << m_lines.size() - showDrift.size() << " recognized lines unmatched" << '\n';
+	m_out << "Show time drift:     " << formatDrift(showDrift) << '\n';
+	m_out << "Hide time drift:     " << formatDrift(hideDrift) << '\n';
+}
+
+int
+main(int argc, char **argv)
+{
+	QCoreApplication app(argc, argv);
+	// plugins are reading their configuration of the main application
+	QCoreApplication::setApplicationName(QStringLiteral("subtitlecomposer"));
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription(QStringLiteral("Measures speech recognition plugin throughput and timing accuracy."));
+	parser.addHelpOption();
+	parser.addPositionalArgument(QStringLiteral("media"), QStringLiteral("Audio or video file (e.g. WAV fixture)."));
+	const QCommandLineOption streamOption({ QStringLiteral("s"), QStringLiteral("stream") },
+		QStringLiteral("Audio stream index."), QStringLiteral("index"), QStringLiteral("0"));
+	const QCommandLineOption pluginOption({ QStringLiteral("p"), QStringLiteral("plugin") },
+		QStringLiteral("Name of the speech plugin, first loaded one by default."), QStringLiteral("name"));
+	const QCommandLineOption pluginFileOption(QStringLiteral("plugin-file"),
+		QStringLiteral("Load plugin from file instead of the plugin directory, can be repeated."), QStringLiteral("file"));
+	const QCommandLineOption recognizersOption({ QStringLiteral("j"), QStringLiteral("recognizers") },
+		QStringLiteral("Number of parallel recognizers, 0 is one for every CPU core."), QStringLiteral("count"), QStringLiteral("0"));
+	const QCommandLineOption referenceOption({ QStringLiteral("r"), QStringLiteral("reference") },
+		QStringLiteral("Reference subtitle for timing drift (e.g. SRT)."), QStringLiteral("file"));
+	const QCommandLineOption verboseOption({ QStringLiteral("v"), QStringLiteral("verbose") },
+		QStringLiteral("Print every segment and recognized line."));
+	parser.addOptions({ streamOption, pluginOption, pluginFileOption, recognizersOption, referenceOption, verboseOption });
+	parser.process(app);
+
+	if(parser.positionalArguments().size() != 1)
+		parser.showHelp(1);
+
+	SpeechBenchmark benchmark;
+	benchmark.setVerbose(parser.isSet(verboseOption));
+	benchmark.loadPlugins(parser.values(pluginFileOption));
+	if(parser.isSet(referenceOption) && !benchmark.loadReference(parser.value(referenceOption)))
+		return 1;
+	if(!benchmark.start(parser.value(pluginOption), parser.positionalArguments().first(),
+				parser.value(streamOption).toInt(), parser.value(recognizersOption).toInt()))
+		return 1;
+
+	const int res = app.exec();
+	if(res == 0)
+		benchmark.report();
+	return res;
+}
+
+#include "speechbenchmark.moc"
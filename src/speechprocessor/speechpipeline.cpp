@@ -0,0 +1,317 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "speechpipeline.h"
+
+#include "speechprocessor/speechplugin.h"
+#include "streamprocessor/streamprocessor.h"
+
+#include <QMutexLocker>
+#include <QThread>
+
+// every recognizer has its own models loaded
+#define MAX_RECOGNIZERS 8
+
+namespace SubtitleComposer {
+class SpeechWorker : public QThread
+{
+public:
+	explicit SpeechWorker(SpeechPipeline *pipeline) : QThread(pipeline), m_pipeline(pipeline) {}
+
+protected:
+	void run() override { m_pipeline->processQueue(); }
+
+private:
+	SpeechPipeline *m_pipeline;
+};
+
+class SpeechRecognizer : public QThread
+{
+public:
+	SpeechRecognizer(SpeechPipeline *pipeline, SpeechPlugin *plugin, const WaveFormat &format)
+		: QThread(pipeline),
+		  m_pipeline(pipeline),
+		  m_plugin(plugin),
+		  m_format(format),
+		  m_processed(0),
+		  m_offset(0.)
+	{
+		// plugin is emitting from this thread while the segment is processed
+		connect(plugin, &SpeechPlugin::textRecognized, this, [this](const QString &text, const double milliShow, const double milliHide){
+			m_text.push_back(SpeechPipeline::RecognizedText{text, milliShow + m_offset, milliHide + m_offset});
+		}, Qt::DirectConnection);
+	}
+
+	inline SpeechPlugin * plugin() const { return m_plugin; }
+
+protected:
+	void run() override
+	{
+		SpeechPipeline::QueuedSegment queued;
+		while(m_pipeline->takeSegment(&queued)) {
+			const SpeechSegmenter::Segment &segment = queued.segment;
+			const qint64 startTime = m_pipeline->m_clock.elapsed();
+
+			// plugin times are relative to all samples it has processed
+			m_offset = double(segment.start - m_processed) * 1000. / m_format.sampleRate();
+			m_plugin->processSamples(segment.samples.constData(), segment.samples.size() / m_format.bytesPerSample());
+			m_plugin->processComplete();
+			m_processed += segment.samples.size() / m_format.bytesPerFrame();
+
+			m_pipeline->deliverSegment(queued, m_pipeline->m_clock.elapsed() - startTime, m_text);
+			m_text.clear();
+		}
+	}
+
+private:
+	SpeechPipeline *m_pipeline;
+	SpeechPlugin *m_plugin;
+	const WaveFormat m_format;
+	qint64 m_processed;
+	double m_offset;
+	QVector<SpeechPipeline::RecognizedText> m_text;
+};
+}
+
+using namespace SubtitleComposer;
+
+SpeechPipeline::SpeechPipeline(QObject *parent)
+	: QObject(parent),
+	  m_plugin(nullptr),
+	  m_maxRecognizers(0),
+	  m_stream(nullptr),
+	  m_streamFormat(nullptr),
+	  m_streamPaused(0),
+	  m_worker(new SpeechWorker(this)),
+	  m_segmenter(nullptr),
+	  m_segmentsClosed(false),
+	  m_segmentsAborted(false),
+	  m_nextRecognized(0)
+{
+}
+
+SpeechPipeline::~SpeechPipeline()
+{
+	stop();
+}
+
+bool
+SpeechPipeline::start(SpeechPlugin *plugin, const QString &mediaFile, int audioStream)
+{
+	stop();
+
+	// decoder is shared with other consumers of the same stream (e.g. waveform)
+	m_stream = StreamProcessor::attachAudio(mediaFile, audioStream, plugin->waveFormat(), &m_streamFormat);
+	if(!m_stream)
+		return false;
+
+	m_plugin = plugin;
+	m_format = *m_streamFormat;
+	m_segmenter = new SpeechSegmenter(m_format);
+
+	const int maxRecognizers = m_maxRecognizers > 0 ? m_maxRecognizers : qBound(1, QThread::idealThreadCount() - 1, MAX_RECOGNIZERS);
+	m_recognizers.push_back(new SpeechRecognizer(this, m_plugin, m_format));
+	while(m_recognizers.size() < maxRecognizers) {
+		SpeechPlugin *instance = m_plugin->newInstance();
+		if(!instance)
+			break;
+		if(!instance->init()) {
+			instance->cleanup();
+			delete instance;
+			break;
+		}
+		m_recognizers.push_back(new SpeechRecognizer(this, instance, m_format));
+	}
+
+	for(const SpeechRecognizer *recognizer: qAsConst(m_recognizers))
+		connect(recognizer->plugin(), &SpeechPlugin::error, this, [this](int code, const QString &message) { emit error(code, message, QString()); });
+
+	connect(m_stream, &StreamProcessor::streamProgress, this, &SpeechPipeline::progress);
+	connect(m_stream, &StreamProcessor::streamError, this, &SpeechPipeline::error);
+	connect(m_stream, &StreamProcessor::audioOutputFinished, this, &SpeechPipeline::onAudioFinished);
+	// Using Qt::DirectConnection here makes SpeechPipeline::onStreamData() to execute in StreamProcessor's thread
+	connect(m_stream, &StreamProcessor::audioDataAvailable, this, &SpeechPipeline::onStreamData, Qt::DirectConnection);
+
+	m_clock.start();
+	for(SpeechRecognizer *recognizer: qAsConst(m_recognizers))
+		recognizer->start();
+	m_worker->start();
+	m_stream->start();
+
+	return true;
+}
+
+void
+SpeechPipeline::stop()
+{
+	m_queue.interrupt();
+	{
+		QMutexLocker l(&m_segmentMutex);
+		m_segmentsAborted = true;
+		m_segmentQueued.wakeAll();
+		m_segmentTaken.wakeAll();
+	}
+	// worker is resuming the stream
+	m_worker->wait();
+	if(m_stream) {
+		disconnect(m_stream, nullptr, this, nullptr);
+		StreamProcessor::detachAudio(m_stream, m_streamFormat);
+		m_stream = nullptr;
+	}
+	for(SpeechRecognizer *recognizer: qAsConst(m_recognizers)) {
+		recognizer->wait();
+		SpeechPlugin *plugin = recognizer->plugin();
+		if(plugin == m_plugin) {
+			disconnect(plugin, nullptr, this, nullptr);
+		} else {
+			plugin->cleanup();
+			delete plugin;
+		}
+		delete recognizer;
+	}
+	m_recognizers.clear();
+	m_streamFormat = nullptr;
+	m_plugin = nullptr;
+
+	// drop the audio that wasn't recognized
+	m_queue.reset();
+	m_streamPaused.storeRelease(0);
+	delete m_segmenter;
+	m_segmenter = nullptr;
+	m_segments.clear();
+	m_segmentsClosed = false;
+	m_segmentsAborted = false;
+	m_recognized.clear();
+	m_nextRecognized = 0;
+}
+
+void
+SpeechPipeline::onStreamData(const void *buffer, const qint32 size, const WaveFormat *waveFormat, const qint64 /*msecStart*/, const qint64 /*msecDuration*/)
+{
+	// shared decoder is emitting data of other consumers too
+	if(waveFormat != m_streamFormat)
+		return;
+
+	Q_ASSERT(size % waveFormat->bytesPerSample() == 0);
+
+	if(m_queue.push(QByteArray(reinterpret_cast<const char *>(buffer), size)))
+		return;
+
+	// other consumers of the decoder are not waiting for recognition to catch up,
+	// only our output is paused and this data is emitted again once the queue drains
+	m_stream->pauseAudioOutput(m_streamFormat);
+	m_streamPaused.storeRelease(1);
+	// worker could have drained the queue before it saw the pause
+	resumeStream();
+}
+
+void
+SpeechPipeline::resumeStream()
+{
+	if(m_queue.size() <= m_queue.capacity() / 2 && m_streamPaused.testAndSetOrdered(1, 0))
+		m_stream->resumeAudioOutput(m_streamFormat);
+}
+
+void
+SpeechPipeline::onAudioFinished(const WaveFormat *waveFormat)
+{
+	if(waveFormat == m_streamFormat)
+		m_queue.close();
+}
+
+void
+SpeechPipeline::processQueue()
+{
+	QByteArray chunk;
+	while(m_queue.popWait(&chunk)) {
+		resumeStream();
+		m_segmenter->process(chunk.constData(), chunk.size());
+		if(!queueSegments())
+			return;
+	}
+
+	// queue is closed after all the audio was queued
+	if(m_queue.isInterrupted())
+		return;
+
+	m_segmenter->flush();
+	if(!queueSegments())
+		return;
+	closeSegments();
+
+	for(SpeechRecognizer *recognizer: qAsConst(m_recognizers))
+		recognizer->wait();
+
+	QMutexLocker l(&m_segmentMutex);
+	if(!m_segmentsAborted)
+		emit finished();
+}
+
+bool
+SpeechPipeline::queueSegments()
+{
+	QueuedSegment queued;
+	while(m_segmenter->takeSegment(&queued.segment)) {
+		QMutexLocker l(&m_segmentMutex);
+		// recognition is slower than decoding - don't hold the whole stream in memory
+		while(m_segments.size() >= 2 * m_recognizers.size() && !m_segmentsAborted)
+			m_segmentTaken.wait(&m_segmentMutex);
+		if(m_segmentsAborted)
+			return false;
+		queued.queued = m_clock.elapsed();
+		m_segments.push_back(queued);
+		m_segmentQueued.wakeOne();
+	}
+	return true;
+}
+
+void
+SpeechPipeline::closeSegments()
+{
+	QMutexLocker l(&m_segmentMutex);
+	m_segmentsClosed = true;
+	m_segmentQueued.wakeAll();
+}
+
+bool
+SpeechPipeline::takeSegment(QueuedSegment *segment)
+{
+	QMutexLocker l(&m_segmentMutex);
+	while(m_segments.isEmpty() && !m_segmentsClosed && !m_segmentsAborted)
+		m_segmentQueued.wait(&m_segmentMutex);
+	if(m_segmentsAborted || m_segments.isEmpty())
+		return false;
+	*segment = m_segments.takeFirst();
+	m_segmentTaken.wakeOne();
+	return true;
+}
+
+void
+SpeechPipeline::deliverSegment(const QueuedSegment &segment, qint64 msecProcessing, const QVector<RecognizedText> &text)
+{
+	QMutexLocker l(&m_segmentMutex);
+	if(m_segmentsAborted)
+		return;
+
+	const double sampleRate = m_format.sampleRate();
+	emit segmentRecognized(segment.segment.index,
+		double(segment.segment.start) * 1000. / sampleRate,
+		double(segment.segment.samples.size() / m_format.bytesPerFrame()) * 1000. / sampleRate,
+		m_clock.elapsed() - segment.queued, msecProcessing);
+
+	m_recognized.insert(segment.segment.index, text);
+
+	// segments finish out of order, text is emitted in time order
+	for(;;) {
+		auto it = m_recognized.find(m_nextRecognized);
+		if(it == m_recognized.end())
+			break;
+		for(const RecognizedText &t: qAsConst(it.value()))
+			emit textRecognized(t.text, t.milliShow, t.milliHide);
+		m_recognized.erase(it);
+		m_nextRecognized++;
+	}
+}
@@ -0,0 +1,129 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef SPEECHPIPELINE_H
+#define SPEECHPIPELINE_H
+
+#include "videoplayer/waveformat.h"
+#include "speechprocessor/speechsegmenter.h"
+#include "helpers/spscqueue.h"
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QObject>
+#include <QVector>
+#include <QWaitCondition>
+
+namespace SubtitleComposer {
+class SpeechPlugin;
+class SpeechRecognizer;
+class SpeechWorker;
+class StreamProcessor;
+
+/**
+ * @brief Decodes audio stream and recognizes speech in it without any UI
+ *
+ * Decoded audio is split into utterance segments that are recognized by several plugin
+ * instances in parallel, recognized text is emitted in time order.
+ */
+class SpeechPipeline : public QObject
+{
+	Q_OBJECT
+
+	friend class SpeechRecognizer;
+	friend class SpeechWorker;
+
+public:
+	explicit SpeechPipeline(QObject *parent = nullptr);
+	virtual ~SpeechPipeline();
+
+	/**
+	 * @brief Limit number of parallel recognizers, 0 is one for every CPU core
+	 */
+	inline void setMaxRecognizers(int count) { m_maxRecognizers = count; }
+	inline int recognizerCount() const { return m_recognizers.size(); }
+
+	/**
+	 * @brief Start recognizing @p audioStream of @p mediaFile
+	 *
+	 * @p plugin must be initialized, more instances of it are created when it supports that.
+	 * @return false if the stream couldn't be opened
+	 */
+	bool start(SpeechPlugin *plugin, const QString &mediaFile, int audioStream);
+	void stop();
+
+signals:
+	void progress(quint64 msecPos, quint64 msecLength);
+	void textRecognized(const QString &text, double milliShow, double milliHide);
+	/**
+	 * @brief Segment @p index was recognized
+	 *
+	 * @p msecLatency is the time since the segment was queued and @p msecProcessing
+	 * the time recognizer spent on it.
+	 */
+	void segmentRecognized(int index, double milliStart, double milliDuration, qint64 msecLatency, qint64 msecProcessing);
+	void finished();
+	void error(int code, const QString &message, const QString &debug);
+
+private slots:
+	void onStreamData(const void *buffer, const qint32 size, const WaveFormat *waveFormat, const qint64 msecStart, const qint64 msecDuration);
+	void onAudioFinished(const WaveFormat *waveFormat);
+
+private:
+	struct RecognizedText {
+		QString text;
+		double milliShow;
+		double milliHide;
+	};
+
+	struct QueuedSegment {
+		SpeechSegmenter::Segment segment;
+		qint64 queued;
+	};
+
+	void processQueue();
+	void resumeStream();
+
+	bool queueSegments();
+	void closeSegments();
+	bool takeSegment(QueuedSegment *segment);
+	void deliverSegment(const QueuedSegment &segment, qint64 msecProcessing, const QVector<RecognizedText> &text);
+
+private:
+	SpeechPlugin *m_plugin;
+	int m_maxRecognizers;
+
+	StreamProcessor *m_stream;
+	// only compared to identify our data, decoder deletes it when it's done
+	const WaveFormat *m_streamFormat;
+	WaveFormat m_format;
+
+	// decoded audio is queued so the slow recognition isn't holding up the shared decoder,
+	// our output is paused while the queue is full
+	SPSCQueue<QByteArray, 256> m_queue;
+	QAtomicInt m_streamPaused;
+	SpeechWorker *m_worker;
+	QElapsedTimer m_clock;
+
+	// worker splits the audio into utterances that are recognized in parallel
+	SpeechSegmenter *m_segmenter;
+	QVector<SpeechRecognizer *> m_recognizers;
+	QMutex m_segmentMutex;
+	QWaitCondition m_segmentQueued;
+	QWaitCondition m_segmentTaken;
+	QList<QueuedSegment> m_segments;
+	bool m_segmentsClosed;
+	bool m_segmentsAborted;
+	QMap<int, QVector<RecognizedText>> m_recognized;
+	int m_nextRecognized;
+};
+}
+
+#endif // SPEECHPIPELINE_H
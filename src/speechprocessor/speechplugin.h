@@ -20,6 +20,9 @@ class SpeechPlugin : public QObject
 	Q_OBJECT
 
 	friend class SpeechProcessor;
+	friend class SpeechPipeline;
+	friend class SpeechRecognizer;
+	friend class SpeechBenchmark;
 	friend class ConfigDialog;
 	template <class C, class T> friend class PluginHelper;
 
@@ -34,10 +37,24 @@ private:
 
 	virtual const WaveFormat & waveFormat() const = 0;
 
+	/**
+	 * @brief Create another recognizer that can run in parallel with this one
+	 *
+	 * Returned instance is initialized and cleaned up separately. Plugins that can't
+	 * run several recognizers return nullptr and all audio is processed by one.
+	 */
+	virtual SpeechPlugin * newInstance() const { return nullptr; }
+
 	virtual bool init() = 0;
 	virtual void cleanup() = 0;
 
+	/**
+	 * @brief Recognize samples, textRecognized() times are relative to all samples processed since init()
+	 */
 	virtual void processSamples(const void *sampleData, qint32 sampleCount) = 0;
+	/**
+	 * @brief End of utterance segment - emit what was recognized, more samples may follow
+	 */
 	virtual void processComplete() = 0;
 
 signals:
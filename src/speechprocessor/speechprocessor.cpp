@@ -11,6 +11,7 @@
 #include "core/richtext/richdocument.h"
 #include "helpers/pluginhelper.h"
 #include "speechprocessor.h"
+#include "speechpipeline.h"
 #include "speechplugin.h"
 #include "gui/treeview/lineswidget.h"
 
@@ -29,7 +30,7 @@ SpeechProcessor::SpeechProcessor(QWidget *parent)
 	: QObject(parent),
 	  m_mediaFile(QString()),
 	  m_streamIndex(-1),
-	  m_stream(new StreamProcessor(this)),
+	  m_pipeline(new SpeechPipeline(this)),
 	  m_subtitle(nullptr),
 	  m_progressWidget(new QWidget(parent)),
 	  m_plugin(nullptr)
@@ -56,12 +57,12 @@ SpeechProcessor::SpeechProcessor(QWidget *parent)
 	layout->addWidget(m_progressBar);
 	layout->addWidget(btnAbort);
 
-	connect(btnAbort, &QToolButton::clicked, m_stream, &StreamProcessor::close);
-	connect(m_stream, &StreamProcessor::streamProgress, this, &SpeechProcessor::onStreamProgress);
-	connect(m_stream, &StreamProcessor::streamError, this, &SpeechProcessor::onStreamError);
-	connect(m_stream, &StreamProcessor::streamFinished, this, &SpeechProcessor::onStreamFinished);
-	// Using Qt::DirectConnection here makes SpeechProcessor::onStreamData() to execute in SpeechProcessor's thread
-	connect(m_stream, &StreamProcessor::audioDataAvailable, this, &SpeechProcessor::onStreamData, Qt::DirectConnection);
+	connect(btnAbort, &QToolButton::clicked, this, &SpeechProcessor::clearAudioStream);
+
+	connect(m_pipeline, &SpeechPipeline::progress, this, &SpeechProcessor::onStreamProgress);
+	connect(m_pipeline, &SpeechPipeline::error, this, &SpeechProcessor::onStreamError);
+	connect(m_pipeline, &SpeechPipeline::textRecognized, this, &SpeechProcessor::onTextRecognized);
+	connect(m_pipeline, &SpeechPipeline::finished, this, &SpeechProcessor::onStreamFinished);
 
 	PluginHelper<SpeechProcessor, SpeechPlugin>(this).loadAll(QStringLiteral("speechplugins"));
 }
@@ -105,16 +106,12 @@ SpeechProcessor::setAudioStream(const QString &mediaFile, int audioStream)
 		return;
 	}
 
-	connect(m_plugin, &SpeechPlugin::textRecognized, this, &SpeechProcessor::onTextRecognized);
-	connect(m_plugin, &SpeechPlugin::error, this, [this](int code, const QString &message) { onStreamError(code, message, QString()); });
-
 	m_mediaFile = mediaFile;
 	m_streamIndex = audioStream;
 
 	m_audioDuration = 0;
 
-	if(m_stream->open(mediaFile) && m_stream->initAudio(audioStream, m_plugin->waveFormat()))
-		m_stream->start();
+	m_pipeline->start(m_plugin, mediaFile, audioStream);
 }
 
 void
@@ -123,7 +120,7 @@ SpeechProcessor::clearAudioStream()
 	if(m_progressWidget)
 		m_progressWidget->hide();
 
-	m_stream->close();
+	m_pipeline->stop();
 
 	m_mediaFile.clear();
 	m_streamIndex = -1;
@@ -149,24 +146,9 @@ SpeechProcessor::onStreamProgress(quint64 msecPos, quint64 msecLength)
 void
 SpeechProcessor::onStreamFinished()
 {
-	if(m_plugin)
-		m_plugin->processComplete();
 	clearAudioStream();
 }
 
-void
-SpeechProcessor::onStreamData(const void *buffer, const qint32 size, const WaveFormat *waveFormat, const qint64 /*msecStart*/, const qint64 /*msecDuration*/)
-{
-	// make sure SpeechProcessor::onStreamProgress() signal was processed since we're in different thread
-	while(!m_audioDuration)
-		QThread::yieldCurrentThread();
-
-	Q_ASSERT(size % waveFormat->bytesPerSample() == 0);
-
-	if(m_plugin)
-		m_plugin->processSamples(buffer, size / waveFormat->bytesPerSample());
-}
-
 void
 SpeechProcessor::onStreamError(int code, const QString &message, const QString &debug)
 {
@@ -9,16 +9,16 @@
 
 #include "core/time.h"
 #include "core/subtitle.h"
-#include "videoplayer/waveformat.h"
-#include "streamprocessor/streamprocessor.h"
 
 #include <QExplicitlySharedDataPointer>
 #include <QList>
+#include <QMap>
 
 QT_FORWARD_DECLARE_CLASS(QWidget)
 QT_FORWARD_DECLARE_CLASS(QProgressBar)
 
 namespace SubtitleComposer {
+class SpeechPipeline;
 class SpeechPlugin;
 class SpeechProcessor : public QObject
 {
@@ -46,14 +46,13 @@ private slots:
 	void onStreamProgress(quint64 msecPos, quint64 msecLength);
 	void onStreamError(int code, const QString &message, const QString &debug);
 	void onStreamFinished();
-	void onStreamData(const void *buffer, const qint32 size, const WaveFormat *waveFormat, const qint64 msecStart, const qint64 msecDuration);
 	void onTextRecognized(const QString &text, const double milliShow, const double milliHide);
 
 private:
 	QString m_mediaFile;
 	int m_streamIndex;
 
-	StreamProcessor *m_stream;
+	SpeechPipeline *m_pipeline;
 	QExplicitlySharedDataPointer<Subtitle> m_subtitle;
 
 	quint32 m_audioDuration;
@@ -0,0 +1,141 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "speechsegmenter.h"
+
+// analyzed frames per second
+#define FRAME_RATE 100
+// silence kept before the speech
+#define PAD_FRAMES 30
+// silence that ends the segment
+#define PAUSE_FRAMES 50
+// segments shorter than this are noise
+#define MIN_SPEECH_FRAMES 10
+// segments are split when longer than this
+#define MAX_SEGMENT_FRAMES 3000
+// mean square of quietest speech (-40dBFS)
+#define MIN_SPEECH_ENERGY (328 * 328)
+// speech is 9dB above the noise floor
+#define SPEECH_NOISE_RATIO 8
+// noise floor is falling immediately and rising with ~10s time constant,
+// much slower during speech so long dialogs aren't taken for noise
+#define NOISE_RISE_FRAMES 1024
+#define SPEECH_NOISE_RISE_FRAMES 65536
+
+using namespace SubtitleComposer;
+
+SpeechSegmenter::SpeechSegmenter(const WaveFormat &format)
+	: m_format(format),
+	  m_analyze(format.bitsPerSample() == 16 && format.isInteger()),
+	  m_frameBytes(qMax(1, format.sampleRate() / FRAME_RATE) * format.bytesPerFrame())
+{
+	reset();
+}
+
+void
+SpeechSegmenter::reset()
+{
+	m_frame.clear();
+	m_segment.clear();
+	m_segmentStart = 0;
+	m_speechFrames = 0;
+	m_silenceFrames = 0;
+	m_noiseLevel = MIN_SPEECH_ENERGY;
+	m_nextIndex = 0;
+	m_segments.clear();
+}
+
+void
+SpeechSegmenter::process(const char *data, int size)
+{
+	while(size > 0) {
+		if(m_frame.isEmpty() && size >= m_frameBytes) {
+			processFrame(data);
+			data += m_frameBytes;
+			size -= m_frameBytes;
+			continue;
+		}
+
+		// buffer partial frame until the rest arrives
+		const int len = qMin(size, m_frameBytes - int(m_frame.size()));
+		m_frame.append(data, len);
+		data += len;
+		size -= len;
+		if(m_frame.size() == m_frameBytes) {
+			processFrame(m_frame.constData());
+			m_frame.clear();
+		}
+	}
+}
+
+void
+SpeechSegmenter::processFrame(const char *frame)
+{
+	bool speech = true;
+	if(m_analyze) {
+		const qint16 *sample = reinterpret_cast<const qint16 *>(frame);
+		const int len = m_frameBytes / int(sizeof(qint16));
+		qint64 sum = 0;
+		for(int i = 0; i < len; i++)
+			sum += qint32(sample[i]) * sample[i];
+		const qint64 energy = sum / len;
+
+		speech = energy > MIN_SPEECH_ENERGY && energy > m_noiseLevel * SPEECH_NOISE_RATIO;
+
+		if(energy < m_noiseLevel)
+			m_noiseLevel = energy;
+		else
+			m_noiseLevel += (energy - m_noiseLevel) / (speech ? SPEECH_NOISE_RISE_FRAMES : NOISE_RISE_FRAMES);
+	}
+
+	m_segment.append(frame, m_frameBytes);
+
+	if(speech) {
+		m_speechFrames++;
+		m_silenceFrames = 0;
+	} else {
+		m_silenceFrames++;
+	}
+
+	if(!m_speechFrames) {
+		// only silence so far - keep just the padding before speech
+		if(m_segment.size() > PAD_FRAMES * m_frameBytes) {
+			m_segment.remove(0, m_frameBytes);
+			m_segmentStart += m_frameBytes / m_format.bytesPerFrame();
+		}
+	} else if(m_silenceFrames >= PAUSE_FRAMES || m_segment.size() >= MAX_SEGMENT_FRAMES * m_frameBytes) {
+		closeSegment();
+	}
+}
+
+void
+SpeechSegmenter::closeSegment()
+{
+	if(m_speechFrames >= MIN_SPEECH_FRAMES)
+		m_segments.push_back(Segment{m_nextIndex++, m_segmentStart, m_segment});
+
+	m_segmentStart += m_segment.size() / m_format.bytesPerFrame();
+	m_segment.clear();
+	m_speechFrames = 0;
+	m_silenceFrames = 0;
+}
+
+void
+SpeechSegmenter::flush()
+{
+	m_segment.append(m_frame);
+	m_frame.clear();
+	closeSegment();
+}
+
+bool
+SpeechSegmenter::takeSegment(Segment *segment)
+{
+	if(m_segments.isEmpty())
+		return false;
+	*segment = m_segments.takeFirst();
+	return true;
+}
@@ -0,0 +1,74 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef SPEECHSEGMENTER_H
+#define SPEECHSEGMENTER_H
+
+#include "videoplayer/waveformat.h"
+
+#include <QByteArray>
+#include <QList>
+
+namespace SubtitleComposer {
+/**
+ * @brief Energy based voice activity detection that splits audio into utterance segments
+ *
+ * Audio is analyzed in 10ms frames against an adaptive noise floor. Segment is closed after
+ * a pause in speech or when it gets too long, stretches of silence between segments are dropped.
+ * Segments are independent and can be recognized in parallel.
+ */
+class SpeechSegmenter
+{
+public:
+	struct Segment {
+		int index;
+		// position of first sample frame in the stream
+		qint64 start;
+		QByteArray samples;
+	};
+
+	explicit SpeechSegmenter(const WaveFormat &format);
+
+	/**
+	 * @brief Analyze @p size bytes of @p data, completed segments can be retrieved with takeSegment()
+	 */
+	void process(const char *data, int size);
+
+	/**
+	 * @brief Close the segment in progress at the end of stream
+	 */
+	void flush();
+
+	void reset();
+
+	/**
+	 * @brief Take oldest completed segment
+	 * @return false if there are none
+	 */
+	bool takeSegment(Segment *segment);
+
+private:
+	void processFrame(const char *frame);
+	void closeSegment();
+
+private:
+	WaveFormat m_format;
+	bool m_analyze;
+	int m_frameBytes;
+
+	QByteArray m_frame;
+	QByteArray m_segment;
+	qint64 m_segmentStart;
+	int m_speechFrames;
+	int m_silenceFrames;
+	qint64 m_noiseLevel;
+
+	int m_nextIndex;
+	QList<Segment> m_segments;
+};
+}
+
+#endif // SPEECHSEGMENTER_H
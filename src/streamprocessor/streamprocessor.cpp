@@ -8,12 +8,16 @@
 #include "helpers/languagecode.h"
 
 #include <QApplication>
+#include <QAtomicInt>
 #include <QDebug>
 #include <QThread>
 #include <QPixmap>
 #include <QImage>
+#include <QMap>
+#include <QPair>
 #include <QRegularExpression>
 
+#include <algorithm>
 #include <cinttypes>
 
 extern "C" {
@@ -24,26 +28,74 @@ extern "C" {
 #include <libswresample/swresample.h>
 }
 
+// decoding of audio range starts this much earlier so decoder output is settled when the range starts
+#define AUDIO_RANGE_PREROLL 500
+
 using namespace SubtitleComposer;
 
+struct StreamProcessor::AudioOutput {
+	AudioOutput()
+		: sampleFormat(AV_SAMPLE_FMT_NONE),
+		  chLayout{},
+		  swr(nullptr),
+		  frame(nullptr),
+		  rangeStart(0),
+		  rangeEnd(-1),
+		  delivered(0),
+		  skipUntil(0),
+		  paused(0),
+		  resuming(false),
+		  active(false),
+		  finished(false)
+	{
+	}
+
+	~AudioOutput() {
+		av_channel_layout_uninit(&chLayout);
+		if(swr)
+			swr_free(&swr);
+		if(frame)
+			av_frame_free(&frame);
+	}
+
+	WaveFormat format;
+	int sampleFormat;
+	AVChannelLayout chLayout;
+	SwrContext *swr;
+	AVFrame *frame;
+	qint64 rangeStart;
+	qint64 rangeEnd;
+	qint64 delivered; // end of data emitted so far
+	qint64 skipUntil; // data before this was emitted before the decoder got rewound
+	QAtomicInt paused; // read without the lock while the data is emitted
+	bool resuming; // paused until the decoder is rewound to the data it missed
+	bool active;
+	bool finished;
+};
+
+typedef QMap<QPair<QString, int>, StreamProcessor *> SharedAudioMap;
+Q_GLOBAL_STATIC(SharedAudioMap, sharedAudio)
+
 StreamProcessor::StreamProcessor(QObject *parent)
 	: QThread(parent),
 	  m_opened(false),
 	  m_audioReady(false),
+	  m_audioSeek(-1),
+	  m_audioEmitting(nullptr),
+	  m_audioClosing(false),
+	  m_sharedUsers(0),
 	  m_imageReady(false),
 	  m_textReady(false),
 	  m_avFormat(nullptr),
 	  m_avStream(nullptr),
-	  m_codecCtx(nullptr),
-	  m_swResample(nullptr),
-	  m_audioChLayout(new AVChannelLayout{})
+	  m_codecCtx(nullptr)
 {
+	qRegisterMetaType<const WaveFormat *>("const WaveFormat*");
 }
 
 StreamProcessor::~StreamProcessor()
 {
 	close();
-	delete m_audioChLayout;
 }
 
 bool
@@ -91,12 +143,14 @@ StreamProcessor::close()
 {
 	if(isRunning()) {
 		requestInterruption();
+		{
+			QMutexLocker l(&m_audioMutex);
+			m_audioOutputsChanged.wakeAll();
+		}
 		wait();
 	}
 
-	av_channel_layout_uninit(m_audioChLayout);
-	if(m_swResample)
-		swr_free(&m_swResample);
+	clearAudioOutputs();
 	if(m_codecCtx)
 		avcodec_free_context(&m_codecCtx);
 	if(m_avFormat)
@@ -241,7 +295,6 @@ StreamProcessor::initAudio(int streamIndex, const WaveFormat &waveFormat)
 		return false;
 
 	m_audioStreamIndex = streamIndex;
-	m_audioStreamFormat = waveFormat;
 	m_imageReady = false;
 	m_textReady = false;
 
@@ -251,68 +304,248 @@ StreamProcessor::initAudio(int streamIndex, const WaveFormat &waveFormat)
 	if(!m_audioReady)
 		return false;
 
+	const int64_t streamDuration = m_avStream->duration * 1000 * m_avStream->time_base.num / m_avStream->time_base.den;
+	const int64_t containerDuration = m_avFormat->duration * 1000 / AV_TIME_BASE;
+	m_streamLen = streamDuration > containerDuration ? streamDuration : containerDuration;
+
+	// figure channel layout
+	if(m_codecCtx->ch_layout.order != AV_CHANNEL_ORDER_NATIVE) {
+		const int cc = m_codecCtx->ch_layout.nb_channels;
+		av_channel_layout_uninit(&m_codecCtx->ch_layout);
+		av_channel_layout_default(&m_codecCtx->ch_layout, cc);
+	}
+
+	clearAudioOutputs();
+	m_audioSeek = -1;
+	m_audioClosing = false;
+
+	AudioOutput *out = createAudioOutput(waveFormat);
+	if(!out)
+		return false;
+
+	QMutexLocker l(&m_audioMutex);
+	m_audioOutputs.append(out);
+
+	return true;
+}
+
+StreamProcessor::AudioOutput *
+StreamProcessor::createAudioOutput(const WaveFormat &waveFormat)
+{
+	AudioOutput *out = new AudioOutput();
+	out->format = waveFormat;
+
 	// update stream format so zero values are set to input stream format values
-	if(m_audioStreamFormat.sampleRate() == 0)
-		m_audioStreamFormat.setSampleRate(m_codecCtx->sample_rate);
-	if(m_audioStreamFormat.bitsPerSample() == 0)
-		m_audioStreamFormat.setBitsPerSample(m_codecCtx->bits_per_raw_sample);
+	if(out->format.sampleRate() == 0)
+		out->format.setSampleRate(m_codecCtx->sample_rate);
+	if(out->format.bitsPerSample() == 0)
+		out->format.setBitsPerSample(m_codecCtx->bits_per_raw_sample);
 
 	// figure sample format and update stream format
-	const int bps = m_audioStreamFormat.bitsPerSample();
+	const int bps = out->format.bitsPerSample();
 	if(bps == 8) {
-		m_audioSampleFormat = AV_SAMPLE_FMT_U8;
-		m_audioStreamFormat.setInteger(true);
+		out->sampleFormat = AV_SAMPLE_FMT_U8;
+		out->format.setInteger(true);
 	} else if(bps == 16) {
-		m_audioSampleFormat = AV_SAMPLE_FMT_S16;
-		m_audioStreamFormat.setInteger(true);
+		out->sampleFormat = AV_SAMPLE_FMT_S16;
+		out->format.setInteger(true);
 	} else if(bps == 32) {
-		m_audioSampleFormat = m_audioStreamFormat.isInteger() ? AV_SAMPLE_FMT_S32 : AV_SAMPLE_FMT_FLT;
+		out->sampleFormat = out->format.isInteger() ? AV_SAMPLE_FMT_S32 : AV_SAMPLE_FMT_FLT;
 	} else if(bps == 64) {
-		m_audioSampleFormat = AV_SAMPLE_FMT_DBL;
-		m_audioStreamFormat.setInteger(false);
+		out->sampleFormat = AV_SAMPLE_FMT_DBL;
+		out->format.setInteger(false);
 	} else {
 		qWarning() << "Invalid wave format requested:" << bps << "bits per sample";
 		emit streamError(AVERROR_BUG, QStringLiteral("Invalid wave format requested"), QString::number(bps) + QStringLiteral(" bits per sample"));
-		return false;
+		delete out;
+		return nullptr;
 	}
 
-	av_channel_layout_uninit(m_audioChLayout);
-
 	// figure channel layout or update stream format
-	if(m_codecCtx->ch_layout.order != AV_CHANNEL_ORDER_NATIVE) {
-		const int cc = m_codecCtx->ch_layout.nb_channels;
-		av_channel_layout_uninit(&m_codecCtx->ch_layout);
-		av_channel_layout_default(&m_codecCtx->ch_layout, cc);
-	}
-
-	if(m_audioStreamFormat.channels() == 0) {
-		m_audioStreamFormat.setChannels(m_codecCtx->ch_layout.nb_channels);
-		av_channel_layout_copy(m_audioChLayout, &m_codecCtx->ch_layout);
+	if(out->format.channels() == 0) {
+		out->format.setChannels(m_codecCtx->ch_layout.nb_channels);
+		av_channel_layout_copy(&out->chLayout, &m_codecCtx->ch_layout);
 	} else {
-		av_channel_layout_default(m_audioChLayout, m_audioStreamFormat.channels());
+		av_channel_layout_default(&out->chLayout, out->format.channels());
 	}
 
 	// setup resampler if needed
-	const bool convChannels = av_channel_layout_compare(&m_codecCtx->ch_layout, m_audioChLayout) != 0;
-	const bool convSampleRate = m_codecCtx->sample_rate != m_audioStreamFormat.sampleRate();
-	const bool convSampleFormat = m_codecCtx->sample_fmt != m_audioSampleFormat;
+	const bool convChannels = av_channel_layout_compare(&m_codecCtx->ch_layout, &out->chLayout) != 0;
+	const bool convSampleRate = m_codecCtx->sample_rate != out->format.sampleRate();
+	const bool convSampleFormat = m_codecCtx->sample_fmt != out->sampleFormat;
 	if(convChannels || convSampleRate || convSampleFormat) {
-		swr_alloc_set_opts2(&m_swResample,
-							m_audioChLayout, AVSampleFormat(m_audioSampleFormat), m_audioStreamFormat.sampleRate(),
+		swr_alloc_set_opts2(&out->swr,
+							&out->chLayout, AVSampleFormat(out->sampleFormat), out->format.sampleRate(),
 							&m_codecCtx->ch_layout, m_codecCtx->sample_fmt, m_codecCtx->sample_rate,
 							0, nullptr);
 		// NOTE: swr_convert_frame() will call swr_init() and swr_config_frame() which is better as it seems m_codecCtx can
 		// end up with different config than what is actually in the stream
-		if(!m_swResample) {
+		if(!out->swr) {
 				av_log(nullptr, AV_LOG_ERROR,
 					   "Cannot create sample rate converter for conversion of %d Hz %s %d channels to %d Hz %s %d channels!\n",
 					   m_codecCtx->sample_rate, av_get_sample_fmt_name(m_codecCtx->sample_fmt), m_codecCtx->ch_layout.nb_channels,
-					   m_audioStreamFormat.sampleRate(), av_get_sample_fmt_name(AVSampleFormat(m_audioSampleFormat)), m_audioChLayout->nb_channels);
-				return false;
+					   out->format.sampleRate(), av_get_sample_fmt_name(AVSampleFormat(out->sampleFormat)), out->chLayout.nb_channels);
+				delete out;
+				return nullptr;
 		}
+
+		out->frame = av_frame_alloc();
+		Q_ASSERT(out->frame != nullptr);
+		av_channel_layout_uninit(&out->frame->ch_layout);
+		av_channel_layout_copy(&out->frame->ch_layout, &out->chLayout);
+		out->frame->sample_rate = out->format.sampleRate();
+		out->frame->format = out->sampleFormat;
 	}
 
-	return true;
+	return out;
+}
+
+StreamProcessor::AudioOutput *
+StreamProcessor::audioOutput(const WaveFormat *output) const
+{
+	if(!output)
+		return m_audioOutputs.isEmpty() ? nullptr : m_audioOutputs.first();
+	for(AudioOutput *out : m_audioOutputs) {
+		if(&out->format == output)
+			return out;
+	}
+	return nullptr;
+}
+
+void
+StreamProcessor::clearAudioOutputs()
+{
+	QMutexLocker l(&m_audioMutex);
+	qDeleteAll(m_audioOutputs);
+	m_audioOutputs.clear();
+}
+
+const WaveFormat &
+StreamProcessor::audioFormat() const
+{
+	QMutexLocker l(&m_audioMutex);
+	Q_ASSERT(!m_audioOutputs.isEmpty());
+	return m_audioOutputs.first()->format;
+}
+
+void
+StreamProcessor::setAudioRange(qint64 msecStart, qint64 msecEnd, const WaveFormat *output)
+{
+	QMutexLocker l(&m_audioMutex);
+	AudioOutput *out = audioOutput(output);
+	Q_ASSERT(out && !out->active);
+	if(!out)
+		return;
+	out->rangeStart = out->delivered = qMax(0LL, msecStart);
+	out->rangeEnd = msecEnd;
+}
+
+const WaveFormat *
+StreamProcessor::addAudioOutput(const WaveFormat &waveFormat)
+{
+	if(!m_audioReady)
+		return nullptr;
+
+	AudioOutput *out = createAudioOutput(waveFormat);
+	if(!out)
+		return nullptr;
+
+	QMutexLocker l(&m_audioMutex);
+	if(m_audioClosing) {
+		delete out;
+		return nullptr;
+	}
+	m_audioOutputs.append(out);
+	return &out->format;
+}
+
+bool
+StreamProcessor::removeAudioOutput(const WaveFormat *output)
+{
+	QMutexLocker l(&m_audioMutex);
+	AudioOutput *out = audioOutput(output);
+	if(out) {
+		// consumer won't receive anything after this, its handler can't be removing the output
+		Q_ASSERT(QThread::currentThread() != this || m_audioEmitting != out);
+		while(m_audioEmitting == out)
+			m_audioEmitted.wait(&m_audioMutex);
+		m_audioOutputs.removeOne(out);
+		delete out;
+		m_audioOutputsChanged.wakeAll();
+	}
+	return !m_audioOutputs.isEmpty();
+}
+
+void
+StreamProcessor::pauseAudioOutput(const WaveFormat *output)
+{
+	QMutexLocker l(&m_audioMutex);
+	AudioOutput *out = audioOutput(output);
+	if(!out)
+		return;
+	out->paused.storeRelease(1);
+	out->resuming = false;
+}
+
+void
+StreamProcessor::resumeAudioOutput(const WaveFormat *output)
+{
+	QMutexLocker l(&m_audioMutex);
+	AudioOutput *out = audioOutput(output);
+	if(!out || !out->paused.loadAcquire())
+		return;
+	// decoder thread rewinds to the data output missed and unpauses it
+	out->resuming = true;
+	m_audioOutputsChanged.wakeAll();
+}
+
+StreamProcessor *
+StreamProcessor::attachAudio(const QString &filename, int streamIndex, const WaveFormat &waveFormat, const WaveFormat **output)
+{
+	Q_ASSERT(QThread::currentThread() == qApp->thread());
+
+	const QPair<QString, int> key(filename, streamIndex);
+	StreamProcessor *stream = sharedAudio->value(key, nullptr);
+	if(stream) {
+		*output = stream->addAudioOutput(waveFormat);
+		if(*output) {
+			stream->m_sharedUsers++;
+			return stream;
+		}
+		// decoding is finishing - it will be released by its current users
+		sharedAudio->remove(key);
+	}
+
+	stream = new StreamProcessor();
+	if(!stream->open(filename) || !stream->initAudio(streamIndex, waveFormat)) {
+		delete stream;
+		*output = nullptr;
+		return nullptr;
+	}
+	stream->m_sharedUsers = 1;
+	sharedAudio->insert(key, stream);
+	*output = &stream->m_audioOutputs.first()->format;
+	return stream;
+}
+
+void
+StreamProcessor::detachAudio(StreamProcessor *stream, const WaveFormat *output)
+{
+	if(!stream)
+		return;
+
+	stream->removeAudioOutput(output);
+	if(--stream->m_sharedUsers > 0)
+		return;
+
+	for(auto it = sharedAudio->begin(); it != sharedAudio->end(); ++it) {
+		if(it.value() == stream) {
+			sharedAudio->erase(it);
+			break;
+		}
+	}
+	stream->close();
+	stream->deleteLater();
 }
 
 bool
@@ -359,11 +592,36 @@ StreamProcessor::start()
 	if(!m_opened || !(m_audioReady || m_imageReady || m_textReady))
 		return false;
 
+	if(m_audioReady) {
+		QMutexLocker l(&m_audioMutex);
+		const bool running = isRunning();
+		for(AudioOutput *out : qAsConst(m_audioOutputs)) {
+			if(out->active)
+				continue;
+			out->active = true;
+			// rewind running decoder for the output that joined late
+			if(running && quint64(out->rangeStart) < m_streamPos)
+				m_audioSeek = m_audioSeek < 0 ? out->rangeStart : qMin(m_audioSeek, out->rangeStart);
+		}
+		m_audioOutputsChanged.wakeAll();
+		if(running)
+			return true;
+	}
+
 	QThread::start(LowPriority);
 
 	return true;
 }
 
+void
+StreamProcessor::seekAudio(qint64 msecPos)
+{
+	const int64_t seekTime = av_rescale_q(qMax(0LL, msecPos - AUDIO_RANGE_PREROLL), AVRational{1, 1000}, m_avStream->time_base);
+	if(av_seek_frame(m_avFormat, m_audioStreamCurrent, seekTime, AVSEEK_FLAG_BACKWARD) < 0)
+		qWarning() << "Failed seeking audio stream to" << msecPos << "msec";
+	avcodec_flush_buffers(m_codecCtx);
+}
+
 void
 StreamProcessor::processAudio()
 {
@@ -373,124 +631,246 @@ StreamProcessor::processAudio()
 	Q_ASSERT(pkt != nullptr);
 	AVFrame *frame = av_frame_alloc();
 	Q_ASSERT(frame != nullptr);
-	AVFrame *frameResampled = nullptr;
-
-	if(m_swResample) {
-		frameResampled = av_frame_alloc();
-		Q_ASSERT(frameResampled != nullptr);
-		av_channel_layout_uninit(&frameResampled->ch_layout);
-		av_channel_layout_copy(&frameResampled->ch_layout, m_audioChLayout);
-		frameResampled->sample_rate = m_audioStreamFormat.sampleRate();
-		frameResampled->format = m_audioSampleFormat;
-	}
-
-	const int64_t streamDuration = m_avStream->duration * 1000 * m_avStream->time_base.num / m_avStream->time_base.den;
-	const int64_t containerDuration = m_avFormat->duration * 1000 / AV_TIME_BASE;
-	m_streamLen = streamDuration > containerDuration ? streamDuration : containerDuration;
 
 	int64_t timeFrameStart = 0;
-	int64_t timeFrameDuration = 0;
-	int64_t timeFrameEnd = 0;
-	int64_t timeResampleDelay = 0;
 
-	bool conversionComplete = false;
-
-	while(!conversionComplete && !isInterruptionRequested()) {
-		ret = av_read_frame(m_avFormat, pkt);
-		bool drainDecoder = ret == AVERROR_EOF;
-		if(ret < 0 && !drainDecoder) {
-			av_strerror(ret, errorText, sizeof(errorText));
-			qWarning() << "Error reading packet" << errorText;
-			emit streamError(ret, QStringLiteral("Error reading packet"), QString::fromUtf8(errorText));
-			break;
+	// paused output takes no data until its consumer resumes it, decoding continues for the others
+	const auto isPaused = [](const AudioOutput *out){ return out->paused.loadAcquire() && !out->resuming && !out->finished; };
+	const auto wantsData = [](const AudioOutput *out){ return out->active && !out->finished && (!out->paused.loadAcquire() || out->resuming); };
+	const auto isResuming = [](const AudioOutput *out){ return out->resuming; };
+	QVector<AudioOutput *> outputs;
+
+	{
+		// outputs that were started together are decoded from the earliest range start
+		QMutexLocker l(&m_audioMutex);
+		qint64 rangeStart = m_audioSeek;
+		for(const AudioOutput *out : qAsConst(m_audioOutputs)) {
+			if(out->active && (rangeStart < 0 || out->rangeStart < rangeStart))
+				rangeStart = out->rangeStart;
 		}
+		m_audioSeek = rangeStart > 0 ? rangeStart : -1;
+	}
 
-		if(pkt->stream_index == m_audioStreamCurrent || drainDecoder) {
-			ret = avcodec_send_packet(m_codecCtx, pkt);
-			if(ret < 0) {
-				if(ret != AVERROR(EAGAIN)) {
-					av_strerror(ret, errorText, sizeof(errorText));
-					qWarning() << "Error decoding packet" << errorText;
-					emit streamError(ret, QStringLiteral("Error decoding packet"), QString::fromUtf8(errorText));
+	for(;;) {
+		bool conversionComplete = false;
+
+		while(!conversionComplete && !isInterruptionRequested()) {
+			m_audioMutex.lock();
+			// decoded data would be thrown away
+			while(!isInterruptionRequested() && m_audioSeek < 0 && std::none_of(m_audioOutputs.cbegin(), m_audioOutputs.cend(), wantsData)
+					&& std::any_of(m_audioOutputs.cbegin(), m_audioOutputs.cend(), isPaused))
+				m_audioOutputsChanged.wait(&m_audioMutex);
+			qint64 seekPos = m_audioSeek;
+			for(const AudioOutput *out : qAsConst(m_audioOutputs)) {
+				if(out->resuming && (seekPos < 0 || out->delivered < seekPos))
+					seekPos = out->delivered;
+			}
+			if(seekPos >= 0) {
+				m_audioSeek = -1;
+				for(AudioOutput *out : qAsConst(m_audioOutputs)) {
+					out->skipUntil = out->delivered;
+					if(out->resuming) {
+						out->resuming = false;
+						out->paused.storeRelease(0);
+					}
+					if(out->swr)
+						swr_close(out->swr);
 				}
+			}
+			m_audioMutex.unlock();
+			if(seekPos >= 0) {
+				seekAudio(seekPos);
+				timeFrameStart = 0;
+			}
+
+			ret = av_read_frame(m_avFormat, pkt);
+			bool drainDecoder = ret == AVERROR_EOF;
+			if(ret < 0 && !drainDecoder) {
+				av_strerror(ret, errorText, sizeof(errorText));
+				qWarning() << "Error reading packet" << errorText;
+				emit streamError(ret, QStringLiteral("Error reading packet"), QString::fromUtf8(errorText));
 				break;
 			}
-			while(!conversionComplete && !isInterruptionRequested()) {
-				ret = avcodec_receive_frame(m_codecCtx, frame);
-				bool drainResampler = ret == AVERROR_EOF;
-				if(ret < 0 && !drainResampler) {
+
+			if(pkt->stream_index == m_audioStreamCurrent || drainDecoder) {
+				ret = avcodec_send_packet(m_codecCtx, pkt);
+				if(ret < 0) {
 					if(ret != AVERROR(EAGAIN)) {
 						av_strerror(ret, errorText, sizeof(errorText));
-						qWarning() << "Error decoding audio frame" << errorText;
-						emit streamError(ret, QStringLiteral("Error decoding audio frame"), QString::fromUtf8(errorText));
+						qWarning() << "Error decoding packet" << errorText;
+						emit streamError(ret, QStringLiteral("Error decoding packet"), QString::fromUtf8(errorText));
 					}
 					break;
 				}
-				if(ret == 0) {
-					if(frame->best_effort_timestamp)
-						timeFrameStart = frame->best_effort_timestamp * 1000 * m_avStream->time_base.num / m_avStream->time_base.den;
-				}
-
-				bool drainSampleBuffer = false;
-				do {
-					size_t frameSize;
-					if(m_swResample) {
-						ret = swr_convert_frame(m_swResample, frameResampled, drainSampleBuffer || drainResampler ? nullptr : frame);
-						if(ret < 0) {
+				while(!conversionComplete && !isInterruptionRequested()) {
+					ret = avcodec_receive_frame(m_codecCtx, frame);
+					const bool drainResampler = ret == AVERROR_EOF;
+					if(ret < 0 && !drainResampler) {
+						if(ret != AVERROR(EAGAIN)) {
 							av_strerror(ret, errorText, sizeof(errorText));
-							qWarning() << "Error resampling audio frame" << errorText;
-							emit streamError(ret, QStringLiteral("Error resampling audio frame"), QString::fromUtf8(errorText));
-							break;
+							qWarning() << "Error decoding audio frame" << errorText;
+							emit streamError(ret, QStringLiteral("Error decoding audio frame"), QString::fromUtf8(errorText));
 						}
-						timeResampleDelay = -swr_get_delay(m_swResample, 1000);
-						frameSize = frameResampled->nb_samples * av_get_bytes_per_sample(static_cast<AVSampleFormat>(frameResampled->format));
-						timeFrameDuration = frameResampled->nb_samples * 1000 / frameResampled->sample_rate;
-					} else {
-						frameSize = frame->nb_samples * av_get_bytes_per_sample(static_cast<AVSampleFormat>(frame->format));
-						timeFrameDuration = int64_t(frame->nb_samples) * 1000 / frame->sample_rate;
-					}
-					timeFrameEnd = timeFrameStart + timeFrameDuration;
-
-					if(drainResampler && (!frameResampled || frameResampled->nb_samples == 0)) {
-						conversionComplete = true;
 						break;
 					}
+					if(ret == 0) {
+						if(frame->best_effort_timestamp)
+							timeFrameStart = frame->best_effort_timestamp * 1000 * m_avStream->time_base.num / m_avStream->time_base.den;
+					}
 
-					if(!drainResampler) {
-						m_streamPos = timeFrameEnd;
-						emit streamProgress(m_streamPos, m_streamLen);
+					{
+						QMutexLocker l(&m_audioMutex);
+						if(!drainResampler)
+							m_streamPos = timeFrameStart + int64_t(frame->nb_samples) * 1000 / frame->sample_rate;
+						outputs = m_audioOutputs;
 					}
 
-					if(m_swResample) {
-						Q_ASSERT(frameResampled != nullptr);
-						emit audioDataAvailable(frameResampled->data[0], qint32(frameSize * frameResampled->ch_layout.nb_channels),
-							&m_audioStreamFormat, qint64(timeFrameStart + timeResampleDelay), qint64(timeFrameDuration));
+					// decoded frame is resampled for every output, data is emitted without holding the lock
+					// so consumers are not holding up each other's calls into the decoder
+					conversionComplete = true;
+					for(AudioOutput *out : qAsConst(outputs)) {
+						{
+							QMutexLocker l(&m_audioMutex);
+							if(!m_audioOutputs.contains(out) || out->finished)
+								continue;
+							if(!out->active || out->paused.loadAcquire()) {
+								conversionComplete = false;
+								continue;
+							}
+							m_audioEmitting = out;
+						}
 
-						drainSampleBuffer = swr_get_out_samples(m_swResample, 0) > 1000;
-					} else {
-						emit audioDataAvailable(frame->data[0], qint32(frameSize * frame->ch_layout.nb_channels),
-							&m_audioStreamFormat, qint64(timeFrameStart), qint64(timeFrameDuration));
+						const bool more = convertAudio(out, drainResampler ? nullptr : frame, timeFrameStart);
+						if(more) {
+							conversionComplete = false;
+						} else {
+							out->finished = true;
+							emit audioOutputFinished(&out->format);
+						}
+
+						QMutexLocker l(&m_audioMutex);
+						m_audioEmitting = nullptr;
+						m_audioEmitted.wakeAll();
 					}
-				} while(!conversionComplete && !isInterruptionRequested() && drainSampleBuffer);
+
+					if(drainResampler)
+						break;
+
+					emit streamProgress(m_streamPos, m_streamLen);
+				}
 			}
-		}
 
-		if(drainDecoder)
-			break;
+			if(drainDecoder)
+				break;
+
+			av_packet_unref(pkt);
+		}
 
 		av_packet_unref(pkt);
+
+		QMutexLocker l(&m_audioMutex);
+		// consumer that was just attached or paused might still want to rewind the decoder
+		const auto isInactive = [](const AudioOutput *out){ return !out->active; };
+		const auto rewindRequested = [&](){ return m_audioSeek >= 0 || std::any_of(m_audioOutputs.cbegin(), m_audioOutputs.cend(), isResuming); };
+		while(!isInterruptionRequested() && !rewindRequested() && (std::any_of(m_audioOutputs.cbegin(), m_audioOutputs.cend(), isInactive)
+				|| std::any_of(m_audioOutputs.cbegin(), m_audioOutputs.cend(), isPaused)))
+			m_audioOutputsChanged.wait(&m_audioMutex);
+		if(rewindRequested() && !isInterruptionRequested())
+			continue;
+
+		m_audioClosing = true;
+		QVector<const WaveFormat *> finished;
+		for(AudioOutput *out : qAsConst(m_audioOutputs)) {
+			if(!out->finished) {
+				out->finished = true;
+				finished.push_back(&out->format);
+			}
+		}
+		l.unlock();
+		// formats are only compared by consumers, they are not dereferenced
+		for(const WaveFormat *format : qAsConst(finished))
+			emit audioOutputFinished(format);
+		break;
 	}
 
 	av_frame_free(&frame);
-	if(frameResampled)
-		av_frame_free(&frameResampled);
-
 	av_packet_free(&pkt);
 
 	emit streamFinished();
 	QMetaObject::invokeMethod(this, "close", Qt::QueuedConnection);
 }
 
+bool
+StreamProcessor::convertAudio(AudioOutput *out, AVFrame *frame, qint64 msecStart)
+{
+	if(!out->swr) {
+		// without resampler there is nothing left once the decoder is drained
+		return frame && emitAudio(out, frame->data[0], frame->nb_samples,
+			av_get_bytes_per_sample(static_cast<AVSampleFormat>(frame->format)), msecStart);
+	}
+
+	bool drainSampleBuffer = false;
+	do {
+		const int ret = swr_convert_frame(out->swr, out->frame, drainSampleBuffer ? nullptr : frame);
+		if(ret < 0) {
+			char errorText[1024];
+			av_strerror(ret, errorText, sizeof(errorText));
+			qWarning() << "Error resampling audio frame" << errorText;
+			emit streamError(ret, QStringLiteral("Error resampling audio frame"), QString::fromUtf8(errorText));
+			return frame != nullptr;
+		}
+
+		if(!frame && out->frame->nb_samples == 0)
+			return false;
+
+		if(!emitAudio(out, out->frame->data[0], out->frame->nb_samples,
+				av_get_bytes_per_sample(static_cast<AVSampleFormat>(out->frame->format)), msecStart - swr_get_delay(out->swr, 1000)))
+			return false;
+
+		drainSampleBuffer = swr_get_out_samples(out->swr, 0) > 1000;
+	} while(drainSampleBuffer || !frame);
+
+	return true;
+}
+
+bool
+StreamProcessor::emitAudio(AudioOutput *out, const quint8 *data, int samples, int bytesPerSample, qint64 msecStart)
+{
+	// output is rewound to the data it didn't take when it's resumed
+	if(out->paused.loadAcquire())
+		return true;
+
+	const qint64 sampleRate = out->format.sampleRate();
+	const qint64 msecEnd = msecStart + samples * 1000 / sampleRate;
+
+	if(out->rangeEnd >= 0 && msecStart >= out->rangeEnd)
+		return false;
+
+	// data before skipUntil was already emitted before the decoder was rewound for another output
+	const qint64 rangeStart = qMax(out->rangeStart, out->skipUntil);
+	if(out->skipUntil && msecEnd >= out->skipUntil)
+		out->skipUntil = 0;
+
+	int first = 0;
+	int last = samples;
+	if(rangeStart > 0 && msecStart < rangeStart)
+		first = qMin(qint64(samples), (rangeStart - msecStart) * sampleRate / 1000);
+	if(out->rangeEnd >= 0 && msecEnd > out->rangeEnd)
+		last = (out->rangeEnd - msecStart) * sampleRate / 1000;
+
+	if(first < last) {
+		const int frameBytes = bytesPerSample * out->format.channels();
+		emit audioDataAvailable(data + first * frameBytes, qint32((last - first) * frameBytes), &out->format,
+			msecStart + first * 1000 / sampleRate, (last - first) * 1000 / sampleRate);
+		// consumer that paused the output didn't take the data
+		if(out->paused.loadAcquire())
+			return true;
+		out->delivered = msecStart + last * 1000 / sampleRate;
+	}
+
+	return out->rangeEnd < 0 || msecEnd < out->rangeEnd;
+}
+
 void
 StreamProcessor::processText()
 {
@@ -9,7 +9,10 @@
 
 #include "videoplayer/waveformat.h"
 
+#include <QMutex>
 #include <QThread>
+#include <QVector>
+#include <QWaitCondition>
 #include <QString>
 #include <QStringList>
 #include <QPixmap>
@@ -19,8 +22,7 @@ QT_FORWARD_DECLARE_CLASS(QTimer)
 struct AVFormatContext;
 struct AVCodecContext;
 struct AVStream;
-struct SwrContext;
-struct AVChannelLayout;
+struct AVFrame;
 
 namespace SubtitleComposer {
 
@@ -38,6 +40,58 @@ public:
 	bool initText(int streamIndex);
 	Q_INVOKABLE void close();
 
+	/**
+	 * @brief Limit audio decoding of @p output to [@p msecStart, @p msecEnd) of the stream
+	 *
+	 * Must be called after initAudio() and before start(). Decoding seeks near @p msecStart and audio
+	 * data outside of the range is not emitted. Negative @p msecEnd decodes until the end of stream.
+	 * Null @p output is the output created by initAudio().
+	 */
+	void setAudioRange(qint64 msecStart, qint64 msecEnd, const WaveFormat *output = nullptr);
+
+	/**
+	 * @brief Add another consumer of the audio stream which gets the audio resampled to @p waveFormat
+	 *
+	 * Output is identified by the returned format pointer, which is passed along with its data
+	 * in audioDataAvailable() and audioOutputFinished(). Output receives data after the following start().
+	 * Returns nullptr if the decoding is already finishing.
+	 */
+	const WaveFormat * addAudioOutput(const WaveFormat &waveFormat);
+	/**
+	 * @brief Remove audio output, data is not emitted for it after this returns
+	 *
+	 * Waits for audioDataAvailable() handler of the output to return, so it must not be called from it.
+	 * @return true if there are still other outputs
+	 */
+	bool removeAudioOutput(const WaveFormat *output);
+	/**
+	 * @brief Stop emitting data of @p output until resumeAudioOutput(), decoding continues for the other outputs
+	 *
+	 * Meant to be called from audioDataAvailable() handler of a consumer that has no room for the data,
+	 * data of that call is emitted again after resume.
+	 */
+	void pauseAudioOutput(const WaveFormat *output);
+	/**
+	 * @brief Continue emitting data of paused @p output, decoder is rewound to the data it missed
+	 */
+	void resumeAudioOutput(const WaveFormat *output);
+
+	/**
+	 * @brief Get shared decoder of @p streamIndex audio stream in @p filename
+	 *
+	 * Audio stream is decoded once for all consumers and resampled to each consumer's @p waveFormat.
+	 * Stores consumer's output format in @p output. Must be called from the main thread and
+	 * released with detachAudio(). Consumer connects to the signals and calls start() afterwards.
+	 * If the decoding is already running it is rewound for the new consumer.
+	 * audioDataAvailable() handlers are holding up all the other consumers, consumer that can't
+	 * keep up must not block in it but pause its output with pauseAudioOutput().
+	 */
+	static StreamProcessor * attachAudio(const QString &filename, int streamIndex, const WaveFormat &waveFormat, const WaveFormat **output);
+	static void detachAudio(StreamProcessor *stream, const WaveFormat *output);
+
+	const WaveFormat & audioFormat() const;
+	inline quint64 duration() const { return m_streamLen; }
+
 	QStringList listAudio();
 	QStringList listText();
 	QStringList listImage();
@@ -51,10 +105,20 @@ signals:
 	void streamProgress(quint64 msecPosition, quint64 msecLength);
 	void streamError(int code, const QString &message, const QString &debug);
 	void streamFinished();
+	void audioOutputFinished(const WaveFormat *waveFormat);
 
 protected:
 	int findStream(int streamType, int streamIndex, bool imageSub);
+
+	struct AudioOutput;
+
+	AudioOutput * createAudioOutput(const WaveFormat &waveFormat);
+	AudioOutput * audioOutput(const WaveFormat *output) const;
+	void clearAudioOutputs();
+	void seekAudio(qint64 msecPos);
 	void processAudio();
+	bool convertAudio(AudioOutput *out, AVFrame *frame, qint64 msecStart);
+	bool emitAudio(AudioOutput *out, const quint8 *data, int samples, int bytesPerSample, qint64 msecStart);
 	void processText();
 	virtual void run() override;
 
@@ -65,7 +129,15 @@ private:
 	bool m_audioReady;
 	int m_audioStreamIndex;
 	int m_audioStreamCurrent;
-	WaveFormat m_audioStreamFormat;
+	QVector<AudioOutput *> m_audioOutputs;
+	mutable QMutex m_audioMutex;
+	QWaitCondition m_audioOutputsChanged;
+	qint64 m_audioSeek;
+	// output whose data is being emitted, it can't be removed until that's done
+	AudioOutput *m_audioEmitting;
+	QWaitCondition m_audioEmitted;
+	bool m_audioClosing;
+	int m_sharedUsers;
 
 	bool m_imageReady;
 	int m_imageStreamIndex;
@@ -81,11 +153,10 @@ private:
 	AVFormatContext *m_avFormat;
 	AVStream *m_avStream;
 	AVCodecContext *m_codecCtx;
-	SwrContext *m_swResample;
-	int m_audioSampleFormat;
-	AVChannelLayout *m_audioChLayout;
 };
 
 }
 
+Q_DECLARE_METATYPE(const WaveFormat *)
+
 #endif // STREAMPROCESSOR_H
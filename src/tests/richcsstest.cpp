@@ -8,6 +8,7 @@
 #include "helpers/common.h"
 
 #include <QDebug>
+#include <QStringBuilder>
 #include <QTest>
 
 using namespace SubtitleComposer;
@@ -138,4 +139,182 @@ RichCssTest::testParseRules()
 	QCOMPARE(RichCSS::parseCssRules(&data).toString(), cssOut);
 }
 
+void
+RichCssTest::testCacheKey()
+{
+	RichCSS a;
+	RichCSS b;
+	QVERIFY(a.cacheKey() != b.cacheKey());
+
+	const quint64 key = a.cacheKey();
+	a.parse($("c { color: red; }"));
+	QVERIFY(a.cacheKey() != key);
+	QVERIFY(a.cacheKey() != b.cacheKey());
+
+	const quint64 parsed = a.cacheKey();
+	a.clear();
+	QVERIFY(a.cacheKey() != parsed);
+	QVERIFY(a.cacheKey() != key);
+
+	b = a;
+	QVERIFY(b.cacheKey() != a.cacheKey());
+}
+
+static QString
+matchedRules(const RichCSS &stylesheet, const QStringList &selectors)
+{
+#if QT_VERSION < QT_VERSION_CHECK(5, 14, 0)
+	const QSet<QString> sel = selectors.toSet();
+#else
+	const QSet<QString> sel(selectors.cbegin(), selectors.cend());
+#endif
+	QString res;
+	const QMap<QByteArray, QString> styles = stylesheet.match(sel);
+	for(auto it = styles.cbegin(); it != styles.cend(); ++it)
+		res += QString::fromLatin1(it.key()) % QChar(':') % it.value() % QChar(';');
+	return res;
+}
+
+void
+RichCssTest::testMatch_data()
+{
+	QTest::addColumn<QString>("stylesheet");
+	QTest::addColumn<QStringList>("selectors");
+	QTest::addColumn<QString>("rules");
+
+	const QString sheet = $("b { color: red; font-style: normal; }"
+		".loud { color: blue; }"
+		"i, .quiet { color: gray; }"
+		"v[voice=Bob] .loud { background-color: black; }"
+		"c > .x { font-weight: bold; }");
+
+	QTest::newRow("simple") << sheet << QStringList{$("b")} << $("color:red;font-style:normal;");
+	QTest::newRow("stylesheet order") << sheet << QStringList{$(".loud"), $("b")} << $("color:blue;font-style:normal;");
+	QTest::newRow("comma first") << sheet << QStringList{$("i")} << $("color:gray;");
+	QTest::newRow("comma second") << sheet << QStringList{$(".quiet")} << QString();
+	QTest::newRow("compound") << sheet << QStringList{$(".loud"), $("v[voice=Bob]")} << $("color:blue;");
+	QTest::newRow("compound partial") << sheet << QStringList{$("v[voice=Bob]")} << QString();
+	QTest::newRow("child") << sheet << QStringList{$("c"), $(".x")} << QString();
+	QTest::newRow("no match") << sheet << QStringList{$("u"), $(".x")} << QString();
+	QTest::newRow("empty") << QString() << QStringList{$("b")} << QString();
+}
+
+void
+RichCssTest::testMatch()
+{
+	QFETCH(QString, stylesheet);
+	QFETCH(QStringList, selectors);
+	QFETCH(QString, rules);
+
+	RichCSS parsed;
+	parsed.parse(stylesheet);
+	QCOMPARE(matchedRules(parsed, selectors), rules);
+	// cached result
+	QCOMPARE(matchedRules(parsed, selectors), rules);
+}
+
+void
+RichCssTest::testMatchCache()
+{
+	RichCSS a;
+	a.parse($("b { color: red; }"));
+	QCOMPARE(matchedRules(a, {$("b")}), $("color:red;"));
+
+	a.parse($("b { color: blue; }"));
+	QCOMPARE(matchedRules(a, {$("b")}), $("color:blue;"));
+
+	RichCSS b;
+	b = a;
+	QCOMPARE(matchedRules(b, {$("b")}), $("color:blue;"));
+
+	a.clear();
+	QCOMPARE(matchedRules(a, {$("b")}), QString());
+	QCOMPARE(matchedRules(b, {$("b")}), $("color:blue;"));
+}
+
+/**
+ * @brief Linear matcher that RichCSS::match() used before selectors were indexed
+ */
+QMap<QByteArray, QString>
+RichCssTest::linearMatch(const RichCSS &stylesheet, const QSet<QString> &selectors)
+{
+	QMap<QByteArray, QString> styles;
+	for(const RichCSS::Block &b: qAsConst(stylesheet.m_stylesheet)) {
+		const QChar *s = b.selector.constData();
+		const QChar *ss = s;
+		const QChar *e = s + b.selector.size();
+		bool matched = true;
+		for(;;) {
+			if(*s == QChar('[')) {
+				while(*s != QChar(']') && s != e)
+					s++;
+			}
+			if(*s == QChar::Space || *s == QChar('>') || *s == QChar(',') || s == e) {
+				if(selectors.contains(QString(ss, s - ss))) {
+					if(*s == QChar(',') || s == e)
+						break;
+				} else {
+					while(*s != QChar(',') && s != e)
+						s++;
+					if(s == e) {
+						matched = false;
+						break;
+					}
+				}
+				ss = s;
+			}
+			s++;
+		}
+		if(!matched)
+			continue;
+		for(const RichCSS::Rule &r: qAsConst(b.rules))
+			styles[r.name] = r.value;
+	}
+	return styles;
+}
+
+void
+RichCssTest::testMatchLinear_data()
+{
+	QTest::addColumn<QString>("stylesheet");
+	QTest::addColumn<QStringList>("pool");
+
+	QTest::newRow("simple")
+		<< $("b { color: red; } .loud { color: blue; } b { font-style: normal; } .x { color: green; }")
+		<< QStringList{$("b"), $(".loud"), $(".x"), $("i"), QString()};
+	QTest::newRow("comma")
+		<< $("i, .quiet { color: gray; } u,b, .quiet { font-weight: bold; } .quiet { color: white; }")
+		<< QStringList{$("i"), $(".quiet"), $(" .quiet"), $(","), $(",b"), $("u"), $("b")};
+	QTest::newRow("compound")
+		<< $("v[voice=Bob] .loud { color: black; } c > .x { color: red; } c .x, d { color: blue; } d { color: green; }")
+		<< QStringList{$("v[voice=Bob]"), $(".loud"), $(" .loud"), $("c"), $(".x"), $(">.x"), $(" .x"), $("d"), $(",")};
+	QTest::newRow("attribute")
+		<< $("v[voice=\"a, b\"] { color: red; } v[voice=a b] .x, i { color: blue; } [lang=en] { color: green; }")
+		<< QStringList{$("v[voice=\"a, b\"]"), $("v[voice=ab]"), $("v[voice=a b]"), $(".x"), $(" .x"), $(","), $(", i"), $("i"), $("[lang=en]")};
+	QTest::newRow("empty") << QString() << QStringList{$("b"), QString()};
+}
+
+void
+RichCssTest::testMatchLinear()
+{
+	QFETCH(QString, stylesheet);
+	QFETCH(QStringList, pool);
+
+	RichCSS parsed;
+	parsed.parse(stylesheet);
+
+	// every subset of the pool must give the same result as the linear matcher
+	for(int mask = 0; mask < 1 << pool.size(); mask++) {
+		QSet<QString> selectors;
+		for(int i = 0; i < pool.size(); i++) {
+			if(mask & (1 << i))
+				selectors.insert(pool.at(i));
+		}
+		const QMap<QByteArray, QString> expected = linearMatch(parsed, selectors);
+		QCOMPARE(parsed.match(selectors), expected);
+		// cached result
+		QCOMPARE(parsed.match(selectors), expected);
+	}
+}
+
 QTEST_GUILESS_MAIN(RichCssTest)
@@ -23,6 +23,17 @@ private slots:
 
 	void testParseRules_data();
 	void testParseRules();
+
+	void testCacheKey();
+
+	void testMatch_data();
+	void testMatch();
+	void testMatchCache();
+	void testMatchLinear_data();
+	void testMatchLinear();
+
+private:
+	static QMap<QByteArray, QString> linearMatch(const SubtitleComposer::RichCSS &stylesheet, const QSet<QString> &selectors);
 };
 
 #endif // RICHCSSTEST_H
@@ -9,12 +9,225 @@
 #include "core/richstring.h"
 #include "helpers/common.h"
 
+#include <QBuffer>
+#include <QColor>
+#include <QDataStream>
 #include <QDebug>
+#include <QRandomGenerator>
 #include <QTest>
 #include <QRegularExpression>
 
 using namespace SubtitleComposer;
 
+/**
+ * @brief Regular expression based rich text parser that was used before the tokenizer,
+ * kept as reference for parse results and speed
+ */
+static RichString
+parseReference(const QString &string)
+{
+	staticRE$(tagRegExp, "(<"
+			"(/?(v |c\\.?|\\w+))"
+			"([^>]*\\bcolor=\"?([\\w#]+)\"?|[^>]+)?"
+			"[^>]*?>|&([^;]+);|\\n)", REu | REi);
+	staticRE$(colorRegExp, "style=\"[^\">]*\\bcolor:([\\w#]+)", REu | REi);
+
+	QRegularExpressionMatchIterator it = tagRegExp.globalMatch(string);
+
+	RichString res;
+	QStringList classList;
+	QStringList voiceList;
+	auto listIndex = [](QStringList &list, const QString &name){
+		if(name.isEmpty())
+			return -1;
+		if(!list.contains(name))
+			list.append(name);
+		return int(list.indexOf(name));
+	};
+
+	QStringList colorTags;
+	bool softBreak = false;
+	quint8 currentStyle = 0;
+	QColor currentColor;
+	int offsetPos = 0, matchedPos;
+	quint32 currentClass = 0;
+	qint32 currentVoice = -1;
+	QVector<int> openClass;
+	for(;;) {
+		quint8 newStyle = currentStyle;
+		QColor newColor(currentColor);
+		quint32 newClass = currentClass;
+		qint32 newVoice = currentVoice;
+
+		const bool validIter = it.hasNext();
+		QRegularExpressionMatch m;
+
+		QString mTag;
+		QString ent;
+
+		if(validIter) {
+			m = it.next();
+
+			matchedPos = m.capturedStart();
+			ent = m.captured(6);
+			if(ent.isNull()) {
+				mTag = m.captured(2).toLower();
+				if(mTag == QLatin1String("b") || mTag == QLatin1String("strong")) {
+					newStyle |= RichString::Bold;
+				} else if(mTag == QLatin1String("i") || mTag == QLatin1String("em")) {
+					newStyle |= RichString::Italic;
+				} else if(mTag == QLatin1String("u")) {
+					newStyle |= RichString::Underline;
+				} else if(mTag == QLatin1String("s")) {
+					newStyle |= RichString::StrikeThrough;
+				} else if(mTag == QLatin1String("font")) {
+					const QString &color = m.captured(5);
+					if(!color.isEmpty()) {
+						newStyle |= RichString::Color;
+						newColor.setNamedColor(color.toLower());
+						colorTags.push_back(currentColor.name());
+						colorTags.push_back(mTag);
+					}
+				} else if(mTag == QLatin1String("v ")) {
+					newVoice = listIndex(voiceList, m.captured(4));
+				} else if(mTag == QLatin1String("c.") || mTag == QLatin1String("c")) {
+					const int i = listIndex(classList, m.captured(4));
+					if(i >= 0)
+						newClass |= 1UL << i;
+					openClass.push_back(i);
+				} else if(mTag == QLatin1String("/b") || mTag == QLatin1String("/strong")) {
+					newStyle &= ~RichString::Bold;
+				} else if(mTag == QLatin1String("/i") || mTag == QLatin1String("/em")) {
+					newStyle &= ~RichString::Italic;
+				} else if(mTag == QLatin1String("/u")) {
+					newStyle &= ~RichString::Underline;
+				} else if(mTag == QLatin1String("/s")) {
+					newStyle &= ~RichString::StrikeThrough;
+				} else if(mTag == QLatin1String("/c")) {
+					if(!openClass.isEmpty()) {
+						const int i = openClass.back();
+						openClass.pop_back();
+						if(i >= 0)
+							newClass &= ~(1UL << i);
+					}
+				} else if(mTag == QLatin1String("/c.")) {
+					const int i = listIndex(classList, m.captured(4));
+					if(i >= 0)
+						newClass &= ~(1UL << i);
+					for(auto it = openClass.rbegin(); it != openClass.rend(); ++it) {
+						if(*it == i) {
+							openClass.erase((++it).base());
+							break;
+						}
+					}
+				}
+
+				if(!mTag.isEmpty()) {
+					if(mTag.front() != QLatin1Char('/')) {
+						QRegularExpressionMatch mc = colorRegExp.match(m.captured(4));
+						if(mc.hasMatch()) {
+							newStyle |= RichString::Color;
+							newColor.setNamedColor(mc.captured(1).toLower());
+							colorTags.push_back(currentColor.name());
+							colorTags.push_back(mTag);
+						}
+					} else if(!colorTags.empty() && mTag.mid(1) == colorTags.back()) {
+						colorTags.pop_back();
+						if(colorTags.size() == 1) {
+							newStyle &= ~RichString::Color;
+							newColor.setNamedColor("-invalid-");
+						} else {
+							newStyle |= RichString::Color;
+							newColor.setNamedColor(colorTags.back());
+						}
+						colorTags.pop_back();
+					}
+				}
+			}
+		} else {
+			matchedPos = string.length();
+		}
+
+		if(const int len = matchedPos - offsetPos) {
+			if(softBreak) {
+				if(!res.isEmpty() && res.back() != QChar::LineFeed)
+					res.append(QChar::LineFeed);
+				softBreak = false;
+			}
+			QSet<QString> classes;
+			for(int i = 0; i < classList.size(); i++) {
+				if(currentClass & (1UL << i))
+					classes.insert(classList.at(i));
+			}
+			res.append(RichString(string.mid(offsetPos, len), currentStyle, currentColor.isValid() ? currentColor.rgb() : 0,
+				classes, currentVoice < 0 ? QString() : voiceList.at(currentVoice)));
+		}
+
+		currentStyle = newStyle;
+		currentColor = newColor;
+		currentClass = newClass;
+		currentVoice = newVoice;
+
+		if(validIter) {
+			if(!ent.isNull()) {
+				if(ent == QLatin1String("nbsp")) {
+					res.append(QChar::Nbsp);
+				} else if(ent == QLatin1String("lt")) {
+					res.append(QLatin1Char('<'));
+				} else if(ent == QLatin1String("gt")) {
+					res.append(QLatin1Char('>'));
+				} else if(ent == QLatin1String("amp")) {
+					res.append(QLatin1Char('&'));
+				} else if(ent == QLatin1String("quot")) {
+					res.append(QLatin1Char('"'));
+				} else {
+					res.append(ent);
+				}
+			} else {
+				if(m.captured(1).front() == QChar::LineFeed) {
+					softBreak = true;
+				} else if(mTag == QLatin1String("br")) {
+					res.append(QChar::LineFeed);
+					softBreak = false;
+				} else if(mTag == QLatin1String("p")) {
+					if(!res.isEmpty() && res.back() != QChar::LineFeed) {
+						res.append(QChar::LineFeed);
+						softBreak = false;
+					}
+				} else if(mTag == QLatin1String("/p")) {
+					softBreak = true;
+				}
+			}
+		} else {
+			break;
+		}
+
+		offsetPos = m.capturedEnd();
+	}
+
+	return res;
+}
+
+static bool
+sameStyles(const RichString &actual, const RichString &expected)
+{
+	if(actual.string() != expected.string())
+		return false;
+	for(int i = 0; i < expected.length(); i++) {
+		if(actual.styleFlagsAt(i) != expected.styleFlagsAt(i)
+				|| actual.styleColorAt(i) != expected.styleColorAt(i)
+				|| actual.styleClassesAt(i) != expected.styleClassesAt(i)
+				|| actual.styleVoiceAt(i) != expected.styleVoiceAt(i))
+			return false;
+	}
+	return true;
+}
+
+static void
+ignoreMessages(QtMsgType, const QMessageLogContext &, const QString &)
+{
+}
+
 void
 RichStringTest::testStyleFlags()
 {
@@ -299,6 +512,28 @@ RichStringTest::testReplace()
 	sstring.setRichString("<v Person A>Hi <b>Person B</b>! How are you doing?\n<v Person B><c.test>Hi there.</c.test> Doing great!");
 	sstring.replace($("are you"), $("is you"));
 	QVERIFY(sstring.richString() == QLatin1String("<v Person A>Hi <b>Person B</b>! How is you doing?\n<v Person B><c.test>Hi there.</c> Doing great!"));
+
+	// neighbouring style runs stay merged after replace
+	sstring.setRichString("<b>01</b>2345<i>67</i>");
+	sstring.replace(2, 2, $("abc"));
+	QVERIFY(sstring.richString() == QLatin1String("<b>01</b>abc45<i>67</i>"));
+	QVERIFY(sstring.hasValidStyleRuns());
+	sstring.replace(0, 2, RichString("xy", RichString::Bold));
+	QVERIFY(sstring.richString() == QLatin1String("<b>xy</b>abc45<i>67</i>"));
+	QVERIFY(sstring.hasValidStyleRuns());
+	sstring.replace(5, 2, RichString("zz"));
+	QVERIFY(sstring.richString() == QLatin1String("<b>xy</b>abczz<i>67</i>"));
+	QVERIFY(sstring.hasValidStyleRuns());
+	sstring.replace(7, 0, RichString("w", RichString::Italic));
+	QVERIFY(sstring.richString() == QLatin1String("<b>xy</b>abczz<i>w67</i>"));
+	QVERIFY(sstring.hasValidStyleRuns());
+	for(int i = 0; i < 10; i++) {
+		sstring.replace(4, 1, $("qq"));
+		QVERIFY(sstring.hasValidStyleRuns());
+		sstring.replace(4, 2, $("c"));
+		QVERIFY(sstring.hasValidStyleRuns());
+	}
+	QVERIFY(sstring.richString() == QLatin1String("<b>xy</b>abczz<i>w67</i>"));
 }
 
 void
@@ -344,4 +579,125 @@ RichStringTest::testStyleMerge()
 	QVERIFY(sstring.cummulativeVoices().size() == 1);
 }
 
+void
+RichStringTest::testDataStream()
+{
+	RichString sstring;
+	sstring.setRichString("<v voiceA><c.classA>01<b>23</b></c><i>45</i><font color=#ff0000>67</font><u>89</u>");
+	sstring.setStyleFlagsAt(9, RichString::Bold);
+
+	QByteArray data;
+	QBuffer buffer(&data);
+	buffer.open(QIODevice::WriteOnly);
+	QDataStream out(&buffer);
+	out << sstring;
+	buffer.close();
+
+	RichString read;
+	buffer.open(QIODevice::ReadOnly);
+	QDataStream in(&buffer);
+	in >> read;
+	QVERIFY(read == sstring);
+	QCOMPARE(read.richString(), sstring.richString());
+	QCOMPARE(read.styleFlagsAt(9), RichString::StyleFlags(RichString::Bold));
+	QCOMPARE(read.styleColorAt(6), QColor("#ff0000").rgb());
+	QCOMPARE(read.styleVoiceAt(0), $("voiceA"));
+}
+
+void
+RichStringTest::testParse_data()
+{
+	QTest::addColumn<QString>("text");
+
+	QTest::newRow("empty") << QString();
+	QTest::newRow("plain") << $("plain text");
+	QTest::newRow("styles") << $("<b>bold</B> <I>italic</i> <u>under</u> <s>strike</s> <strong>a</strong><em>b</em>");
+	QTest::newRow("nested") << $("<b>a<i>b<u>c</b>d</i>e</u>f");
+	QTest::newRow("font") << $("<font color=\"#FF0000\">red <font color=blue>blue</font> red</font> none");
+	QTest::newRow("style color") << $("<span style=\"font-weight: bold; color: red; color:#00ff00\">green</span> none");
+	QTest::newRow("font and style") << $("<font color=red style=\"color:blue\">x</font>y</font>z");
+	QTest::newRow("last color") << $("<font face=x color=red size=2 color=\"#0000ff\" color=\"\">blue</font>");
+	QTest::newRow("no color") << $("<font xcolor=red>a</font><font color=>b</font>");
+	QTest::newRow("voice class") << $("<v Person A>Hi <c.loud.red>there</c> <c.x>y</c.x>!\n<V Person B><c>z</c></v>");
+	QTest::newRow("c prefix") << $("<code>a</code><cite>b</c>");
+	QTest::newRow("unbalanced") << $("</c></c.x></b></font>a<b>b");
+	QTest::newRow("entities") << $("&lt;&gt;&amp;&quot;&nbsp;&unknown;&;&& x<y;");
+	QTest::newRow("breaks") << $("<p>one</p><p>two</p>three<br>four<br/>five\n\nsix\n<p>");
+	QTest::newRow("broken tags") << $("a < b > c <b <i>d</i> <> </> <1x>e <_>f <é>g <b");
+	QTest::newRow("multiline tag") << $("<font\ncolor=red>a</font>");
+}
+
+void
+RichStringTest::testParse()
+{
+	QFETCH(QString, text);
+
+	const QtMessageHandler handler = qInstallMessageHandler(ignoreMessages);
+	RichString actual;
+	actual.setRichString(text);
+	const RichString expected = parseReference(text);
+	qInstallMessageHandler(handler);
+
+	QCOMPARE(actual.string(), expected.string());
+	QVERIFY(sameStyles(actual, expected));
+	QCOMPARE(actual.richString(), expected.richString());
+}
+
+void
+RichStringTest::testParseFuzz()
+{
+	const char *parts[] = {
+		"<", ">", "</", "/", "b", "I", "u", "s", "em", "strong", "font", "span", "p", "br",
+		"v ", "V ", "c", "c.", ".", "x", "_", " ", "\n", "\"", "=", ";", "&", "amp", "lt", "nbsp", "q",
+		" color=", "color=\"", "red", "#00ff00", "Blue", " style=\"", "color:", "yellow",
+	};
+	const int partCount = sizeof(parts) / sizeof(*parts);
+
+	const QtMessageHandler handler = qInstallMessageHandler(ignoreMessages);
+	QRandomGenerator rng(1234);
+	for(int i = 0; i < 20000; i++) {
+		QString text;
+		for(int j = 0, n = rng.bounded(1, 30); j < n; j++)
+			text.append(QLatin1String(parts[rng.bounded(partCount)]));
+
+		RichString actual;
+		actual.setRichString(text);
+		const RichString expected = parseReference(text);
+		if(!sameStyles(actual, expected)) {
+			qInstallMessageHandler(handler);
+			QFAIL(qPrintable(text));
+		}
+	}
+	qInstallMessageHandler(handler);
+}
+
+void
+RichStringTest::benchmarkParse_data()
+{
+	QTest::addColumn<bool>("reference");
+
+	QTest::newRow("tokenizer") << false;
+	QTest::newRow("regexp") << true;
+}
+
+void
+RichStringTest::benchmarkParse()
+{
+	QFETCH(bool, reference);
+
+	const QString text = $("<v Narrator><i>Line with <b>bold</b> and <font color=\"#ff8000\">colored</font> words</i>\n"
+		"second &amp; <c.yellow>last</c> row</v>");
+
+	QBENCHMARK {
+		for(int i = 0; i < 1000; i++) {
+			RichString str;
+			if(reference)
+				str = parseReference(text);
+			else
+				str.setRichString(text);
+			QCOMPARE(str.length(), 50);
+		}
+	}
+}
+
 QTEST_GUILESS_MAIN(RichStringTest);
@@ -20,6 +20,12 @@ private slots:
 	void testInsert();
 	void testReplace();
 	void testStyleMerge();
+	void testDataStream();
+	void testParse_data();
+	void testParse();
+	void testParseFuzz();
+	void benchmarkParse_data();
+	void benchmarkParse();
 };
 
 #endif
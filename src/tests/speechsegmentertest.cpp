@@ -0,0 +1,134 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "speechsegmentertest.h"
+#include "speechprocessor/speechsegmenter.h"
+
+#include <QByteArray>
+#include <QTest>                               // krazy:exclude=c++/includes
+
+using namespace SubtitleComposer;
+
+#define SAMPLE_RATE 16000
+// samples in 10ms frame
+#define FRAME (SAMPLE_RATE / 100)
+
+static void
+appendAudio(QByteArray *data, int msec, qint16 amplitude)
+{
+	for(int i = 0; i < msec * SAMPLE_RATE / 1000; i++) {
+		const qint16 val = i & 1 ? amplitude : -amplitude;
+		data->append(reinterpret_cast<const char *>(&val), sizeof(val));
+	}
+}
+
+static QByteArray
+utterances()
+{
+	QByteArray data;
+	appendAudio(&data, 1000, 0);
+	appendAudio(&data, 1000, 5000);
+	appendAudio(&data, 1000, 0);
+	appendAudio(&data, 2000, 5000);
+	appendAudio(&data, 1000, 0);
+	return data;
+}
+
+static void
+verifyUtterances(SpeechSegmenter *segmenter)
+{
+	SpeechSegmenter::Segment segment;
+
+	// 300ms of silence before speech, 500ms after
+	QVERIFY(segmenter->takeSegment(&segment));
+	QCOMPARE(segment.index, 0);
+	QCOMPARE(segment.start, qint64(70 * FRAME));
+	QCOMPARE(int(segment.samples.size()), 180 * FRAME * 2);
+
+	QVERIFY(segmenter->takeSegment(&segment));
+	QCOMPARE(segment.index, 1);
+	QCOMPARE(segment.start, qint64(270 * FRAME));
+	QCOMPARE(int(segment.samples.size()), 280 * FRAME * 2);
+
+	QVERIFY(!segmenter->takeSegment(&segment));
+}
+
+void
+SpeechSegmenterTest::testSilence()
+{
+	SpeechSegmenter segmenter(WaveFormat(SAMPLE_RATE, 1, 16));
+	QByteArray data;
+	appendAudio(&data, 5000, 0);
+	segmenter.process(data.constData(), data.size());
+	segmenter.flush();
+
+	SpeechSegmenter::Segment segment;
+	QVERIFY(!segmenter.takeSegment(&segment));
+}
+
+void
+SpeechSegmenterTest::testUtterances()
+{
+	SpeechSegmenter segmenter(WaveFormat(SAMPLE_RATE, 1, 16));
+	const QByteArray data = utterances();
+	segmenter.process(data.constData(), data.size());
+	segmenter.flush();
+	verifyUtterances(&segmenter);
+
+	// same segments after reset
+	segmenter.reset();
+	segmenter.process(data.constData(), data.size());
+	segmenter.flush();
+	verifyUtterances(&segmenter);
+}
+
+void
+SpeechSegmenterTest::testChunked()
+{
+	SpeechSegmenter segmenter(WaveFormat(SAMPLE_RATE, 1, 16));
+	const QByteArray data = utterances();
+	for(int pos = 0; pos < data.size(); pos += 1234)
+		segmenter.process(data.constData() + pos, qMin(1234, int(data.size()) - pos));
+	segmenter.flush();
+	verifyUtterances(&segmenter);
+}
+
+void
+SpeechSegmenterTest::testMaxLength()
+{
+	SpeechSegmenter segmenter(WaveFormat(SAMPLE_RATE, 1, 16));
+	QByteArray data;
+	appendAudio(&data, 40000, 5000);
+	segmenter.process(data.constData(), data.size());
+	segmenter.flush();
+
+	SpeechSegmenter::Segment segment;
+	QVERIFY(segmenter.takeSegment(&segment));
+	QCOMPARE(segment.start, qint64(0));
+	QCOMPARE(int(segment.samples.size()), 3000 * FRAME * 2);
+	QVERIFY(segmenter.takeSegment(&segment));
+	QCOMPARE(segment.start, qint64(3000 * FRAME));
+	QCOMPARE(int(segment.samples.size()), 1000 * FRAME * 2);
+	QVERIFY(!segmenter.takeSegment(&segment));
+}
+
+void
+SpeechSegmenterTest::testNoise()
+{
+	SpeechSegmenter segmenter(WaveFormat(SAMPLE_RATE, 1, 16));
+	QByteArray data;
+	appendAudio(&data, 1000, 0);
+	appendAudio(&data, 50, 5000);
+	appendAudio(&data, 1000, 0);
+	segmenter.process(data.constData(), data.size());
+	segmenter.flush();
+
+	// too short to be speech
+	SpeechSegmenter::Segment segment;
+	QVERIFY(!segmenter.takeSegment(&segment));
+}
+
+QTEST_GUILESS_MAIN(SpeechSegmenterTest)
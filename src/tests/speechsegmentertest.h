@@ -0,0 +1,24 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef SPEECHSEGMENTERTEST_H
+#define SPEECHSEGMENTERTEST_H
+
+#include <QObject>
+
+class SpeechSegmenterTest : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void testSilence();
+	void testUtterances();
+	void testChunked();
+	void testMaxLength();
+	void testNoise();
+};
+
+#endif
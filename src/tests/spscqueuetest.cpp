@@ -0,0 +1,174 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "spscqueuetest.h"
+#include "helpers/spscqueue.h"
+
+#include <QByteArray>
+#include <QTest>                               // krazy:exclude=c++/includes
+#include <QThread>
+
+using namespace SubtitleComposer;
+
+#define THREADED_COUNT 200000
+
+void
+SPSCQueueTest::testPushPop()
+{
+	SPSCQueue<QByteArray, 4> queue;
+	QByteArray val;
+
+	QVERIFY(queue.isEmpty());
+	QVERIFY(!queue.pop(&val));
+
+	for(int i = 0; i < queue.capacity(); i++)
+		QVERIFY(queue.push(QByteArray::number(i)));
+	QCOMPARE(queue.size(), 4);
+
+	QByteArray overflow("overflow");
+	QVERIFY(!queue.push(std::move(overflow)));
+	QCOMPARE(overflow, QByteArray("overflow"));
+
+	for(int i = 0; i < queue.capacity(); i++) {
+		QVERIFY(queue.pop(&val));
+		QCOMPARE(val, QByteArray::number(i));
+	}
+	QVERIFY(queue.isEmpty());
+	QVERIFY(!queue.pop(&val));
+}
+
+void
+SPSCQueueTest::testWrapAround()
+{
+	SPSCQueue<int, 8> queue;
+	int val;
+
+	for(int i = 0; i < 1000; i++) {
+		QVERIFY(queue.push(int(i)));
+		QVERIFY(queue.push(int(-i)));
+		QVERIFY(queue.pop(&val));
+		QCOMPARE(val, i);
+		QVERIFY(queue.pop(&val));
+		QCOMPARE(val, -i);
+	}
+	QVERIFY(queue.isEmpty());
+}
+
+namespace {
+class Producer : public QThread
+{
+public:
+	explicit Producer(SPSCQueue<int, 64> *queue) : m_queue(queue) {}
+
+protected:
+	void run() override
+	{
+		for(int i = 0; i < THREADED_COUNT; i++) {
+			while(!m_queue->push(int(i)))
+				QThread::yieldCurrentThread();
+		}
+	}
+
+private:
+	SPSCQueue<int, 64> *m_queue;
+};
+
+class BlockingProducer : public QThread
+{
+public:
+	explicit BlockingProducer(SPSCQueue<int, 4> *queue, int count) : m_queue(queue), m_count(count), m_pushed(0) {}
+
+	inline int pushed() const { return m_pushed; }
+
+protected:
+	void run() override
+	{
+		for(int i = 0; i < m_count; i++) {
+			if(!m_queue->pushWait(int(i)))
+				return;
+			m_pushed++;
+		}
+		m_queue->close();
+	}
+
+private:
+	SPSCQueue<int, 4> *m_queue;
+	int m_count;
+	int m_pushed;
+};
+}
+
+void
+SPSCQueueTest::testThreaded()
+{
+	SPSCQueue<int, 64> queue;
+	Producer producer(&queue);
+	producer.start();
+
+	int expected = 0;
+	while(expected < THREADED_COUNT) {
+		int val;
+		if(!queue.pop(&val)) {
+			QThread::yieldCurrentThread();
+			continue;
+		}
+		if(val != expected)
+			break;
+		expected++;
+	}
+	producer.wait();
+
+	QCOMPARE(expected, THREADED_COUNT);
+	QVERIFY(queue.isEmpty());
+}
+
+void
+SPSCQueueTest::testBlocking()
+{
+	SPSCQueue<int, 4> queue;
+	BlockingProducer producer(&queue, THREADED_COUNT);
+	producer.start();
+
+	int expected = 0;
+	int val;
+	while(queue.popWait(&val)) {
+		if(val != expected)
+			break;
+		expected++;
+	}
+	producer.wait();
+
+	QCOMPARE(expected, THREADED_COUNT);
+	QVERIFY(queue.isEmpty());
+	QVERIFY(!queue.isInterrupted());
+}
+
+void
+SPSCQueueTest::testInterrupt()
+{
+	SPSCQueue<int, 4> queue;
+	BlockingProducer producer(&queue, 100);
+	producer.start();
+
+	// producer is stuck on full queue until interrupted
+	while(queue.size() < queue.capacity())
+		QThread::yieldCurrentThread();
+	queue.interrupt();
+	QVERIFY(producer.wait(5000));
+	QCOMPARE(producer.pushed(), queue.capacity());
+
+	int val;
+	QVERIFY(!queue.popWait(&val));
+
+	queue.reset();
+	QVERIFY(queue.isEmpty());
+	QVERIFY(!queue.isInterrupted());
+	QVERIFY(queue.push(42));
+	QVERIFY(queue.popWait(&val));
+	QCOMPARE(val, 42);
+}
+
+QTEST_GUILESS_MAIN(SPSCQueueTest);
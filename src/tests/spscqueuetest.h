@@ -0,0 +1,24 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef SPSCQUEUETEST_H
+#define SPSCQUEUETEST_H
+
+#include <QObject>
+
+class SPSCQueueTest : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void testPushPop();
+	void testWrapAround();
+	void testThreaded();
+	void testBlocking();
+	void testInterrupt();
+};
+
+#endif
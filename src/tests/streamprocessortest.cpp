@@ -0,0 +1,131 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "streamprocessortest.h"
+#include "streamprocessor/streamprocessor.h"
+
+#include <QAtomicInt>
+#include <QDataStream>
+#include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QTemporaryDir>
+#include <QTest>                               // krazy:exclude=c++/includes
+#include <QtMath>
+
+using namespace SubtitleComposer;
+
+#define SAMPLE_RATE 8000
+#define DURATION 20
+
+static bool
+writeWave(const QString &filename)
+{
+	QFile file(filename);
+	if(!file.open(QIODevice::WriteOnly))
+		return false;
+
+	const quint32 dataSize = SAMPLE_RATE * DURATION * sizeof(qint16);
+	QDataStream out(&file);
+	out.setByteOrder(QDataStream::LittleEndian);
+	out.writeRawData("RIFF", 4);
+	out << quint32(36 + dataSize);
+	out.writeRawData("WAVEfmt ", 8);
+	out << quint32(16) << quint16(1) << quint16(1) << quint32(SAMPLE_RATE) << quint32(SAMPLE_RATE * sizeof(qint16))
+		<< quint16(sizeof(qint16)) << quint16(16);
+	out.writeRawData("data", 4);
+	out << dataSize;
+	for(int i = 0; i < SAMPLE_RATE * DURATION; i++)
+		out << qint16(10000 * qSin(2. * M_PI * 440. * i / SAMPLE_RATE));
+	return out.status() == QDataStream::Ok;
+}
+
+namespace {
+struct Consumer {
+	const WaveFormat *format = nullptr;
+	QMutex mutex;
+	qint64 bytes = 0;
+	qint64 firstStart = -1;
+	// end of the previous buffer, data must continue there
+	qint64 end = 0;
+	bool contiguous = true;
+	QAtomicInt finished;
+
+	void receive(const qint32 size, const qint64 msecStart, const qint64 msecDuration)
+	{
+		QMutexLocker l(&mutex);
+		if(firstStart < 0)
+			firstStart = msecStart;
+		else if(qAbs(msecStart - end) > 1)
+			contiguous = false;
+		end = msecStart + msecDuration;
+		bytes += size;
+	}
+};
+}
+
+void
+StreamProcessorTest::testSlowConsumer()
+{
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+	const QString filename = dir.filePath(QStringLiteral("sine.wav"));
+	QVERIFY(writeWave(filename));
+
+	const WaveFormat format(SAMPLE_RATE, 1, 16);
+	Consumer slow;
+	Consumer fast;
+	StreamProcessor *stream = StreamProcessor::attachAudio(filename, 0, format, &slow.format);
+	QVERIFY(stream != nullptr);
+	QCOMPARE(StreamProcessor::attachAudio(filename, 0, format, &fast.format), stream);
+	QVERIFY(slow.format && fast.format && slow.format != fast.format);
+
+	// slow consumer has no room for data until it's resumed
+	QAtomicInt slowPaused;
+	connect(stream, &StreamProcessor::audioDataAvailable, [&](const void *, const qint32 size, const WaveFormat *waveFormat, const qint64 msecStart, const qint64 msecDuration){
+		if(waveFormat == fast.format) {
+			fast.receive(size, msecStart, msecDuration);
+		} else if(waveFormat == slow.format) {
+			if(slowPaused.testAndSetOrdered(0, 1))
+				stream->pauseAudioOutput(slow.format);
+			else
+				slow.receive(size, msecStart, msecDuration);
+		}
+	});
+	connect(stream, &StreamProcessor::audioOutputFinished, [&](const WaveFormat *waveFormat){
+		if(waveFormat == fast.format)
+			fast.finished.storeRelease(1);
+		else if(waveFormat == slow.format)
+			slow.finished.storeRelease(1);
+	});
+	QVERIFY(stream->start());
+
+	// other consumer gets the whole stream while the slow one is paused
+	QTRY_VERIFY_WITH_TIMEOUT(fast.finished.loadAcquire(), 10000);
+	QVERIFY(slowPaused.loadAcquire());
+	QVERIFY(!slow.finished.loadAcquire());
+	{
+		QMutexLocker l(&slow.mutex);
+		QCOMPARE(slow.bytes, qint64(0));
+	}
+	QCOMPARE(fast.firstStart, qint64(0));
+	QVERIFY(fast.contiguous);
+	QCOMPARE(fast.bytes, qint64(SAMPLE_RATE * DURATION * sizeof(qint16)));
+
+	// slow consumer gets all the data it missed, including the buffer it didn't take
+	stream->resumeAudioOutput(slow.format);
+	QTRY_VERIFY_WITH_TIMEOUT(slow.finished.loadAcquire(), 10000);
+	QMutexLocker l(&slow.mutex);
+	QCOMPARE(slow.firstStart, qint64(0));
+	QVERIFY(slow.contiguous);
+	QCOMPARE(slow.bytes, fast.bytes);
+	l.unlock();
+
+	StreamProcessor::detachAudio(stream, fast.format);
+	StreamProcessor::detachAudio(stream, slow.format);
+}
+
+QTEST_GUILESS_MAIN(StreamProcessorTest);
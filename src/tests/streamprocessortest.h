@@ -0,0 +1,20 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef STREAMPROCESSORTEST_H
+#define STREAMPROCESSORTEST_H
+
+#include <QObject>
+
+class StreamProcessorTest : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void testSlowConsumer();
+};
+
+#endif
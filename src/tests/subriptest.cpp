@@ -0,0 +1,161 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "subriptest.h"
+
+#include "core/richtext/richdocument.h"
+#include "core/subtitle.h"
+#include "formats/formatmanager.h"
+#include "formats/inputformat.h"
+#include "helpers/common.h"
+
+#include <QRegularExpression>
+#include <QTest>
+
+#include <klocalizedstring.h>
+
+using namespace SubtitleComposer;
+
+/**
+ * @brief Regular expression based SubRip parser that was used before the hand-written one,
+ * kept as reference for parse results and speed
+ */
+static bool
+parseReference(Subtitle &subtitle, const QString &data)
+{
+	staticRE$(reTime, "[\\d]+\n([0-2][0-9]):([0-5][0-9]):([0-5][0-9])[,\\.]([0-9]+) --> ([0-2][0-9]):([0-5][0-9]):([0-5][0-9])[,\\.]([0-9]+)\n", REu);
+
+	QRegularExpressionMatchIterator itTime = reTime.globalMatch(data);
+	if(!itTime.hasNext())
+		return false;
+
+	do {
+		QRegularExpressionMatch mTime = itTime.next();
+
+		Time showTime(mTime.captured(1).toInt(), mTime.captured(2).toInt(), mTime.captured(3).toInt(), mTime.captured(4).toInt());
+		Time hideTime(mTime.captured(5).toInt(), mTime.captured(6).toInt(), mTime.captured(7).toInt(), mTime.captured(8).toInt());
+
+		const int off = mTime.capturedEnd();
+		const QString text = data.mid(off, itTime.hasNext() ? itTime.peekNext().capturedStart() - off : -1).trimmed();
+
+		RichString stext;
+		stext.setRichString(text);
+
+		SubtitleLine *line = new SubtitleLine(showTime, hideTime);
+		line->primaryDoc()->setRichText(stext, true);
+		subtitle.insertLine(line);
+	} while(itTime.hasNext());
+
+	return true;
+}
+
+static QString
+generateSubRip(int cueCount)
+{
+	QString data;
+	for(int i = 0; i < cueCount; i++) {
+		const Time showTime(i * 2000.);
+		const Time hideTime(i * 2000. + 1500.);
+		data += QString::number(i + 1) % QChar::LineFeed
+			% showTime.toString().replace(QChar('.'), QChar(',')) % $(" --> ")
+			% hideTime.toString().replace(QChar('.'), QChar(',')) % QChar::LineFeed
+			% $("Line <i>number</i> ") % QString::number(i + 1) % $("\nsecond <b>row</b>\n\n");
+	}
+	return data;
+}
+
+SubRipTest::SubRipTest()
+{
+	KLocalizedString::setApplicationDomain("subtitlecomposer");
+}
+
+void
+SubRipTest::testParse_data()
+{
+	QTest::addColumn<QString>("data");
+
+	QTest::newRow("empty") << QString();
+	QTest::newRow("garbage") << $("hello\nworld\n");
+	QTest::newRow("simple")
+		<< $("1\n00:00:01,000 --> 00:00:02,500\nHello\n\n"
+			"2\n00:00:03,000 --> 00:00:04,000\nWorld\n");
+	QTest::newRow("dot millis")
+		<< $("1\n00:00:01.5 --> 00:00:02.25\nshort millis\n\n"
+			"2\n01:02:03.0004 --> 01:02:04.123\nlong millis\n");
+	QTest::newRow("overflowing millis")
+		<< $("1\n00:00:01,99999999999999999999999 --> 00:00:02,2147483648\nout of range\n\n"
+			"2\n00:00:03,00000000000000000000001 --> 00:00:04,2147483647\nleading zeros\n");
+	QTest::newRow("styled multiline")
+		<< $("1\n00:00:01,000 --> 00:00:02,000\n  <b>bold</b>\n<i>italic</i> &amp; <font color=\"#ff0000\">red</font>  \n\n\n"
+			"2\n00:00:03,000 --> 00:00:04,000\n\n\n");
+	QTest::newRow("leading garbage")
+		<< $("junk 12\nnot a cue\n"
+			"x3\n00:00:01,000 --> 00:00:02,000\ntext\n");
+	QTest::newRow("bad header")
+		<< $("1\n00:61:01,000 --> 00:00:02,000\nbad minutes\n"
+			"2\n0:00:01,000 --> 00:00:02,000\nbad hours\n"
+			"3\n00:00:01,000 -> 00:00:02,000\nbad arrow\n"
+			"4\n00:00:01, --> 00:00:02,000\nno millis\n"
+			"5\n00:00:05,000 --> 00:00:06,000\ngood\n");
+	QTest::newRow("truncated") << $("1\n00:00:01,000 --> 00:00:02,000\ntext\n\n2\n00:00:03,000 --> 00:00:0");
+	QTest::newRow("unordered")
+		<< $("2\n00:00:03,000 --> 00:00:04,000\nsecond\n\n"
+			"1\n00:00:01,000 --> 00:00:02,000\nfirst\n");
+	QTest::newRow("generated") << generateSubRip(100);
+}
+
+void
+SubRipTest::testParse()
+{
+	QFETCH(QString, data);
+
+	const InputFormat *format = FormatManager::instance().input($("SubRip"));
+	QVERIFY(format);
+
+	QExplicitlySharedDataPointer<Subtitle> expected(new Subtitle());
+	const bool expectedResult = parseReference(*expected, data);
+
+	QExplicitlySharedDataPointer<Subtitle> actual(new Subtitle());
+	QCOMPARE(format->readSubtitle(*actual, true, data), expectedResult);
+
+	QCOMPARE(actual->count(), expected->count());
+	for(int i = 0; i < expected->count(); i++) {
+		QCOMPARE(actual->at(i)->showTime().toMillis(), expected->at(i)->showTime().toMillis());
+		QCOMPARE(actual->at(i)->hideTime().toMillis(), expected->at(i)->hideTime().toMillis());
+		QCOMPARE(actual->at(i)->primaryDoc()->toRichText().richString(), expected->at(i)->primaryDoc()->toRichText().richString());
+	}
+}
+
+void
+SubRipTest::benchmarkParse_data()
+{
+	QTest::addColumn<bool>("reference");
+
+	QTest::newRow("scanner") << false;
+	QTest::newRow("regexp") << true;
+}
+
+void
+SubRipTest::benchmarkParse()
+{
+	QFETCH(bool, reference);
+
+	const InputFormat *format = FormatManager::instance().input($("SubRip"));
+	QVERIFY(format);
+
+	const QString data = generateSubRip(50000);
+
+	QBENCHMARK {
+		QExplicitlySharedDataPointer<Subtitle> subtitle(new Subtitle());
+		if(reference)
+			QVERIFY(parseReference(*subtitle, data));
+		else
+			QVERIFY(format->readSubtitle(*subtitle, true, data));
+		QCOMPARE(subtitle->count(), 50000);
+	}
+}
+
+QTEST_MAIN(SubRipTest);
@@ -0,0 +1,26 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef SUBRIPTEST_H
+#define SUBRIPTEST_H
+
+#include <QObject>
+
+class SubRipTest : public QObject
+{
+	Q_OBJECT
+
+public:
+	SubRipTest();
+
+private slots:
+	void testParse_data();
+	void testParse();
+	void benchmarkParse_data();
+	void benchmarkParse();
+};
+
+#endif // SUBRIPTEST_H
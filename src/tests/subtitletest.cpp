@@ -7,11 +7,17 @@
 #include "subtitletest.h"
 
 #include <QTest>
+#include <QUndoStack>
 
 #include "core/richtext/richdocument.h"
+#include "core/undo/subtitleactions.h"
+#include "helpers/common.h"
 
 #include <klocalizedstring.h>
 
+#include <algorithm>
+#include <numeric>
+
 using namespace SubtitleComposer;
 
 
@@ -59,4 +65,450 @@ SubtitleTest::testSort()
 		QVERIFY(qRound(sub->at(i)->showTime().toSeconds()) == i + 1);
 }
 
+void
+SubtitleTest::testSortLines_data()
+{
+	QTest::addColumn<QVector<int>>("times");
+
+	QTest::newRow("ordered")
+			<< (QVector<int>() << 1 << 2 << 3 << 4 << 5 << 6);
+	QTest::newRow("inverse")
+			<< (QVector<int>() << 6 << 5 << 4 << 3 << 2 << 1);
+	QTest::newRow("random")
+			<< (QVector<int>() << 3 << 4 << 1 << 2 << 6 << 5);
+	QTest::newRow("duplicates")
+			<< (QVector<int>() << 4 << 2 << 4 << 1 << 2 << 4);
+}
+
+void
+SubtitleTest::testSortLines()
+{
+	QFETCH(QVector<int>, times);
+
+	sub->removeLines(RangeList(Range::full()), SubtitleTarget::Both);
+
+	QList<SubtitleLine *> lines;
+	for(int i = 0; i < times.size(); i++) {
+		SubtitleLine *l = new SubtitleLine(i * 1000, i * 1000 + 500);
+		l->setPrimaryText(RichString(QString::number(i)));
+		lines.append(l);
+	}
+	sub->insertLines(lines);
+	// shifting doesn't reorder lines
+	for(int i = 0; i < times.size(); i++)
+		sub->at(i)->shiftTimes((times.at(i) - i) * 1000);
+
+	QList<SubtitleLine *> original;
+	for(int i = 0; i < sub->count(); i++)
+		original.append(sub->at(i));
+	QVector<int> order(times.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&](int a, int b){ return times.at(a) < times.at(b); });
+	QList<SubtitleLine *> sorted;
+	for(int i: order)
+		sorted.append(original.at(i));
+
+	const auto verifyOrder = [&](const QList<SubtitleLine *> &expected){
+		QCOMPARE(sub->count(), int(expected.size()));
+		for(int i = 0; i < sub->count(); i++) {
+			QCOMPARE(sub->at(i), expected.at(i));
+			QCOMPARE(sub->at(i)->index(), i);
+		}
+	};
+
+	// sort action restores the original order on undo
+	QUndoStack undoStack;
+	undoStack.push(new SortLinesAction(sub.data(), 0, order));
+	verifyOrder(sorted);
+	undoStack.undo();
+	verifyOrder(original);
+	undoStack.redo();
+	verifyOrder(sorted);
+	undoStack.undo();
+	verifyOrder(original);
+
+	sub->sortLines(Range::full());
+	verifyOrder(sorted);
+
+	QCOMPARE(sub->count(), int(times.size()));
+	for(int i = 0; i < sub->count(); i++) {
+		QCOMPARE(sub->at(i)->index(), i);
+		if(!i)
+			continue;
+		const SubtitleLine *prev = sub->at(i - 1);
+		const SubtitleLine *cur = sub->at(i);
+		QVERIFY(prev->showTime() <= cur->showTime());
+		if(prev->showTime() == cur->showTime()) // stable
+			QVERIFY(prev->primaryPlainText().toInt() < cur->primaryPlainText().toInt());
+	}
+}
+
+void
+SubtitleTest::testInsertLines_data()
+{
+	QTest::addColumn<QVector<int>>("existing");
+	QTest::addColumn<QVector<int>>("batch");
+
+	QTest::newRow("empty")
+			<< QVector<int>()
+			<< (QVector<int>() << 1 << 2 << 3 << 4);
+	QTest::newRow("append")
+			<< (QVector<int>() << 1 << 2)
+			<< (QVector<int>() << 3 << 4 << 5);
+	QTest::newRow("prepend")
+			<< (QVector<int>() << 5 << 6)
+			<< (QVector<int>() << 1 << 2 << 3);
+	QTest::newRow("interleaved")
+			<< (QVector<int>() << 2 << 5 << 8)
+			<< (QVector<int>() << 1 << 3 << 4 << 6 << 9 << 10);
+	QTest::newRow("unsorted batch")
+			<< (QVector<int>() << 4)
+			<< (QVector<int>() << 6 << 1 << 5 << 2 << 3);
+}
+
+void
+SubtitleTest::testInsertLines()
+{
+	QFETCH(QVector<int>, existing);
+	QFETCH(QVector<int>, batch);
+
+	sub->removeLines(RangeList(Range::full()), SubtitleTarget::Both);
+
+	for(int n: existing)
+		sub->insertLine(new SubtitleLine(n * 1000, n * 1000 + 500));
+
+	QList<SubtitleLine *> lines;
+	for(int n: batch)
+		lines.append(new SubtitleLine(n * 1000, n * 1000 + 500));
+	sub->insertLines(lines);
+
+	QCOMPARE(sub->count(), int(existing.size() + batch.size()));
+	for(int i = 0; i < sub->count(); i++) {
+		QCOMPARE(sub->at(i)->index(), i);
+		if(i)
+			QVERIFY(sub->at(i - 1)->showTime() <= sub->at(i)->showTime());
+	}
+}
+
+void
+SubtitleTest::testLazyText()
+{
+	const QString text = QStringLiteral("first\nsecond");
+
+	sub->removeLines(RangeList(Range::full()), SubtitleTarget::Both);
+
+	SubtitleLine *line = new SubtitleLine(1000, 2000);
+	line->setPrimaryText(RichString(text, RichString::Italic));
+	QCOMPARE(line->primaryPlainText(), text);
+	QCOMPARE(line->primaryLines(), 2);
+	QCOMPARE(line->secondaryPlainText(), QString());
+	sub->insertLine(line);
+
+	QCOMPARE(line->primaryDoc()->toPlainText(), text);
+	QCOMPARE(line->primaryDoc()->cummulativeStyleFlags(), int(RichString::Italic));
+
+	const quint64 cacheKey = line->primaryDoc()->cacheKey();
+	QVERIFY(line->releaseDocs());
+	QVERIFY(!line->releaseDocs());
+	QCOMPARE(line->primaryPlainText(), text);
+	QCOMPARE(line->primaryText().richString(), RichString(text, RichString::Italic).richString());
+
+	// recreated document with the same text keeps the cache key
+	QCOMPARE(line->primaryDoc()->cacheKey(), cacheKey);
+	QVERIFY(line->releaseDocs());
+
+	// loading data from another subtitle must not create documents
+	QExplicitlySharedDataPointer<Subtitle> loaded(new Subtitle);
+	QList<SubtitleLine *> loadedLines;
+	for(int i = 0; i < 3; i++) {
+		SubtitleLine *ln = new SubtitleLine(i * 1000, i * 1000 + 500);
+		ln->setPrimaryText(RichString(QStringLiteral("primary %1").arg(i)));
+		ln->setSecondaryText(RichString(QStringLiteral("secondary %1").arg(i)));
+		loadedLines.append(ln);
+	}
+	loaded->insertLines(loadedLines);
+
+	sub->setPrimaryData(*loaded, true);
+	sub->setSecondaryData(*loaded, false);
+	QCOMPARE(sub->count(), 3);
+	for(int i = 0; i < sub->count(); i++) {
+		const SubtitleLine *ln = sub->at(i);
+		QVERIFY(ln->findChildren<RichDocument *>().isEmpty());
+		QCOMPARE(ln->primaryPlainText(), QStringLiteral("primary %1").arg(i));
+		QCOMPARE(ln->secondaryPlainText(), QStringLiteral("secondary %1").arg(i));
+	}
+	for(int i = 0; i < loaded->count(); i++)
+		QVERIFY(loaded->at(i)->findChildren<RichDocument *>().isEmpty());
+}
+
+void
+SubtitleTest::testLinesInTimespan()
+{
+	sub->removeLines(RangeList(Range::full()), SubtitleTarget::Both);
+
+	QList<SubtitleLine *> lines;
+	for(int i = 0; i < 200; i++) {
+		// every 10th line is long and overlaps following lines
+		const int duration = i % 10 ? 500 : 4500;
+		lines.append(new SubtitleLine(i * 1000, i * 1000 + duration));
+	}
+	sub->insertLines(lines);
+
+	const auto verify = [&](){
+		for(int t = -2000; t < 202000; t += 750) {
+			const Time start(t), end(t + 1200);
+			QList<SubtitleLine *> expected;
+			for(int i = 0; i < sub->count(); i++) {
+				if(sub->at(i)->intersectsTimespan(start, end))
+					expected.append(sub->at(i));
+			}
+			QCOMPARE(sub->linesInTimespan(start, end), expected);
+
+			SubtitleLine *expectedLine = nullptr;
+			for(int i = 0; i < sub->count() && !expectedLine; i++) {
+				if(sub->at(i)->containsTime(start))
+					expectedLine = sub->at(i);
+			}
+			QCOMPARE(sub->lineAt(start), expectedLine);
+		}
+	};
+
+	verify();
+
+	sub->at(55)->setHideTime(70000);
+	sub->at(3)->setHideTime(3100);
+	verify();
+
+	sub->removeLines(RangeList(Range(0, 20)), SubtitleTarget::Both);
+	verify();
+
+	// shifted lines overlap following lines and are out of show time order
+	sub->shiftLines(RangeList(Range(10, 29)), 25000);
+	QVERIFY(sub->at(29)->showTime() > sub->at(30)->showTime());
+	verify();
+
+	sub->at(100)->setHideTime(150000);
+	verify();
+
+	sub->sortLines(Range::full());
+	QVERIFY(sub->at(29)->showTime() <= sub->at(30)->showTime());
+	QVERIFY(sub->isShowTimeSorted());
+	verify();
+
+	// editing a time keeps lookups sorted without rescanning the lines
+	SubtitleLine *edited = sub->at(154);
+	QCOMPARE(edited->showTime(), Time(175000));
+	edited->setShowTime(edited->showTime() + 200);
+	QVERIFY(sub->m_showTimeOrderValid);
+	QVERIFY(sub->isShowTimeSorted());
+	QCOMPARE(sub->lineAt(edited->showTime() + 10), edited);
+	verify();
+
+	// moved by a new show time
+	edited->setShowTime(Time(156600));
+	QVERIFY(sub->m_showTimeOrderValid);
+	QVERIFY(sub->isShowTimeSorted());
+	QCOMPARE(sub->lineAt(Time(156700)), edited);
+	verify();
+
+	// times changed without reordering are found out of order and fixed again
+	const Time showTime = sub->at(10)->showTime();
+	QCOMPARE(showTime, Time(51000));
+	sub->shiftLines(RangeList(Range(10)), 5000);
+	QVERIFY(sub->m_showTimeOrderValid);
+	QVERIFY(!sub->isShowTimeSorted());
+	QCOMPARE(sub->lineAt(showTime + 5010), sub->at(10));
+	verify();
+	sub->shiftLines(RangeList(Range(10)), -5000);
+	QVERIFY(sub->isShowTimeSorted());
+	verify();
+}
+
+void
+SubtitleTest::testShiftLines()
+{
+	sub->removeLines(RangeList(Range::full()), SubtitleTarget::Both);
+
+	QList<SubtitleLine *> lines;
+	for(int i = 0; i < 20; i++)
+		lines.append(new SubtitleLine(i * 1000, i * 1000 + 500));
+	sub->insertLines(lines);
+
+	const auto verifyShifted = [&](){
+		// times are clamped at zero
+		for(int i = 0; i < 10; i++) {
+			QCOMPARE(sub->at(i)->showTime(), Time(qMax(0, i * 1000 - 5000)));
+			QCOMPARE(sub->at(i)->hideTime(), Time(qMax(0, i * 1000 - 4500)));
+		}
+		for(int i = 10; i < 20; i++)
+			QCOMPARE(sub->at(i)->showTime(), Time(i * 1000));
+		QCOMPARE(sub->lineAt(Time(4200)), sub->at(9));
+	};
+	const auto verifyOriginal = [&](){
+		for(int i = 0; i < 20; i++) {
+			QCOMPARE(sub->at(i)->showTime(), Time(i * 1000));
+			QCOMPARE(sub->at(i)->hideTime(), Time(i * 1000 + 500));
+		}
+		QCOMPARE(sub->lineAt(Time(4200)), sub->at(4));
+	};
+
+	// undo restores the times of lines that were clamped at zero too
+	QUndoStack undoStack;
+	undoStack.push(new AdjustLinesTimesAction(sub.data(), RangeList(Range(0, 9)), -5000., 1., QString()));
+	verifyShifted();
+	undoStack.undo();
+	verifyOriginal();
+	undoStack.redo();
+	verifyShifted();
+	undoStack.undo();
+	verifyOriginal();
+
+	sub->shiftLines(RangeList(Range(0, 9)), -5000);
+	verifyShifted();
+
+	// line 0 is the first time and line 19 the last time reference
+	sub->adjustLines(Range::full(), 1000, 39000);
+	QCOMPARE(sub->at(0)->showTime(), Time(1000));
+	QCOMPARE(sub->at(19)->showTime(), Time(39000));
+	QCOMPARE(sub->lineAt(Time(39100)), sub->at(19));
+	QCOMPARE(sub->lineAt(Time(19100)), nullptr);
+}
+
+void
+SubtitleTest::testSnapTimes()
+{
+	sub->removeLines(RangeList(Range::full()), SubtitleTarget::Both);
+
+	QList<SubtitleLine *> lines;
+	lines.append(new SubtitleLine(1000, 1900));
+	lines.append(new SubtitleLine(3100, 3400));
+	lines.append(new SubtitleLine(8000, 9000));
+	sub->insertLines(lines);
+
+	const QVector<double> onsets({ 990., 2990., 3300. });
+	const QVector<double> offsets({ 2010., 3310., 3510. });
+
+	sub->snapTimes(RangeList(Range(1)), onsets, offsets, 500);
+	QCOMPARE(sub->at(0)->showTime(), Time(1000));
+	QCOMPARE(sub->at(1)->showTime(), Time(2990));
+	QCOMPARE(sub->at(1)->hideTime(), Time(3310));
+
+	// lines out of reach of any boundary are left alone
+	sub->snapTimes(RangeList(Range::full()), onsets, offsets, 200);
+	QCOMPARE(sub->at(0)->showTime(), Time(990));
+	QCOMPARE(sub->at(0)->hideTime(), Time(2010));
+	QCOMPARE(sub->at(2)->showTime(), Time(8000));
+	QCOMPARE(sub->at(2)->hideTime(), Time(9000));
+
+	// line isn't collapsed onto a single boundary
+	sub->at(2)->setTimes(3250, 3290);
+	sub->snapTimes(RangeList(Range(2)), QVector<double>({ 3300. }), QVector<double>({ 3290. }), 100);
+	QCOMPARE(sub->at(2)->showTime(), Time(3250));
+	QCOMPARE(sub->at(2)->hideTime(), Time(3290));
+
+	// snapping is a single undo step that restores all times
+	QUndoStack undoStack;
+	sub->setUndoStack(&undoStack);
+	sub->snapTimes(RangeList(Range::full()), QVector<double>({ 1000., 2900., 3240. }), QVector<double>({ 2000., 3300., 3350. }), 100);
+	sub->setUndoStack(nullptr);
+	QCOMPARE(undoStack.count(), 1);
+	const auto verifyTimes = [&](const QVector<int> &times){
+		for(int i = 0; i < sub->count(); i++) {
+			QCOMPARE(sub->at(i)->showTime(), Time(times.at(i * 2)));
+			QCOMPARE(sub->at(i)->hideTime(), Time(times.at(i * 2 + 1)));
+		}
+	};
+	verifyTimes({ 1000, 2000, 2900, 3300, 3240, 3300 });
+	undoStack.undo();
+	verifyTimes({ 990, 2010, 2990, 3310, 3250, 3290 });
+	undoStack.redo();
+	verifyTimes({ 1000, 2000, 2900, 3300, 3240, 3300 });
+}
+
+void
+SubtitleTest::testTextStats()
+{
+	sub->removeLines(RangeList(Range::full()), SubtitleTarget::Both);
+
+	SubtitleLine *line = new SubtitleLine(1000, 2000);
+	line->setPrimaryText(RichString($(" Hello  there\n\n  general\tKenobi ")));
+	line->setSecondaryText(RichString($("Hi!")));
+	sub->insertLine(line);
+
+	const SubtitleLine::TextStats &stats = line->primaryStats();
+	QCOMPARE(stats.length, 32);
+	QCOMPARE(stats.characters, line->primaryPlainText().simplified().length());
+	QCOMPARE(stats.words, 4);
+	QCOMPARE(stats.lines, 2);
+	QCOMPARE(stats.maxLineCharacters, 14);
+	QVERIFY(stats.unneededSpaces);
+	QVERIFY(!line->secondaryStats().unneededSpaces);
+
+	// document edits and text swaps are picked up
+	line->primaryDoc()->setPlainText($("General Kenobi"));
+	QCOMPARE(line->primaryWords(), 2);
+	QCOMPARE(line->primaryLines(), 1);
+	QVERIFY(!line->checkPrimaryUnneededSpaces(false));
+
+	sub->swapTexts(Range::full());
+	QCOMPARE(line->primaryCharacters(), 3);
+	QCOMPARE(line->secondaryCharacters(), 14);
+
+	line->setSecondaryText(RichString());
+	QVERIFY(line->checkEmptySecondaryText(false));
+	QCOMPARE(line->secondaryStats().maxLineCharacters, 0);
+
+	// regexp checks run only when their errors are checked
+	line->setPrimaryText(RichString($("- Lonely dash")));
+	QVERIFY(!line->primaryStats().textChecked);
+	QVERIFY(line->checkPrimaryUnneededDash(false));
+	QVERIFY(!line->checkPrimaryCapitalAfterEllipsis(false));
+	QVERIFY(line->primaryStats().textChecked);
+	line->primaryDoc()->setPlainText($("...Capital"));
+	QVERIFY(!line->primaryStats().textChecked);
+	QVERIFY(!line->checkPrimaryUnneededDash(false));
+	QVERIFY(line->checkPrimaryCapitalAfterEllipsis(false));
+}
+
+void
+SubtitleTest::testCheckErrors()
+{
+	sub->removeLines(RangeList(Range::full()), SubtitleTarget::Both);
+
+	// enough lines to be checked in parallel
+	const QStringList texts({ $("Fine text."), $("Too  many spaces"), $("...Capital"), $("- Lonely dash"), QString() });
+	QList<SubtitleLine *> lines;
+	for(int i = 0; i < 1000; i++) {
+		SubtitleLine *line = new SubtitleLine(i * 1000, i * 1000 + 900);
+		line->setPrimaryText(RichString(texts.at(i % texts.size())));
+		line->setSecondaryText(RichString($("Translation")));
+		lines.append(line);
+	}
+	sub->insertLines(lines);
+
+	const int checkFlags = SubtitleLine::EmptyPrimaryText | SubtitleLine::PrimaryUnneededSpaces
+		| SubtitleLine::PrimaryCapitalAfterEllipsis | SubtitleLine::PrimaryUnneededDash;
+	const int expected[] = { 0, SubtitleLine::PrimaryUnneededSpaces, SubtitleLine::PrimaryCapitalAfterEllipsis,
+		SubtitleLine::PrimaryUnneededDash, SubtitleLine::EmptyPrimaryText };
+
+	sub->checkErrors(Range::full(), checkFlags);
+	for(int i = 0; i < sub->count(); i++)
+		QCOMPARE(sub->at(i)->errorFlags(), expected[i % texts.size()]);
+
+	// edited documents are checked again
+	sub->at(0)->primaryDoc()->setPlainText($("Now  broken"));
+	sub->at(1)->primaryDoc()->setPlainText($("Now fixed"));
+	sub->checkErrors(Range(0, 1), checkFlags);
+	QCOMPARE(sub->at(0)->errorFlags(), int(SubtitleLine::PrimaryUnneededSpaces));
+	QCOMPARE(sub->at(1)->errorFlags(), 0);
+
+	// only errors that were found before are checked
+	sub->at(5)->primaryDoc()->setPlainText($("Now  broken"));
+	sub->at(6)->primaryDoc()->setPlainText($("Now fixed"));
+	sub->recheckErrors(Range::full());
+	QCOMPARE(sub->at(5)->errorFlags(), 0);
+	QCOMPARE(sub->at(6)->errorFlags(), 0);
+	QCOMPARE(sub->at(7)->errorFlags(), int(SubtitleLine::PrimaryCapitalAfterEllipsis));
+}
+
 QTEST_MAIN(SubtitleTest);
@@ -22,6 +22,16 @@ public:
 private slots:
 	void testSort_data();
 	void testSort();
+	void testSortLines_data();
+	void testSortLines();
+	void testInsertLines_data();
+	void testInsertLines();
+	void testLazyText();
+	void testLinesInTimespan();
+	void testShiftLines();
+	void testSnapTimes();
+	void testTextStats();
+	void testCheckErrors();
 
 private:
 	QExplicitlySharedDataPointer<SubtitleComposer::Subtitle> sub;
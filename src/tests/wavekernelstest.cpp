@@ -0,0 +1,200 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "wavekernelstest.h"
+#include "gui/waveform/wavekernels.h"
+
+#include <QRandomGenerator>
+#include <QTest>                               // krazy:exclude=c++/includes
+#include <QVector>
+
+using namespace SubtitleComposer;
+
+static QVector<SAMPLE_TYPE>
+randomSamples(int count)
+{
+	QRandomGenerator rng(1234);
+	QVector<SAMPLE_TYPE> samples(count);
+	for(SAMPLE_TYPE &s : samples)
+		s = SAMPLE_TYPE(rng.bounded(SAMPLE_MIN, SAMPLE_MAX + 1));
+	return samples;
+}
+
+// previous scalar implementation from WaveBuffer::onStreamData()
+static void
+decimateScalar(const SAMPLE_TYPE *sample, quint32 frames, quint16 channels, quint8 shift, SAMPLE_TYPE * const *out, bool exact)
+{
+	const quint32 frameSize = (1 << shift) * channels;
+	QVector<qint32> val(channels);
+	for(quint32 f = 0; f < frames; f++) {
+		quint32 c = 0;
+		for(; c < channels; c++)
+			val[c] = *sample++;
+		for(; c < frameSize; c++)
+			val[c % channels] += *sample++;
+		for(c = 0; c < channels; c++)
+			out[c][f] = exact ? WaveKernels::scaleSampleExact(val[c] >> shift) : WaveKernels::scaleSample(val[c] >> shift);
+	}
+}
+
+void
+WaveKernelsTest::testScaleSample()
+{
+	for(qint32 s = SAMPLE_MIN; s <= SAMPLE_MAX; s++) {
+		const qint32 exact = WaveKernels::scaleSampleExact(s);
+		const qint32 lut = WaveKernels::scaleSample(s);
+		// within 1% or a single step of rounding near zero
+		if(qAbs(exact - lut) > qMax(1, exact / 100))
+			QFAIL(qPrintable(QStringLiteral("sample %1: expected %2, got %3").arg(s).arg(exact).arg(lut)));
+	}
+	QCOMPARE(WaveKernels::scaleSample(0), SAMPLE_TYPE(0));
+	QCOMPARE(WaveKernels::scaleSample(SAMPLE_MIN), SAMPLE_TYPE(0));
+	QCOMPARE(WaveKernels::scaleSample(SAMPLE_MAX), WaveKernels::scaleSampleExact(SAMPLE_MAX));
+	// steep start of the curve is looked up exactly
+	for(qint32 s = 0; s < SCALE_LUT_EXACT_STEPS << WaveKernels::scaleLutShift(); s++)
+		QCOMPARE(WaveKernels::scaleSample(s), WaveKernels::scaleSampleExact(s));
+}
+
+void
+WaveKernelsTest::testDecimate_data()
+{
+	QTest::addColumn<int>("channels");
+	QTest::addColumn<int>("shift");
+
+	QTest::newRow("mono") << 1 << 4;
+	QTest::newRow("stereo") << 2 << 4;
+	QTest::newRow("3ch") << 3 << 3;
+	QTest::newRow("5.1") << 6 << 4;
+	QTest::newRow("stereo-noshift") << 2 << 0;
+}
+
+void
+WaveKernelsTest::testDecimate()
+{
+	QFETCH(int, channels);
+	QFETCH(int, shift);
+
+	const quint32 frames = 1000;
+	const QVector<SAMPLE_TYPE> in = randomSamples(frames * channels << shift);
+
+	QVector<QVector<SAMPLE_TYPE>> expected(channels, QVector<SAMPLE_TYPE>(frames));
+	QVector<QVector<SAMPLE_TYPE>> actual(channels, QVector<SAMPLE_TYPE>(frames + 10));
+	QVector<SAMPLE_TYPE *> expectedPtr, actualPtr;
+	for(int c = 0; c < channels; c++) {
+		expectedPtr.append(expected[c].data());
+		actualPtr.append(actual[c].data());
+	}
+
+	decimateScalar(in.constData(), frames, channels, shift, expectedPtr.data(), false);
+	WaveKernels::decimate(in.constData(), frames, channels, shift, actualPtr.data(), 10);
+
+	for(int c = 0; c < channels; c++)
+		QCOMPARE(actual[c].mid(10), expected[c]);
+}
+
+void
+WaveKernelsTest::testAmplitudeSumMax()
+{
+	const QVector<SAMPLE_TYPE> in = randomSamples(1003);
+
+	quint64 expectedSum = 0;
+	quint32 expectedMax = 0;
+	for(SAMPLE_TYPE s : in) {
+		const quint32 val = qAbs(qint32(s) - SAMPLE_MIN - (SAMPLE_MAX - SAMPLE_MIN) / 2);
+		expectedSum += val;
+		expectedMax = qMax(expectedMax, val);
+	}
+
+	quint64 sum = 0;
+	quint32 max = 0;
+	WaveKernels::amplitudeSumMax(in.constData(), in.size(), &sum, &max);
+	QCOMPARE(sum, expectedSum);
+	QCOMPARE(max, expectedMax);
+}
+
+void
+WaveKernelsTest::testReduceZoomLevel_data()
+{
+	QTest::addColumn<quint32>("samplesPerPixel");
+	QTest::addColumn<quint32>("processed");
+
+	QTest::newRow("below first level") << 5U << 10037U;
+	QTest::newRow("first level") << 8U << 10037U;
+	QTest::newRow("unaligned") << 11U << 10037U;
+	QTest::newRow("coarse") << 100U << 10037U;
+	QTest::newRow("coarser") << 1000U << 10037U;
+	QTest::newRow("partially processed") << 100U << 6003U;
+}
+
+void
+WaveKernelsTest::testReduceZoomLevel()
+{
+	QFETCH(quint32, samplesPerPixel);
+	QFETCH(quint32, processed);
+
+	const QVector<SAMPLE_TYPE> in = randomSamples(10037);
+
+	// coarsest level not larger than a pixel, first level has 8 samples per entry like in ZoomBuffer
+	quint8 shift = 3;
+	while((2U << shift) <= samplesPerPixel)
+		shift++;
+	QVector<WaveZoomData> level;
+	if((1U << shift) <= samplesPerPixel) {
+		for(quint32 i = 0; i < processed >> shift; i++) {
+			quint64 sum = 0;
+			quint32 max = 0;
+			WaveKernels::amplitudeSumMax(in.constData() + (i << shift), 1U << shift, &sum, &max);
+			level.push_back(WaveZoomData{quint32(sum >> shift), max});
+		}
+	}
+
+	// last pixel is partial
+	for(quint32 start = 0; start < quint32(in.size()); start += samplesPerPixel) {
+		const quint32 end = qMin(start + samplesPerPixel, quint32(in.size()));
+		quint64 expectedSum = 0;
+		quint32 expectedMax = 0;
+		WaveKernels::amplitudeSumMax(in.constData() + start, end - start, &expectedSum, &expectedMax);
+
+		const WaveZoomData zoomed = WaveKernels::reduceZoomLevel(in.constData(), level.isEmpty() ? nullptr : level.constData(),
+			shift, level.size(), start, end);
+		QCOMPARE(zoomed.max, expectedMax);
+		// level entries hold rounded down averages
+		QVERIFY(qAbs(qint64(zoomed.min) - qint64(expectedSum / (end - start))) <= 1);
+	}
+}
+
+void
+WaveKernelsTest::benchmarkDecimate_data()
+{
+	QTest::addColumn<bool>("scalar");
+
+	QTest::newRow("scalar") << true;
+	QTest::newRow("kernel") << false;
+}
+
+void
+WaveKernelsTest::benchmarkDecimate()
+{
+	QFETCH(bool, scalar);
+
+	// ten minutes of 48kHz stereo decimated to 3kHz
+	const quint16 channels = 2;
+	const quint8 shift = 4;
+	const quint32 frames = 3000 * 600;
+	const QVector<SAMPLE_TYPE> in = randomSamples(frames * channels << shift);
+
+	QVector<QVector<SAMPLE_TYPE>> out(channels, QVector<SAMPLE_TYPE>(frames));
+	SAMPLE_TYPE *outPtr[channels] = { out[0].data(), out[1].data() };
+
+	QBENCHMARK {
+		if(scalar)
+			decimateScalar(in.constData(), frames, channels, shift, outPtr, true);
+		else
+			WaveKernels::decimate(in.constData(), frames, channels, shift, outPtr, 0);
+	}
+}
+
+QTEST_GUILESS_MAIN(WaveKernelsTest);
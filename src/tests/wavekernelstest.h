@@ -0,0 +1,27 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef WAVEKERNELSTEST_H
+#define WAVEKERNELSTEST_H
+
+#include <QObject>
+
+class WaveKernelsTest : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void testScaleSample();
+	void testDecimate_data();
+	void testDecimate();
+	void testAmplitudeSumMax();
+	void testReduceZoomLevel_data();
+	void testReduceZoomLevel();
+	void benchmarkDecimate_data();
+	void benchmarkDecimate();
+};
+
+#endif
@@ -0,0 +1,123 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "wavespeechboundariestest.h"
+#include "gui/waveform/wavespeechboundaries.h"
+
+#include <QTest>                               // krazy:exclude=c++/includes
+#include <QVector>
+
+using namespace SubtitleComposer;
+
+#define SAMPLE_RATE 3000
+#define NOISE 100
+#define SPEECH 20000
+
+static void
+appendWave(QVector<SAMPLE_TYPE> *wave, int msec, SAMPLE_TYPE level)
+{
+	wave->insert(wave->size(), msec * SAMPLE_RATE / 1000, level);
+}
+
+static QVector<SAMPLE_TYPE>
+dialog()
+{
+	QVector<SAMPLE_TYPE> wave;
+	appendWave(&wave, 1000, NOISE);
+	appendWave(&wave, 1000, SPEECH);
+	appendWave(&wave, 1000, NOISE);
+	appendWave(&wave, 200, SPEECH);
+	appendWave(&wave, 80, NOISE); // short pause inside the speech
+	appendWave(&wave, 220, SPEECH);
+	appendWave(&wave, 1500, NOISE);
+	appendWave(&wave, 30, SPEECH); // click
+	appendWave(&wave, 970, NOISE);
+	return wave;
+}
+
+static void
+verifyDialog(const WaveSpeechBoundaries &boundaries)
+{
+	// RMS window stretches speech by a frame on each side
+	QCOMPARE(boundaries.onsets(), QVector<double>({ 990., 2990. }));
+	QCOMPARE(boundaries.offsets(), QVector<double>({ 2010., 3510. }));
+}
+
+void
+WaveSpeechBoundariesTest::testSilence()
+{
+	WaveSpeechBoundaries boundaries;
+
+	QVector<SAMPLE_TYPE> wave;
+	appendWave(&wave, 5000, 0);
+	const SAMPLE_TYPE *channels[] = { wave.constData() };
+	boundaries.analyze(channels, 1, wave.size(), SAMPLE_RATE);
+	QVERIFY(boundaries.onsets().isEmpty());
+	QVERIFY(boundaries.offsets().isEmpty());
+
+	wave.fill(NOISE);
+	boundaries.analyze(channels, 1, wave.size(), SAMPLE_RATE);
+	QVERIFY(boundaries.onsets().isEmpty());
+
+	boundaries.analyze(channels, 1, 0, SAMPLE_RATE);
+	QVERIFY(boundaries.onsets().isEmpty());
+}
+
+void
+WaveSpeechBoundariesTest::testBoundaries()
+{
+	const QVector<SAMPLE_TYPE> wave = dialog();
+	const SAMPLE_TYPE *channels[] = { wave.constData() };
+
+	WaveSpeechBoundaries boundaries;
+	boundaries.analyze(channels, 1, wave.size(), SAMPLE_RATE);
+	verifyDialog(boundaries);
+}
+
+void
+WaveSpeechBoundariesTest::testChannels()
+{
+	const QVector<SAMPLE_TYPE> wave = dialog();
+	QVector<SAMPLE_TYPE> noise;
+	appendWave(&noise, wave.size() * 1000 / SAMPLE_RATE, NOISE);
+	const SAMPLE_TYPE *channels[] = { noise.constData(), wave.constData() };
+
+	WaveSpeechBoundaries boundaries;
+	boundaries.analyze(channels, 2, wave.size(), SAMPLE_RATE);
+	verifyDialog(boundaries);
+}
+
+void
+WaveSpeechBoundariesTest::testPartial()
+{
+	const QVector<SAMPLE_TYPE> wave = dialog();
+	const SAMPLE_TYPE *channels[] = { wave.constData() };
+
+	// speech that is still going on ends with the decoded samples
+	WaveSpeechBoundaries boundaries;
+	boundaries.analyze(channels, 1, 1500 * SAMPLE_RATE / 1000, SAMPLE_RATE);
+	QCOMPARE(boundaries.onsets(), QVector<double>({ 990. }));
+	QCOMPARE(boundaries.offsets(), QVector<double>({ 1500. }));
+}
+
+void
+WaveSpeechBoundariesTest::benchmarkAnalyze()
+{
+	// one hour episode
+	QVector<SAMPLE_TYPE> wave;
+	const QVector<SAMPLE_TYPE> part = dialog();
+	while(wave.size() < 3600 * SAMPLE_RATE)
+		wave.append(part);
+	const SAMPLE_TYPE *channels[] = { wave.constData(), wave.constData() };
+
+	WaveSpeechBoundaries boundaries;
+	QBENCHMARK {
+		boundaries.analyze(channels, 2, wave.size(), SAMPLE_RATE);
+	}
+	QCOMPARE(boundaries.onsets().size(), 2 * wave.size() / part.size());
+}
+
+QTEST_GUILESS_MAIN(WaveSpeechBoundariesTest);
@@ -0,0 +1,24 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef WAVESPEECHBOUNDARIESTEST_H
+#define WAVESPEECHBOUNDARIESTEST_H
+
+#include <QObject>
+
+class WaveSpeechBoundariesTest : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void testSilence();
+	void testBoundaries();
+	void testChannels();
+	void testPartial();
+	void benchmarkAnalyze();
+};
+
+#endif